@@ -0,0 +1,79 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <memory>
+
+#include "g2o/core/block_solver.h"
+#include "g2o/core/optimization_algorithm_gauss_newton.h"
+#include "g2o/core/sparse_optimizer.h"
+#include "g2o/solvers/eigen/linear_solver_eigen.h"
+#include "g2o/types/slam3d/edge_se3.h"
+#include "g2o/types/slam3d/vertex_se3.h"
+
+// Compare the construction of the quadratic form in BlockSolver::buildSystem()
+// with locking each vertex against the edge coloring which processes edges
+// without a common vertex in parallel.
+
+namespace {
+
+using BlockSolver = g2o::BlockSolver<g2o::BlockSolverTraits<6, 6>>;
+using LinearSolver = g2o::LinearSolverEigen<BlockSolver::PoseMatrixType>;
+
+/**
+ * Pose graph of a trajectory in which every tenth pose is observed from one of
+ * a few hub poses, resulting in vertices of high degree.
+ */
+void createHubGraph(g2o::SparseOptimizer& optimizer, int numPoses,
+                    int numHubs) {
+  for (int i = 0; i < numPoses; ++i) {
+    auto v = std::make_shared<g2o::VertexSE3>();
+    v->setId(i);
+    g2o::Isometry3 pose = g2o::Isometry3::Identity();
+    pose.translation() << i, std::sin(0.1 * i), 0.;
+    v->setEstimate(pose);
+    v->setFixed(i == 0);
+    optimizer.addVertex(v);
+  }
+  auto addEdge = [&optimizer](int from, int to) {
+    auto e = std::make_shared<g2o::EdgeSE3>();
+    g2o::Isometry3 measurement = g2o::Isometry3::Identity();
+    measurement.translation() << to - from, 0., 0.;
+    e->setMeasurement(measurement);
+    e->setInformation(g2o::EdgeSE3::InformationType::Identity());
+    e->vertices()[0] = optimizer.vertex(from);
+    e->vertices()[1] = optimizer.vertex(to);
+    optimizer.addEdge(e);
+  };
+  for (int i = 1; i < numPoses; ++i) addEdge(i - 1, i);
+  for (int i = numHubs + 10; i < numPoses; i += 10) addEdge(i % numHubs, i);
+}
+
+void BM_BuildSystem(benchmark::State& state) {
+  g2o::SparseOptimizer optimizer;
+  auto blockSolver =
+      g2o::make_unique<BlockSolver>(g2o::make_unique<LinearSolver>());
+  BlockSolver* solver = blockSolver.get();
+  solver->setEdgeColoring(state.range(0) != 0);
+  optimizer.setAlgorithm(
+      g2o::make_unique<g2o::OptimizationAlgorithmGaussNewton>(
+          std::move(blockSolver)));
+  createHubGraph(optimizer, state.range(1), 4);
+
+  optimizer.initializeOptimization();
+  optimizer.optimize(1);  // allocates the structure of the system
+  for (auto _ : state) {
+    optimizer.computeActiveErrors();
+    solver->buildSystem();
+  }
+  state.SetItemsProcessed(state.iterations() * optimizer.activeEdges().size());
+}
+
+}  // namespace
+
+BENCHMARK(BM_BuildSystem)
+    ->ArgNames({"coloring", "poses"})
+    ->ArgsProduct({{0, 1}, {1000, 10000}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
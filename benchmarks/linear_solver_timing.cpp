@@ -0,0 +1,90 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include "g2o/core/parallel_executor.h"
+#include "g2o/core/sparse_block_matrix.h"
+#include "g2o/solvers/eigen/linear_solver_eigen.h"
+#include "g2o/solvers/supernodal/linear_solver_supernodal.h"
+
+// Compare the scalar simplicial Cholesky of Eigen with the supernodal block
+// Cholesky on the Hessian of a grid-shaped 3D pose graph, the latter also
+// with a varying number of threads. The symbolic analysis is done once before
+// timing, as it is re-used by the optimizer.
+
+namespace {
+
+using PoseMatrix = Eigen::Matrix<number_t, 6, 6>;
+using SparseMatrix = g2o::SparseBlockMatrix<PoseMatrix>;
+
+std::unique_ptr<SparseMatrix> createGridHessian(int side) {
+  const int numPoses = side * side;
+  std::vector<int> blockIndices(numPoses);
+  for (int i = 0; i < numPoses; ++i) blockIndices[i] = 6 * (i + 1);
+  auto H = g2o::make_unique<SparseMatrix>(
+      blockIndices.data(), blockIndices.data(), numPoses, numPoses);
+  for (int i = 0; i < numPoses; ++i)
+    *H->block(i, i, true) = PoseMatrix::Identity();
+  auto addEdge = [&H](int from, int to) {
+    const PoseMatrix J = PoseMatrix::Random();
+    *H->block(from, from) += J.transpose() * J;
+    *H->block(to, to) += PoseMatrix::Identity();
+    *H->block(from, to, true) = -J.transpose();
+  };
+  for (int r = 0; r < side; ++r) {
+    for (int c = 0; c < side; ++c) {
+      const int i = r * side + c;
+      if (c + 1 < side) addEdge(i, i + 1);
+      if (r + 1 < side) addEdge(i, i + side);
+    }
+  }
+  return H;
+}
+
+template <typename LinearSolver>
+void BM_Solve(benchmark::State& state) {
+  auto H = createGridHessian(state.range(0));
+  g2o::VectorX b = g2o::VectorX::Ones(H->rows());
+  g2o::VectorX x(H->rows());
+  LinearSolver solver;
+  solver.solve(*H, x.data(), b.data());
+  for (auto _ : state) {
+    solver.solve(*H, x.data(), b.data());
+    benchmark::DoNotOptimize(x.data());
+  }
+}
+
+void BM_SolveParallel(benchmark::State& state) {
+  auto H = createGridHessian(state.range(0));
+  g2o::VectorX b = g2o::VectorX::Ones(H->rows());
+  g2o::VectorX x(H->rows());
+  g2o::LinearSolverSupernodal<PoseMatrix> solver;
+  solver.setExecutor(
+      std::make_shared<g2o::WorkStealingExecutor>(state.range(1)));
+  solver.solve(*H, x.data(), b.data());
+  for (auto _ : state) {
+    solver.solve(*H, x.data(), b.data());
+    benchmark::DoNotOptimize(x.data());
+  }
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_Solve, g2o::LinearSolverEigen<PoseMatrix>)
+    ->ArgName("side")
+    ->Arg(30)
+    ->Arg(60)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Solve, g2o::LinearSolverSupernodal<PoseMatrix>)
+    ->ArgName("side")
+    ->Arg(30)
+    ->Arg(60)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SolveParallel)
+    ->ArgNames({"side", "threads"})
+    ->ArgsProduct({{60}, {1, 2, 4}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -90,6 +90,7 @@ FIND_G2O_LIBRARY(G2O_SOLVER_PCG solver_pcg)
 FIND_G2O_LIBRARY(G2O_SOLVER_SLAM2D_LINEAR solver_slam2d_linear)
 FIND_G2O_LIBRARY(G2O_SOLVER_STRUCTURE_ONLY solver_structure_only)
 FIND_G2O_LIBRARY(G2O_SOLVER_EIGEN solver_eigen)
+FIND_G2O_LIBRARY(G2O_SOLVER_SUPERNODAL solver_supernodal)
 
 # Find the predefined types
 FIND_G2O_LIBRARY(G2O_TYPES_DATA types_data)
@@ -102,9 +103,9 @@ FIND_G2O_LIBRARY(G2O_TYPES_SLAM3D types_slam3d)
 
 # G2O solvers declared found if we found at least one solver
 set(G2O_SOLVERS_FOUND "NO")
-if(G2O_SOLVER_CHOLMOD OR G2O_SOLVER_CSPARSE OR G2O_SOLVER_DENSE OR G2O_SOLVER_PCG OR G2O_SOLVER_SLAM2D_LINEAR OR G2O_SOLVER_STRUCTURE_ONLY OR G2O_SOLVER_EIGEN)
+if(G2O_SOLVER_CHOLMOD OR G2O_SOLVER_CSPARSE OR G2O_SOLVER_DENSE OR G2O_SOLVER_PCG OR G2O_SOLVER_SLAM2D_LINEAR OR G2O_SOLVER_STRUCTURE_ONLY OR G2O_SOLVER_EIGEN OR G2O_SOLVER_SUPERNODAL)
   set(G2O_SOLVERS_FOUND "YES")
-endif(G2O_SOLVER_CHOLMOD OR G2O_SOLVER_CSPARSE OR G2O_SOLVER_DENSE OR G2O_SOLVER_PCG OR G2O_SOLVER_SLAM2D_LINEAR OR G2O_SOLVER_STRUCTURE_ONLY OR G2O_SOLVER_EIGEN)
+endif(G2O_SOLVER_CHOLMOD OR G2O_SOLVER_CSPARSE OR G2O_SOLVER_DENSE OR G2O_SOLVER_PCG OR G2O_SOLVER_SLAM2D_LINEAR OR G2O_SOLVER_STRUCTURE_ONLY OR G2O_SOLVER_EIGEN OR G2O_SOLVER_SUPERNODAL)
 
 # G2O itself declared found if we found the core libraries and at least one solver
 set(G2O_FOUND "NO")
@@ -118,6 +118,9 @@ int main(int argc, char** argv) {
   bool initialGuessOdometry;
   bool marginalize;
   bool listTypes;
+  bool binaryOutput;
+  bool convert;
+  int loadThreads;
   bool listSolvers;
   bool listRobustKernels;
   bool incremental;
@@ -165,6 +168,13 @@ int main(int argc, char** argv) {
             "computes the marginal covariances of something. FOR TESTING ONLY");
   arg.param("gaugeId", gaugeId, -1, "force the gauge");
   arg.param("o", outputfilename, "", "output final version of the graph");
+  arg.param("binary", binaryOutput, false,
+            "write the output graph in the binary format");
+  arg.param("convert", convert, false,
+            "only convert the input graph to the output graph, e.g., -convert "
+            "-binary -o graph.g2ob graph.g2o");
+  arg.param("loadThreads", loadThreads, 0,
+            "parse the text input on n threads, 0 for the sequential parser");
   arg.param("solver", strSolver, "gn_var",
             "specify which solver to use underneat\n\t {gn_var, lm_fix3_2, "
             "gn_fix6_3, lm_fix7_3}");
@@ -282,6 +292,20 @@ int main(int argc, char** argv) {
       cerr << "Error loading graph" << endl;
       return 2;
     }
+  } else if (OptimizableGraph::isBinaryFile(inputFilename.c_str())) {
+    cerr << "Read binary input from " << inputFilename << endl;
+    if (!optimizer.loadBinary(inputFilename.c_str())) {
+      cerr << "Error loading graph" << endl;
+      return 2;
+    }
+  } else if (loadThreads > 0) {
+    cerr << "Read input from " << inputFilename << " on " << loadThreads
+         << " threads" << endl;
+    g2o::WorkStealingExecutor executor(loadThreads);
+    if (!optimizer.loadParallel(inputFilename.c_str(), executor)) {
+      cerr << "Error loading graph" << endl;
+      return 2;
+    }
   } else {
     cerr << "Read input from " << inputFilename << endl;
     std::ifstream ifs(inputFilename.c_str());
@@ -297,6 +321,29 @@ int main(int argc, char** argv) {
   cerr << "Loaded " << optimizer.vertices().size() << " vertices" << endl;
   cerr << "Loaded " << optimizer.edges().size() << " edges" << endl;
 
+  auto saveOutput = [&]() {
+    if (outputfilename.empty()) return true;
+    bool saved = false;
+    if (outputfilename == "-") {
+      cerr << "saving to stdout";
+      saved = binaryOutput ? optimizer.saveBinary(cout) : optimizer.save(cout);
+    } else {
+      cerr << "saving " << outputfilename << " ... ";
+      saved = binaryOutput ? optimizer.saveBinary(outputfilename.c_str())
+                           : optimizer.save(outputfilename.c_str());
+    }
+    cerr << (saved ? "done." : "failed.") << endl;
+    return saved;
+  };
+
+  if (convert) {
+    if (outputfilename.empty()) {
+      cerr << "No output file specified for the conversion" << endl;
+      return 1;
+    }
+    return saveOutput() ? 0 : 1;
+  }
+
   if (optimizer.vertices().empty()) {
     cerr << "Graph contains no vertices" << endl;
     return 1;
@@ -716,16 +763,7 @@ int main(int argc, char** argv) {
     }
   }
 
-  if (!outputfilename.empty()) {
-    if (outputfilename == "-") {
-      cerr << "saving to stdout";
-      optimizer.save(cout);
-    } else {
-      cerr << "saving " << outputfilename << " ... ";
-      optimizer.save(outputfilename.c_str());
-    }
-    cerr << "done." << endl;
-  }
+  saveOutput();
 
   return 0;
 }
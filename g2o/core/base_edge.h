@@ -38,7 +38,6 @@ namespace g2o {
 
 namespace internal {
 
-#ifdef G2O_OPENMP
 struct QuadraticFormLock {
   explicit QuadraticFormLock(OptimizableGraph::Vertex& vertex)
       : _vertex(vertex) {
@@ -49,11 +48,6 @@ struct QuadraticFormLock {
  private:
   OptimizableGraph::Vertex& _vertex;
 };
-#else
-struct QuadraticFormLock {
-  explicit QuadraticFormLock(OptimizableGraph::Vertex&) {}
-};
-#endif
 
 /**
  * Declaring the types for the error vector and the information matrix depending
@@ -30,6 +30,8 @@
 #include <array>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <type_traits>
 #include <utility>
 
 #include "base_edge.h"
@@ -118,8 +120,30 @@ createNthVertexType(int i, const EdgeType& t, CtorArgs... args) {
   }
   return createNthVertexType<I - 1, EdgeType, CtorArgs...>(i, t, args...);
 }
+
+//! the copy of a vertex perturbed by the numeric Jacobians of this thread
+template <typename VertexType>
+std::shared_ptr<VertexType>& numericDiffCopy() {
+  static thread_local std::shared_ptr<VertexType> copy;
+  if (!copy) copy = std::shared_ptr<VertexType>(new VertexType());
+  return copy;
+}
 }  // namespace internal
 
+/**
+ * The numeric Jacobians of BaseFixedSizedEdge perturb a copy of the vertex
+ * owned by the thread instead of the vertex in the graph. Hence, edges
+ * sharing a vertex are linearized concurrently without locking. This requires
+ * computeError() to depend on the estimate of VertexType only. Specialize to
+ * std::false_type for vertices with further state, e.g., camera parameters,
+ * whose numeric Jacobians then perturb the vertex in the graph.
+ */
+template <typename VertexType>
+struct NumericDiffOnCopy
+    : std::integral_constant<bool,
+                             std::is_default_constructible<VertexType>::value &&
+                                 VertexType::kDimension != Eigen::Dynamic> {};
+
 template <int D, typename E, typename... VertexTypes>
 class BaseFixedSizedEdge : public BaseEdge<D, E> {
  public:
@@ -245,6 +269,13 @@ class BaseFixedSizedEdge : public BaseEdge<D, E> {
   void linearizeOplusNs(std::index_sequence<Ints...>);
   template <int N>
   void linearizeOplusN();
+  //! numeric Jacobian on a copy of the vertex, false if not possible
+  template <int N>
+  bool linearizeOplusNOnCopy(std::true_type);
+  template <int N>
+  bool linearizeOplusNOnCopy(std::false_type) {
+    return false;
+  }
 
   //! returns the result of the linearization in the manifold space for the
   //! nodes xn
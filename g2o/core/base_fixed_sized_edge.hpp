@@ -161,6 +161,10 @@ void BaseFixedSizedEdge<D, E, VertexTypes...>::linearizeOplusN() {
 
   if (vertex->fixed()) return;
 
+  if (linearizeOplusNOnCopy<N>(NumericDiffOnCopy<VertexXnType<N>>())) return;
+
+  // perturb the vertex in the graph, which is only safe if no other thread
+  // evaluates an edge of the vertex
   auto& jacobianOplus = std::get<N>(jacobianOplus_);
 
   constexpr number_t kDelta = cst(1e-9);
@@ -176,26 +180,71 @@ void BaseFixedSizedEdge<D, E, VertexTypes...>::linearizeOplusN() {
                               add_vertex_buffer.size());
 
   // estimate the jacobian numerically
-  // add small step along the unit vector in each dimension
+  // add small step along the unit vector in each dimension. The estimate is
+  // restored from a local copy instead of the stack of the vertex.
+  const typename VertexXnType<N>::EstimateType estimate = vertex->estimate();
   for (int d = 0; d < vertexDimension<N>(); ++d) {
-    vertex->push();
     add_vertex[d] = kDelta;
     vertex->oplus(add_vertex);
     computeError();
     auto errorBak = this->error();
-    vertex->pop();
-    vertex->push();
+    vertex->setEstimate(estimate);
     add_vertex[d] = -kDelta;
     vertex->oplus(add_vertex);
     computeError();
     errorBak -= this->error();
-    vertex->pop();
+    vertex->setEstimate(estimate);
     add_vertex[d] = 0.0;
 
     jacobianOplus.col(d) = kScalar * errorBak;
   }  // end dimension
 }
 
+template <int D, typename E, typename... VertexTypes>
+template <int N>
+bool BaseFixedSizedEdge<D, E, VertexTypes...>::linearizeOplusNOnCopy(
+    std::true_type) {
+  using VertexType = VertexXnType<N>;
+  const VertexType* vertex = vertexXnRaw<N>();
+  // the caches of the vertex would not follow the copy
+  if (vertex->hasCacheContainer()) return false;
+
+  auto& jacobianOplus = std::get<N>(jacobianOplus_);
+
+  constexpr number_t kDelta = cst(1e-9);
+  constexpr number_t kScalar = 1 / (2 * kDelta);
+
+  typename VertexType::BVector add_vertex_buffer;
+  add_vertex_buffer.setZero();
+  VectorX::MapType add_vertex(add_vertex_buffer.data(),
+                              add_vertex_buffer.size());
+
+  // computeError() evaluates the copy in place of the vertex, each step
+  // starts from the estimate of the vertex
+  const std::shared_ptr<VertexType>& copy =
+      internal::numericDiffCopy<VertexType>();
+  const typename VertexType::EstimateType& estimate = vertex->estimate();
+  std::shared_ptr<HyperGraph::Vertex> original = std::move(vertices_[N]);
+  vertices_[N] = copy;
+  for (int d = 0; d < VertexType::kDimension; ++d) {
+    copy->setEstimate(estimate);
+    add_vertex[d] = kDelta;
+    copy->oplus(add_vertex);
+    computeError();
+    auto errorBak = this->error();
+    copy->setEstimate(estimate);
+    add_vertex[d] = -kDelta;
+    copy->oplus(add_vertex);
+    computeError();
+    errorBak -= this->error();
+    add_vertex[d] = 0.0;
+
+    jacobianOplus.col(d) = kScalar * errorBak;
+  }
+  vertices_[N] = std::move(original);
+  return true;
+}
+
 template <int D, typename E, typename... VertexTypes>
 template <std::size_t... Ints>
 void BaseFixedSizedEdge<D, E, VertexTypes...>::linearizeOplusNs(
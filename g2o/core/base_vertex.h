@@ -30,7 +30,9 @@
 #include <Eigen/Cholesky>
 #include <Eigen/Core>
 #include <Eigen/Dense>
+#include <new>
 #include <stack>
+#include <utility>
 
 #include "creators.h"
 #include "g2o/config.h"
@@ -59,6 +61,8 @@ class BaseVertex : public OptimizableGraph::Vertex {
   using BackupStackType = std::stack<
       EstimateType,
       std::vector<EstimateType, Eigen::aligned_allocator<EstimateType>>>;
+  static_assert(alignof(EstimateType) <= kStateAlignment,
+                "estimate is over-aligned for saveState()");
 
   static const int kDimension =
       D;  ///< dimension of the estimate (minimal) in the manifold space
@@ -111,6 +115,20 @@ class BaseVertex : public OptimizableGraph::Vertex {
   }
   int stackSize() const override { return backup_.size(); }
 
+  size_t stateSize() const override { return sizeof(EstimateType); }
+  void saveState(void* state) const override {
+    ::new (state) EstimateType(estimate_);
+  }
+  void restoreState(void* state) override {
+    auto* saved = static_cast<EstimateType*>(state);
+    estimate_ = std::move(*saved);
+    saved->~EstimateType();
+    updateCache();
+  }
+  void discardState(void* state) const override {
+    static_cast<EstimateType*>(state)->~EstimateType();
+  }
+
   //! return the current estimate of the vertex
   const EstimateType& estimate() const { return estimate_; }
   //! set the estimate for the vertex also calls updateCache()
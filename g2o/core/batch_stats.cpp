@@ -68,6 +68,7 @@ std::ostream& operator<<(std::ostream& os, const G2OBatchStatistics& st) {
       timeNumericDecomposition);     // numeric decomposition  (0 if not done);
   os << PTHING(timeLinearSolution);  // total time for solving Ax=b
   os << PTHING(iterationsLinearSolver);  // iterations of PCG
+  os << PTHING(timePreconditioner);      // setup of the pre-conditioner
   os << PTHING(timeUpdate);              // oplus
   os << PTHING(timeIteration);           // total time );
 
@@ -79,6 +80,7 @@ std::ostream& operator<<(std::ostream& os, const G2OBatchStatistics& st) {
   os << PTHING(hessianLandmarkDimension);
   os << PTHING(choleskyNNZ);
   os << PTHING(timeMarginals);
+  os << PTHING(timeInitialization);
 
   return os;
 };
@@ -63,11 +63,14 @@ struct G2O_CORE_API G2OBatchStatistics {
   number_t timeLinearSolver;     ///< time for solving, excluding Schur setup
   int iterationsLinearSolver;    ///< iterations of PCG, (0 if not used, i.e.,
                                  ///< Cholesky)
+  number_t timePreconditioner;   ///< setup of the PCG pre-conditioner
   number_t timeUpdate;           ///< time to apply the update
   number_t timeIteration;        ///< total time;
 
   number_t timeMarginals;  ///< computing the inverse elements (solve blocks)
                            ///< and thus the marginal covariances
+  number_t timeInitialization;  ///< initializeOptimization() before the
+                                ///< iteration
 
   // information about the Hessian matrix
   size_t hessianDimension;      ///< rows / cols of the Hessian
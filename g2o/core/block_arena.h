@@ -0,0 +1,151 @@
+// g2o - General Graph Optimization
+// Copyright (C) 2011 R. Kuemmerle, G. Grisetti, W. Burgard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef G2O_BLOCK_ARENA_H
+#define G2O_BLOCK_ARENA_H
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace g2o {
+
+/**
+ * \brief Arena for the blocks of a sparse block matrix
+ *
+ * Allocates the blocks of a SparseBlockMatrix from a few large aligned slabs
+ * instead of creating each block individually on the heap. Pointers to the
+ * blocks stay valid until reset() or release() is called. Resetting keeps
+ * the memory of the slabs around such that re-creating a structure of the
+ * same size does not touch the heap.
+ *
+ * Note: For dynamically sized blocks (MatrixX) only the block objects are
+ * stored in the arena, the coefficients are still allocated by Eigen.
+ */
+template <class MatrixType>
+class BlockArena {
+ public:
+  //! minimal number of blocks in a slab
+  static constexpr size_t kMinSlabSize = 64;
+
+  BlockArena() = default;
+  BlockArena(const BlockArena&) = delete;
+  BlockArena& operator=(const BlockArena&) = delete;
+
+  /**
+   * create a new zero block of the given size within the arena.
+   */
+  MatrixType* allocate(int rows, int cols) {
+    Slab* slab = currentSlab();
+    slab->emplace_back(rows, cols);
+    MatrixType* block = &slab->back();
+    block->setZero();
+    ++size_;
+    return block;
+  }
+
+  //! create a new block within the arena which is a copy of other
+  MatrixType* allocate(const MatrixType& other) {
+    Slab* slab = currentSlab();
+    slab->push_back(other);
+    ++size_;
+    return &slab->back();
+  }
+
+  /**
+   * make sure that the next n blocks are allocated in a single slab.
+   */
+  void reserve(size_t n) {
+    if (!slabs_.empty()) {
+      Slab& last = slabs_.back();
+      if (last.capacity() - last.size() >= n) return;
+      if (last.empty()) {  // recycle the empty slab
+        last = Slab();
+        last.reserve(std::max(n, kMinSlabSize));
+        return;
+      }
+    }
+    addSlab(n);
+  }
+
+  /**
+   * destroy all the blocks but keep the memory for re-using it. Multiple slabs
+   * are merged into a single one, such that the next fill is contiguous.
+   */
+  void reset() {
+    if (slabs_.size() > 1) {
+      size_t totalCapacity = capacity();
+      slabs_.clear();
+      addSlab(totalCapacity);
+    } else if (!slabs_.empty()) {
+      slabs_.front().clear();
+    }
+    size_ = 0;
+  }
+
+  //! destroy all the blocks and free the memory
+  void release() {
+    slabs_.clear();
+    size_ = 0;
+  }
+
+  //! number of blocks allocated in the arena
+  size_t size() const { return size_; }
+
+  //! number of blocks the arena can store without allocating a new slab
+  size_t capacity() const {
+    size_t result = 0;
+    for (const auto& s : slabs_) result += s.capacity();
+    return result;
+  }
+
+  //! number of slabs used by the arena
+  size_t numSlabs() const { return slabs_.size(); }
+
+ protected:
+  // a slab is never grown beyond its reserved capacity, hence the addresses of
+  // the blocks are stable.
+  using Slab = std::vector<MatrixType, Eigen::aligned_allocator<MatrixType>>;
+
+  Slab* currentSlab() {
+    if (slabs_.empty() || slabs_.back().size() == slabs_.back().capacity())
+      addSlab(std::max(size_, kMinSlabSize));
+    return &slabs_.back();
+  }
+
+  void addSlab(size_t n) {
+    slabs_.emplace_back();
+    slabs_.back().reserve(std::max(n, kMinSlabSize));
+  }
+
+  std::vector<Slab> slabs_;
+  size_t size_ = 0;
+};
+
+}  // namespace g2o
+
+#endif
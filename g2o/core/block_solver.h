@@ -32,8 +32,9 @@
 
 #include "dynamic_aligned_buffer.hpp"
 #include "g2o/config.h"
+#include "jacobian_workspace.h"
 #include "linear_solver.h"
-#include "openmp_mutex.h"
+#include "parallel_executor.h"
 #include "solver.h"
 #include "sparse_block_matrix.h"
 #include "sparse_block_matrix_diagonal.h"
@@ -94,6 +95,54 @@ class BlockSolverBase : public Solver {
    * compute dest = H * src
    */
   virtual void multiplyHessian(number_t* dest, const number_t* src) const = 0;
+
+  /**
+   * construct the quadratic form in buildSystem() in groups of edges which do
+   * not share a vertex (greedy edge coloring). The edges of a group are
+   * processed in parallel without locking the vertices. Otherwise, all edges
+   * are processed in parallel and each vertex is locked while writing to it.
+   */
+  bool edgeColoring() const { return edgeColoring_; }
+  void setEdgeColoring(bool edgeColoring) { edgeColoring_ = edgeColoring; }
+
+  //! how buildStructure() treats the structure of a previous call
+  enum class StructureReuse {
+    kAuto,   ///< reuse if the vertices and edges yield the same structure
+    kNever,  ///< always rebuild, including the symbolic factorization
+    kAlways  ///< reuse without checking, the caller guarantees the structure
+  };
+  /**
+   * If the structure is reused, buildStructure() only maps the existing
+   * blocks into the vertices and edges. The matrices, the pattern of the
+   * Schur complement and the symbolic factorization of the linear solver are
+   * kept.
+   */
+  StructureReuse structureReuse() const { return structureReuse_; }
+  void setStructureReuse(StructureReuse reuse) { structureReuse_ = reuse; }
+  //! rebuild the structure in the next call to buildStructure()
+  void forceStructureRebuild() { forceStructureRebuild_ = true; }
+  //! true if the last call to buildStructure() reused the structure
+  bool structureReused() const { return structureReused_; }
+
+  /**
+   * Solve the Schur complement S = Hpp - Hpl * Hll^-1 * Hpl^T implicitly.
+   * S is not formed, the linear solver only evaluates products S * x and
+   * gets the diagonal blocks of S. This saves the memory and the time for
+   * the reduced camera system of large bundle adjustment problems. Only used
+   * if the linear solver supports it, see LinearSolver::solveImplicit().
+   */
+  bool implicitSchur() const { return implicitSchur_; }
+  void setImplicitSchur(bool implicitSchur) {
+    implicitSchur_ = implicitSchur;
+    forceStructureRebuild_ = true;
+  }
+
+ protected:
+  bool edgeColoring_ = false;
+  bool implicitSchur_ = false;
+  StructureReuse structureReuse_ = StructureReuse::kAuto;
+  bool forceStructureRebuild_ = false;
+  bool structureReused_ = false;
 };
 
 /**
@@ -129,6 +178,14 @@ class BlockSolver : public BlockSolverBase {
                        const HyperGraph::EdgeSet& edges) override;
   bool buildSystem() override;
   bool solve() override;
+  /**
+   * With the Schur complement, the blocks may refer to poses and landmarks,
+   * i.e., vertices with a Hessian index of at least the number of poses. The
+   * covariance of the poses is the inverse of the Schur complement S, the
+   * ones of the landmarks follow from it by
+   * Sigma_pl = -Sigma_pp * Hpl * Hll^-1 and
+   * Sigma_ll = Hll^-1 + Hll^-1 * Hpl^T * Sigma_pp * Hpl * Hll^-1.
+   */
   bool computeMarginals(
       SparseBlockMatrix<MatrixX>& spinv,
       const std::vector<std::pair<int, int>>& blockIndices) override;
@@ -149,37 +206,101 @@ class BlockSolver : public BlockSolverBase {
     Hpp_->multiplySymmetricUpperTriangle(dest, src);
   }
 
+  /**
+   * compute dest = S * src for the Schur complement S of the current system
+   * without forming S
+   */
+  void multiplySchurComplement(number_t* dest, const number_t* src);
+
  protected:
+  /**
+   * compute Hschur_ = Hpp - Hpl * Hll^-1 * Hpl^T of the current system along
+   * with Hll^-1 in DInvSchur_, and Hpl * Hll^-1 * bl in coefficients_
+   */
+  void computeSchurComplement();
+
+  //! computeMarginals() for the poses and landmarks of the Schur complement
+  bool computeMarginalsSchur(
+      SparseBlockMatrix<MatrixX>& spinv,
+      const std::vector<std::pair<int, int>>& blockIndices);
+
   void resize(int* blockPoseIndices, int numPoseBlocks,
               int* blockLandmarkIndices, int numLandmarkBlocks, int totalDim);
 
   void deallocate();
 
+  //! partition the active edges into groups without a common vertex
+  void computeEdgeColoring();
+
+  /**
+   * allocate the blocks of the Hessian for the active vertices and edges or,
+   * if mapMemory is true, map the allocated blocks into them
+   */
+  void allocateBlocks(
+      bool mapMemory, bool zeroBlocks,
+      SparseBlockMatrixHashMap<PoseMatrixType>* schurMatrixLookup);
+
+  /**
+   * compute the signature of the current structure into
+   * structureSignatureScratch_, returns true if it equals the one of the
+   * structure which was built last
+   */
+  bool computeStructureSignature();
+
   std::unique_ptr<SparseBlockMatrix<PoseMatrixType>> Hpp_;
   std::unique_ptr<SparseBlockMatrix<LandmarkMatrixType>> Hll_;
   std::unique_ptr<SparseBlockMatrix<PoseLandmarkMatrixType>> Hpl_;
 
+  //! the Schur complement, only its diagonal blocks if useImplicitSchur_
   std::unique_ptr<SparseBlockMatrix<PoseMatrixType>> Hschur_;
   std::unique_ptr<SparseBlockMatrixDiagonal<LandmarkMatrixType>> DInvSchur_;
 
   std::unique_ptr<SparseBlockMatrixCCS<PoseLandmarkMatrixType>> HplCCS_;
+  //! the columns are the poses, i.e., the landmarks observed by each pose
+  std::unique_ptr<SparseBlockMatrixCCS<PoseLandmarkMatrixType>>
+      HplTransposedCCS_;
   std::unique_ptr<SparseBlockMatrixCCS<PoseMatrixType>> HschurTransposedCCS_;
 
   std::unique_ptr<LinearSolverType> linearSolver_;
 
+  //! dimensions of the vertices and the Hessian indices of the edges
+  std::vector<int> structureSignature_;
+  std::vector<int> structureSignatureScratch_;
+
+  //! indices into the active edges sorted by their color
+  std::vector<int> coloredEdges_;
+  //! start of each color in coloredEdges_, empty if not computed
+  std::vector<int> colorOffsets_;
+
   std::vector<PoseVectorType, Eigen::aligned_allocator<PoseVectorType>>
       diagonalBackupPose_;
   std::vector<LandmarkVectorType, Eigen::aligned_allocator<LandmarkVectorType>>
       diagonalBackupLandmark_;
 
-#ifdef G2O_OPENMP
-  std::vector<OpenMPMutex> coefficientsMutex_;
-#endif
+  //! copies of the Jacobian workspace for each thread of the executor
+  std::vector<JacobianWorkspace> jacobianWorkspaces_;
+
+  //! chunk sizes of the parallel loops
+  AdaptiveGrain clearGrain_;
+  AdaptiveGrain edgeGrain_;
+  AdaptiveGrain copyBGrain_;
+  AdaptiveGrain lambdaPoseGrain_;
+  AdaptiveGrain lambdaLandmarkGrain_;
+  AdaptiveGrain schurLandmarkGrain_;
+  AdaptiveGrain schurPoseGrain_;
+  AdaptiveGrain productLandmarkGrain_;
+  AdaptiveGrain productPoseGrain_;
+  AdaptiveGrain marginalsGrain_;
 
   std::unique_ptr<number_t[], AlignedDeleter<number_t>> coefficients_;
   std::unique_ptr<number_t[], AlignedDeleter<number_t>> bschur_;
 
+  //! Hll^-1 * Hpl^T * x of the last call to multiplySchurComplement()
+  VectorX schurProductLandmarks_;
+
   bool doSchur_ = true;
+  //! the structure was built for solving the Schur complement implicitly
+  bool useImplicitSchur_ = false;
   int numPoses_ = 0;
   int numLandmarks_ = 0;
   int sizePoses_ = 0;
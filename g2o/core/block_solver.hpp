@@ -25,8 +25,10 @@
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <Eigen/LU>
+#include <algorithm>
 #include <fstream>
 #include <iomanip>
+#include <numeric>
 
 #include "g2o/stuff/macros.h"
 #include "g2o/stuff/misc.h"
@@ -73,9 +75,17 @@ void BlockSolver<Traits>::resize(int* blockPoseIndices, int numPoseBlocks,
     HschurTransposedCCS_ =
         g2o::make_unique<SparseBlockMatrixCCS<PoseMatrixType>>(
             Hschur_->colBlockIndices(), Hschur_->rowBlockIndices());
-#ifdef G2O_OPENMP
-    coefficientsMutex_.resize(numPoseBlocks);
-#endif
+    HplTransposedCCS_ =
+        g2o::make_unique<SparseBlockMatrixCCS<PoseLandmarkMatrixType>>(
+            Hpl_->colBlockIndices(), Hpl_->rowBlockIndices());
+  }
+
+  // allocate the blocks from contiguous memory instead of individually
+  Hpp_->setArenaStorage(true);
+  if (doSchur_) {
+    Hschur_->setArenaStorage(true);
+    Hll_->setArenaStorage(true);
+    Hpl_->setArenaStorage(true);
   }
 }
 
@@ -90,6 +100,7 @@ void BlockSolver<Traits>::deallocate() {
   bschur_.reset();
 
   HplCCS_.reset();
+  HplTransposedCCS_.reset();
   HschurTransposedCCS_.reset();
 }
 
@@ -100,6 +111,34 @@ template <typename Traits>
 bool BlockSolver<Traits>::buildStructure(bool zeroBlocks) {
   assert(optimizer_);
 
+  // compare against the structure which was built last
+  bool unchanged = false;
+  if (structureReuse_ == StructureReuse::kAuto) {
+    unchanged = computeStructureSignature();
+  } else {
+    unchanged = structureReuse_ == StructureReuse::kAlways;
+    structureSignature_.clear();
+  }
+  structureReused_ = unchanged && Hpp_ && !forceStructureRebuild_;
+  forceStructureRebuild_ = false;
+  if (structureReused_) {
+    // the same blocks, only the vertices and edges might be new objects
+    int colPoses = 0;
+    int colLandmarks = 0;
+    for (auto* v : optimizer_->indexMapping()) {
+      int& col = v->marginalized() ? colLandmarks : colPoses;
+      v->setColInHessian(col);
+      col += v->dimension();
+    }
+    allocateBlocks(true, zeroBlocks, nullptr);
+    return true;
+  }
+
+  // new non-zero pattern, the linear solver needs to redo its analysis
+  linearSolver_->init();
+  useImplicitSchur_ =
+      doSchur_ && implicitSchur_ && linearSolver_->supportsImplicit();
+
   size_t sparseDim = 0;
   numPoses_ = 0;
   numLandmarks_ = 0;
@@ -127,7 +166,91 @@ bool BlockSolver<Traits>::buildStructure(bool zeroBlocks) {
          sparseDim);
   delete[] blockLandmarkIndices;
   delete[] blockPoseIndices;
+  colorOffsets_.clear();
+
+  // temporary structures for building the pattern of the Schur complement
+  SparseBlockMatrixHashMap<PoseMatrixType>* schurMatrixLookup = nullptr;
+  if (doSchur_ && !useImplicitSchur_) {
+    schurMatrixLookup = new SparseBlockMatrixHashMap<PoseMatrixType>(
+        Hschur_->rowBlockIndices(), Hschur_->colBlockIndices());
+    schurMatrixLookup->blockCols().resize(Hschur_->blockCols().size());
+  }
+
+  // The structure is created in two passes. The first pass allocates the
+  // blocks. Afterwards, the blocks are laid out column by column in the arena
+  // of each matrix and the second pass maps the memory into the vertices and
+  // edges.
+  for (int pass = 0; pass < 2; ++pass) {
+    const bool mapMemory = pass == 1;
+    if (mapMemory) {
+      Hpp_->compactStorage();
+      if (doSchur_) {
+        Hll_->compactStorage();
+        Hpl_->compactStorage();
+      }
+    }
+    allocateBlocks(mapMemory, zeroBlocks, schurMatrixLookup);
+  }
+
+  // the pattern is fixed from now on, the kernels work on compressed arrays
+  Hpp_->freezeStructure();
+  if (!doSchur_) {
+    delete schurMatrixLookup;
+    return true;
+  }
+  Hll_->freezeStructure();
+  Hpl_->freezeStructure();
+
+  DInvSchur_->diagonal().resize(numLandmarks_);
+  Hpl_->fillSparseBlockMatrixCCS(*HplCCS_);
+  Hpl_->fillSparseBlockMatrixCCSTransposed(*HplTransposedCCS_);
+
+  if (useImplicitSchur_) {
+    // only the diagonal blocks of the Schur complement are formed
+    for (int i = 0; i < numPoses_; ++i) Hschur_->block(i, i, true);
+    Hschur_->freezeStructure();
+    Hschur_->fillSparseBlockMatrixCCSTransposed(*HschurTransposedCCS_);
+    schurProductLandmarks_.resize(sizeLandmarks_);
+    return true;
+  }
+
+  for (OptimizableGraph::Vertex* v : optimizer_->indexMapping()) {
+    if (v->marginalized()) {
+      const std::vector<HyperGraph::Edge*>& vedges = v->adjacentEdges();
+      for (HyperGraph::Edge* e1 : vedges) {
+        for (size_t i = 0; i < e1->vertices().size(); ++i) {
+          auto* v1 =
+              static_cast<OptimizableGraph::Vertex*>(e1->vertices()[i].get());
+          if (v1->hessianIndex() == -1 || v1 == v) continue;
+          for (HyperGraph::Edge* e2 : vedges) {
+            for (size_t j = 0; j < e2->vertices().size(); ++j) {
+              auto* v2 = static_cast<OptimizableGraph::Vertex*>(
+                  e2->vertices()[j].get());
+              if (v2->hessianIndex() == -1 || v2 == v) continue;
+              int i1 = v1->hessianIndex();
+              int i2 = v2->hessianIndex();
+              if (i1 <= i2) {
+                schurMatrixLookup->addBlock(i1, i2);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
 
+  Hschur_->takePatternFromHash(*schurMatrixLookup);
+  delete schurMatrixLookup;
+  Hschur_->freezeStructure();
+  Hschur_->fillSparseBlockMatrixCCSTransposed(*HschurTransposedCCS_);
+
+  return true;
+}
+
+template <typename Traits>
+void BlockSolver<Traits>::allocateBlocks(
+    bool mapMemory, bool zeroBlocks,
+    SparseBlockMatrixHashMap<PoseMatrixType>* schurMatrixLookup) {
   // allocate the diagonal on Hpp and Hll
   int poseIdx = 0;
   int landmarkIdx = 0;
@@ -135,38 +258,34 @@ bool BlockSolver<Traits>::buildStructure(bool zeroBlocks) {
     if (!v->marginalized()) {
       // assert(poseIdx == v->hessianIndex());
       PoseMatrixType* m = Hpp_->block(poseIdx, poseIdx, true);
-      if (zeroBlocks) m->setZero();
-      v->mapHessianMemory(m->data());
+      if (mapMemory) {
+        if (zeroBlocks) m->setZero();
+        v->mapHessianMemory(m->data());
+      }
       ++poseIdx;
     } else {
       LandmarkMatrixType* m = Hll_->block(landmarkIdx, landmarkIdx, true);
-      if (zeroBlocks) m->setZero();
-      v->mapHessianMemory(m->data());
+      if (mapMemory) {
+        if (zeroBlocks) m->setZero();
+        v->mapHessianMemory(m->data());
+      }
       ++landmarkIdx;
     }
   }
   assert(poseIdx == numPoses_ && landmarkIdx == numLandmarks_);
 
-  // temporary structures for building the pattern of the Schur complement
-  SparseBlockMatrixHashMap<PoseMatrixType>* schurMatrixLookup = nullptr;
-  if (doSchur_) {
-    schurMatrixLookup = new SparseBlockMatrixHashMap<PoseMatrixType>(
-        Hschur_->rowBlockIndices(), Hschur_->colBlockIndices());
-    schurMatrixLookup->blockCols().resize(Hschur_->blockCols().size());
-  }
-
   // here we assume that the landmark indices start after the pose ones
   // create the structure in Hpp, Hll and in Hpl
   for (const auto& e : optimizer_->activeEdges()) {
     for (size_t viIdx = 0; viIdx < e->vertices().size(); ++viIdx) {
-      auto v1 =
-          std::static_pointer_cast<OptimizableGraph::Vertex>(e->vertex(viIdx));
+      auto* v1 =
+          static_cast<OptimizableGraph::Vertex*>(e->vertices()[viIdx].get());
       int ind1 = v1->hessianIndex();
       if (ind1 == -1) continue;
       int indexV1Bak = ind1;
       for (size_t vjIdx = viIdx + 1; vjIdx < e->vertices().size(); ++vjIdx) {
-        auto v2 = std::static_pointer_cast<OptimizableGraph::Vertex>(
-            e->vertex(vjIdx));
+        auto* v2 = static_cast<OptimizableGraph::Vertex*>(
+            e->vertices()[vjIdx].get());
         int ind2 = v2->hessianIndex();
         if (ind2 == -1) continue;
         ind1 = indexV1Bak;
@@ -175,85 +294,71 @@ bool BlockSolver<Traits>::buildStructure(bool zeroBlocks) {
                                 // block
           std::swap(ind1, ind2);
         }
+        number_t* blockData = nullptr;
+        bool transposeWrite = false;
         if (!v1->marginalized() && !v2->marginalized()) {
           PoseMatrixType* m = Hpp_->block(ind1, ind2, true);
-          if (zeroBlocks) m->setZero();
-          e->mapHessianMemory(m->data(), viIdx, vjIdx, transposedBlock);
-          if (Hschur_) {  // assume this is only needed in case we solve with
-                          // the schur complement
+          if (mapMemory && zeroBlocks) m->setZero();
+          blockData = m->data();
+          transposeWrite = transposedBlock;
+          if (schurMatrixLookup && !mapMemory) {
             schurMatrixLookup->addBlock(ind1, ind2);
           }
         } else if (v1->marginalized() && v2->marginalized()) {
           // RAINER hmm.... should we ever reach this here????
           LandmarkMatrixType* m =
               Hll_->block(ind1 - numPoses_, ind2 - numPoses_, true);
-          if (zeroBlocks) m->setZero();
-          e->mapHessianMemory(m->data(), viIdx, vjIdx, false);
+          if (mapMemory && zeroBlocks) m->setZero();
+          blockData = m->data();
         } else {
           if (v1->marginalized()) {
             PoseLandmarkMatrixType* m = Hpl_->block(
                 v2->hessianIndex(), v1->hessianIndex() - numPoses_, true);
-            if (zeroBlocks) m->setZero();
-            e->mapHessianMemory(
-                m->data(), viIdx, vjIdx,
-                true);  // transpose the block before writing to it
+            if (mapMemory && zeroBlocks) m->setZero();
+            blockData = m->data();
+            transposeWrite = true;  // transpose the block before writing to
+                                    // it
           } else {
             PoseLandmarkMatrixType* m = Hpl_->block(
                 v1->hessianIndex(), v2->hessianIndex() - numPoses_, true);
-            if (zeroBlocks) m->setZero();
-            e->mapHessianMemory(m->data(), viIdx, vjIdx,
-                                false);  // directly the block
+            if (mapMemory && zeroBlocks) m->setZero();
+            blockData = m->data();  // directly the block
           }
         }
+        if (mapMemory)
+          e->mapHessianMemory(blockData, viIdx, vjIdx, transposeWrite);
       }
     }
   }
+}
 
-  if (!doSchur_) {
-    delete schurMatrixLookup;
-    return true;
+template <typename Traits>
+bool BlockSolver<Traits>::computeStructureSignature() {
+  std::vector<int>& signature = structureSignatureScratch_;
+  signature.clear();
+  signature.push_back(doSchur_);
+  signature.push_back(static_cast<int>(optimizer_->indexMapping().size()));
+  for (auto* v : optimizer_->indexMapping()) {
+    signature.push_back(v->marginalized() ? -v->dimension() : v->dimension());
   }
-
-  DInvSchur_->diagonal().resize(landmarkIdx);
-  Hpl_->fillSparseBlockMatrixCCS(*HplCCS_);
-
-  for (OptimizableGraph::Vertex* v : optimizer_->indexMapping()) {
-    if (v->marginalized()) {
-      const HyperGraph::EdgeSetWeak& vedges = v->edges();
-      for (auto it1 = vedges.begin(); it1 != vedges.end(); ++it1) {
-        auto e1 = it1->lock();
-        for (size_t i = 0; i < e1->vertices().size(); ++i) {
-          auto v1 =
-              std::static_pointer_cast<OptimizableGraph::Vertex>(e1->vertex(i));
-          if (v1->hessianIndex() == -1 || v1.get() == v) continue;
-          for (const auto& vedge : vedges) {
-            auto e2 = vedge.lock();
-            for (size_t j = 0; j < e2->vertices().size(); ++j) {
-              auto v2 = std::static_pointer_cast<OptimizableGraph::Vertex>(
-                  e2->vertex(j));
-              if (v2->hessianIndex() == -1 || v2.get() == v) continue;
-              int i1 = v1->hessianIndex();
-              int i2 = v2->hessianIndex();
-              if (i1 <= i2) {
-                schurMatrixLookup->addBlock(i1, i2);
-              }
-            }
-          }
-        }
-      }
+  signature.push_back(static_cast<int>(optimizer_->activeEdges().size()));
+  for (const auto& e : optimizer_->activeEdges()) {
+    signature.push_back(static_cast<int>(e->vertices().size()));
+    for (const auto& v : e->vertices()) {
+      signature.push_back(
+          static_cast<OptimizableGraph::Vertex*>(v.get())->hessianIndex());
     }
   }
-
-  Hschur_->takePatternFromHash(*schurMatrixLookup);
-  delete schurMatrixLookup;
-  Hschur_->fillSparseBlockMatrixCCSTransposed(*HschurTransposedCCS_);
-
-  return true;
+  const bool unchanged = signature == structureSignature_;
+  std::swap(structureSignature_, signature);
+  return unchanged;
 }
 
 template <typename Traits>
 bool BlockSolver<Traits>::updateStructure(
     const HyperGraph::VertexContainer& vset, const HyperGraph::EdgeSet& edges) {
+  colorOffsets_.clear();
+  structureSignature_.clear();
   for (const auto& vit : vset) {
     auto* v = static_cast<OptimizableGraph::Vertex*>(vit.get());
     int dim = v->dimension();
@@ -277,14 +382,14 @@ bool BlockSolver<Traits>::updateStructure(
 
   for (const auto& e : edges) {
     for (size_t viIdx = 0; viIdx < e->vertices().size(); ++viIdx) {
-      auto v1 =
-          std::static_pointer_cast<OptimizableGraph::Vertex>(e->vertex(viIdx));
+      auto* v1 =
+          static_cast<OptimizableGraph::Vertex*>(e->vertices()[viIdx].get());
       int ind1 = v1->hessianIndex();
       int indexV1Bak = ind1;
       if (ind1 == -1) continue;
       for (size_t vjIdx = viIdx + 1; vjIdx < e->vertices().size(); ++vjIdx) {
-        auto v2 = std::static_pointer_cast<OptimizableGraph::Vertex>(
-            e->vertex(vjIdx));
+        auto* v2 = static_cast<OptimizableGraph::Vertex*>(
+            e->vertices()[vjIdx].get());
         int ind2 = v2->hessianIndex();
         if (ind2 == -1) continue;
         ind1 = indexV1Bak;
@@ -303,10 +408,107 @@ bool BlockSolver<Traits>::updateStructure(
       }
     }
   }
+  Hpp_->freezeStructure();
 
   return true;
 }
 
+template <typename Traits>
+void BlockSolver<Traits>::computeSchurComplement() {
+  // _Hschur = _Hpp, but keeping the pattern of _Hschur
+  Hschur_->clear();
+  if (useImplicitSchur_) {
+    for (int i = 0; i < numPoses_; ++i)
+      *Hschur_->block(i, i) = *Hpp_->block(i, i);
+  } else {
+    Hpp_->add(*Hschur_);
+  }
+
+  // The Schur complement is computed in two passes. First, the landmark
+  // blocks are inverted and Hll^-1 * bl is stored behind the pose part of
+  // _coefficients. Second, each pose i1 accumulates its row of
+  // Hpl * Hll^-1 * Hpl^T and Hpl * Hll^-1 * bl. Each target block is written
+  // by a single task and the landmarks are visited in the same order,
+  // independent of the number of threads.
+  const SparseBlockMatrix<LandmarkMatrixType>& Hll = *Hll_;
+  ParallelExecutor& executor = optimizer_->executor();
+  number_t* landmarkCoefficients = coefficients_.get() + sizePoses_;
+  parallelFor(
+      executor, schurLandmarkGrain_, numLandmarks_,
+      [&](int begin, int end, int) {
+        for (int landmarkIndex = begin; landmarkIndex < end; ++landmarkIndex) {
+          const typename SparseBlockMatrix<LandmarkMatrixType>::IntBlockMap&
+              marginalizeColumn = Hll.blockCols()[landmarkIndex];
+          assert(marginalizeColumn.size() == 1 &&
+                 "more than one block in _Hll column");
+
+          // calculate inverse block for the landmark
+          const LandmarkMatrixType* D = marginalizeColumn.begin()->second;
+          assert(D && D->rows() == D->cols() && "Error in landmark matrix");
+          LandmarkMatrixType& Dinv = DInvSchur_->diagonal()[landmarkIndex];
+          Dinv = D->inverse();
+
+          const int rowBase = Hll.rowBaseOfBlock(landmarkIndex);
+          typename LandmarkVectorType::ConstMapType bl(
+              b_ + sizePoses_ + rowBase, D->rows());
+          typename LandmarkVectorType::MapType db(
+              landmarkCoefficients + rowBase, D->rows());
+          db.noalias() = Dinv * bl;
+        }
+      });
+
+  parallelFor(
+      executor, schurPoseGrain_, numPoses_, [&](int begin, int end, int) {
+        for (int i1 = begin; i1 < end; ++i1) {
+          typename PoseVectorType::MapType Bb(
+              &coefficients_[Hpp_->rowBaseOfBlock(i1)],
+              Hpp_->rowsOfBlock(i1));
+          Bb.setZero();
+          const typename SparseBlockMatrixCCS<
+              PoseMatrixType>::SparseColumn& targetColumn =
+              HschurTransposedCCS_->blockCols()[i1];
+
+          // the landmarks observed by the pose, in increasing order
+          for (const auto& poseLandmark : HplTransposedCCS_->blockCols()[i1]) {
+            const int landmarkIndex = poseLandmark.row;
+            const PoseLandmarkMatrixType* Bi = poseLandmark.block;
+            assert(Bi);
+            const LandmarkMatrixType& Dinv =
+                DInvSchur_->diagonal()[landmarkIndex];
+            typename LandmarkVectorType::ConstMapType db(
+                landmarkCoefficients + Hll.rowBaseOfBlock(landmarkIndex),
+                Dinv.rows());
+            Bb.noalias() += (*Bi) * db;
+
+            PoseLandmarkMatrixType BDinv = (*Bi) * (Dinv);
+            const typename SparseBlockMatrixCCS<
+                PoseLandmarkMatrixType>::SparseColumn& landmarkColumn =
+                HplCCS_->blockCols()[landmarkIndex];
+            typename SparseBlockMatrixCCS<PoseLandmarkMatrixType>::RowBlock
+                aux(i1, nullptr);
+            auto it_inner =
+                lower_bound(landmarkColumn.begin(), landmarkColumn.end(), aux);
+            auto targetColumnIt = targetColumn.begin();
+            for (; it_inner != landmarkColumn.end(); ++it_inner) {
+              int i2 = it_inner->row;
+              const PoseLandmarkMatrixType* Bj = it_inner->block;
+              assert(Bj);
+              while (targetColumnIt->row < i2) ++targetColumnIt;
+              assert(targetColumnIt != targetColumn.end() &&
+                     targetColumnIt->row == i2 &&
+                     "invalid iterator, something wrong with the matrix "
+                     "structure");
+              PoseMatrixType* Hi1i2 = targetColumnIt->block;
+              assert(Hi1i2);
+              (*Hi1i2).noalias() -= BDinv * Bj->transpose();
+              // the first block is i2 == i1, the only one formed if implicit
+              if (useImplicitSchur_) break;
+            }
+          }
+        }
+      });
+}
+
 template <typename Traits>
 bool BlockSolver<Traits>::solve() {
   // cerr << __PRETTY_FUNCTION__ << endl;
@@ -327,80 +529,7 @@ bool BlockSolver<Traits>::solve() {
   // backup the coefficient matrix
   number_t t = get_monotonic_time();
 
-  // _Hschur = _Hpp, but keeping the pattern of _Hschur
-  Hschur_->clear();
-  Hpp_->add(*Hschur_);
-
-  //_DInvSchur->clear();
-  memset(coefficients_.get(), 0, sizePoses_ * sizeof(number_t));
-#ifdef G2O_OPENMP
-#pragma omp parallel for default(shared) schedule(dynamic, 10)
-#endif
-  for (int landmarkIndex = 0;
-       landmarkIndex < static_cast<int>(Hll_->blockCols().size());
-       ++landmarkIndex) {
-    const typename SparseBlockMatrix<LandmarkMatrixType>::IntBlockMap&
-        marginalizeColumn = Hll_->blockCols()[landmarkIndex];
-    assert(marginalizeColumn.size() == 1 &&
-           "more than one block in _Hll column");
-
-    // calculate inverse block for the landmark
-    const LandmarkMatrixType* D = marginalizeColumn.begin()->second;
-    assert(D && D->rows() == D->cols() && "Error in landmark matrix");
-    LandmarkMatrixType& Dinv = DInvSchur_->diagonal()[landmarkIndex];
-    Dinv = D->inverse();
-
-    LandmarkVectorType db(D->rows());
-    for (int j = 0; j < D->rows(); ++j) {
-      db[j] = b_[Hll_->rowBaseOfBlock(landmarkIndex) + sizePoses_ + j];
-    }
-    db = Dinv * db;
-
-    assert((size_t)landmarkIndex < HplCCS_->blockCols().size() &&
-           "Index out of bounds");
-    const typename SparseBlockMatrixCCS<PoseLandmarkMatrixType>::SparseColumn&
-        landmarkColumn = HplCCS_->blockCols()[landmarkIndex];
-
-    for (auto it_outer = landmarkColumn.begin();
-         it_outer != landmarkColumn.end(); ++it_outer) {
-      int i1 = it_outer->row;
-
-      const PoseLandmarkMatrixType* Bi = it_outer->block;
-      assert(Bi);
-
-      PoseLandmarkMatrixType BDinv = (*Bi) * (Dinv);
-      assert(HplCCS_->rowBaseOfBlock(i1) < sizePoses_ && "Index out of bounds");
-      typename PoseVectorType::MapType Bb(
-          &coefficients_[HplCCS_->rowBaseOfBlock(i1)], Bi->rows());
-#ifdef G2O_OPENMP
-      ScopedOpenMPMutex mutexLock(&coefficientsMutex_[i1]);
-#endif
-      Bb.noalias() += (*Bi) * db;
-
-      assert(i1 >= 0 &&
-             i1 < static_cast<int>(HschurTransposedCCS_->blockCols().size()) &&
-             "Index out of bounds");
-      auto targetColumnIt = HschurTransposedCCS_->blockCols()[i1].begin();
-
-      typename SparseBlockMatrixCCS<PoseLandmarkMatrixType>::RowBlock aux(
-          i1, nullptr);
-      auto it_inner =
-          lower_bound(landmarkColumn.begin(), landmarkColumn.end(), aux);
-      for (; it_inner != landmarkColumn.end(); ++it_inner) {
-        int i2 = it_inner->row;
-        const PoseLandmarkMatrixType* Bj = it_inner->block;
-        assert(Bj);
-        while (targetColumnIt->row < i2 /*&& targetColumnIt != HschurTransposedCCS_->blockCols()[i1].end()*/)
-          ++targetColumnIt;
-        assert(targetColumnIt != HschurTransposedCCS_->blockCols()[i1].end() &&
-               targetColumnIt->row == i2 &&
-               "invalid iterator, something wrong with the matrix structure");
-        PoseMatrixType* Hi1i2 = targetColumnIt->block;  //_Hschur->block(i1,i2);
-        assert(Hi1i2);
-        (*Hi1i2).noalias() -= BDinv * Bj->transpose();
-      }
-    }
-  }
+  computeSchurComplement();
   // cerr << "Solve [marginalize] = " <<  get_monotonic_time()-t << endl;
 
   // _bschur = _b for calling solver, and not touching _b
@@ -415,7 +544,17 @@ bool BlockSolver<Traits>::solve() {
   }
 
   t = get_monotonic_time();
-  bool solvedPoses = linearSolver_->solve(*Hschur_, x_, bschur_.get());
+  bool solvedPoses = false;
+  if (useImplicitSchur_) {
+    solvedPoses = linearSolver_->solveImplicit(
+        *Hschur_,
+        [this](number_t* dest, const number_t* src) {
+          multiplySchurComplement(dest, src);
+        },
+        x_, bschur_.get());
+  } else {
+    solvedPoses = linearSolver_->solve(*Hschur_, x_, bschur_.get());
+  }
   if (globalStats) {
     globalStats->timeLinearSolver = get_monotonic_time() - t;
     globalStats->hessianPoseDimension = Hpp_->cols();
@@ -456,12 +595,62 @@ bool BlockSolver<Traits>::solve() {
   return true;
 }
 
+template <typename Traits>
+void BlockSolver<Traits>::multiplySchurComplement(number_t* dest,
+                                                  const number_t* src) {
+  // dest = Hpp * src - Hpl * (Hll^-1 * (Hpl^T * src)). The landmarks and the
+  // poses are processed in parallel, each output block is written by a single
+  // task.
+  ParallelExecutor& executor = optimizer_->executor();
+  const SparseBlockMatrix<LandmarkMatrixType>& Hll = *Hll_;
+  number_t* landmarks = schurProductLandmarks_.data();
+  parallelFor(
+      executor, productLandmarkGrain_, numLandmarks_,
+      [&](int begin, int end, int) {
+        for (int landmarkIndex = begin; landmarkIndex < end; ++landmarkIndex) {
+          const LandmarkMatrixType& Dinv =
+              DInvSchur_->diagonal()[landmarkIndex];
+          LandmarkVectorType sum = LandmarkVectorType::Zero(Dinv.rows());
+          for (const auto& poseLandmark : HplCCS_->blockCols()[landmarkIndex]) {
+            const PoseLandmarkMatrixType* B = poseLandmark.block;
+            typename PoseVectorType::ConstMapType xp(
+                src + Hpp_->rowBaseOfBlock(poseLandmark.row), B->rows());
+            sum.noalias() += B->transpose() * xp;
+          }
+          typename LandmarkVectorType::MapType z(
+              landmarks + Hll.rowBaseOfBlock(landmarkIndex), Dinv.rows());
+          z.noalias() = Dinv * sum;
+        }
+      });
+
+  memset(dest, 0, sizePoses_ * sizeof(number_t));
+  Hpp_->multiplySymmetricUpperTriangle(dest, src);
+
+  parallelFor(
+      executor, productPoseGrain_, numPoses_, [&](int begin, int end, int) {
+        for (int poseIndex = begin; poseIndex < end; ++poseIndex) {
+          typename PoseVectorType::MapType y(
+              dest + Hpp_->rowBaseOfBlock(poseIndex),
+              Hpp_->rowsOfBlock(poseIndex));
+          for (const auto& poseLandmark :
+               HplTransposedCCS_->blockCols()[poseIndex]) {
+            const PoseLandmarkMatrixType* B = poseLandmark.block;
+            typename LandmarkVectorType::ConstMapType z(
+                landmarks + Hll.rowBaseOfBlock(poseLandmark.row), B->cols());
+            y.noalias() -= (*B) * z;
+          }
+        }
+      });
+}
+
 template <typename Traits>
 bool BlockSolver<Traits>::computeMarginals(
     SparseBlockMatrix<MatrixX>& spinv,
     const std::vector<std::pair<int, int>>& blockIndices) {
   number_t t = get_monotonic_time();
-  bool ok = linearSolver_->solvePattern(spinv, blockIndices, *Hpp_);
+  linearSolver_->setMarginalsExecutor(&optimizer_->executor());
+  bool ok = doSchur_ ? computeMarginalsSchur(spinv, blockIndices)
+                     : linearSolver_->solvePattern(spinv, blockIndices, *Hpp_);
   G2OBatchStatistics* globalStats = G2OBatchStatistics::globalStats();
   if (globalStats) {
     globalStats->timeMarginals = get_monotonic_time() - t;
@@ -469,17 +658,128 @@ bool BlockSolver<Traits>::computeMarginals(
   return ok;
 }
 
+template <typename Traits>
+bool BlockSolver<Traits>::computeMarginalsSchur(
+    SparseBlockMatrix<MatrixX>& spinv,
+    const std::vector<std::pair<int, int>>& blockIndices) {
+  if (useImplicitSchur_) {
+    std::cerr << __PRETTY_FUNCTION__
+              << ": marginals require the explicit Schur complement"
+              << std::endl;
+    return false;
+  }
+  // the Schur complement and Hll^-1 of the current, i.e., undamped, system
+  computeSchurComplement();
+
+  // the blocks of Sigma_pp = S^-1 needed for the requested blocks
+  const std::vector<typename SparseBlockMatrixCCS<
+      PoseLandmarkMatrixType>::SparseColumn>& landmarkColumns =
+      HplCCS_->blockCols();
+  std::vector<std::pair<int, int>> poseBlocks;
+  auto addPoseBlock = [&poseBlocks](int i, int j) {
+    poseBlocks.emplace_back(std::min(i, j), std::max(i, j));
+  };
+  for (const auto& idx : blockIndices) {
+    const bool rowIsLandmark = idx.first >= numPoses_;
+    const bool colIsLandmark = idx.second >= numPoses_;
+    if (!rowIsLandmark && !colIsLandmark) {
+      addPoseBlock(idx.first, idx.second);
+    } else if (rowIsLandmark && colIsLandmark) {
+      for (const auto& a : landmarkColumns[idx.first - numPoses_])
+        for (const auto& b : landmarkColumns[idx.second - numPoses_])
+          addPoseBlock(a.row, b.row);
+    } else {
+      const int pose = rowIsLandmark ? idx.second : idx.first;
+      const int landmark = rowIsLandmark ? idx.first : idx.second;
+      for (const auto& b : landmarkColumns[landmark - numPoses_])
+        addPoseBlock(pose, b.row);
+    }
+  }
+  std::sort(poseBlocks.begin(), poseBlocks.end());
+  poseBlocks.erase(std::unique(poseBlocks.begin(), poseBlocks.end()),
+                   poseBlocks.end());
+  SparseBlockMatrix<MatrixX> poseInverse;
+  if (!poseBlocks.empty() &&
+      !linearSolver_->solvePattern(poseInverse, poseBlocks, *Hschur_))
+    return false;
+  const SparseBlockMatrix<MatrixX>& sigmaPP = poseInverse;
+  auto poseCovariance = [&sigmaPP](int i, int j) -> MatrixX {
+    if (i <= j) return *sigmaPP.block(i, j);
+    return sigmaPP.block(j, i)->transpose();
+  };
+
+  // allocate the requested blocks, the landmarks follow the poses
+  std::vector<int> blockOffsets = Hpp_->rowBlockIndices();
+  for (const int offset : Hll_->rowBlockIndices())
+    blockOffsets.push_back(sizePoses_ + offset);
+  spinv = SparseBlockMatrix<MatrixX>(blockOffsets.data(), blockOffsets.data(),
+                                     blockOffsets.size(), blockOffsets.size(),
+                                     true);
+  std::vector<MatrixX*> targets;
+  targets.reserve(blockIndices.size());
+  for (const auto& idx : blockIndices)
+    targets.push_back(spinv.block(idx.first, idx.second, true));
+
+  parallelFor(
+      optimizer_->executor(), marginalsGrain_,
+      static_cast<int>(blockIndices.size()), [&](int begin, int end, int) {
+        for (int k = begin; k < end; ++k) {
+          const int r = blockIndices[k].first;
+          const int c = blockIndices[k].second;
+          MatrixX& target = *targets[k];
+          if (r < numPoses_ && c < numPoses_) {
+            target = poseCovariance(r, c);
+          } else if (r >= numPoses_ && c >= numPoses_) {
+            const LandmarkMatrixType& Dl =
+                DInvSchur_->diagonal()[r - numPoses_];
+            const LandmarkMatrixType& Dm =
+                DInvSchur_->diagonal()[c - numPoses_];
+            MatrixX inner = MatrixX::Zero(Dl.rows(), Dm.cols());
+            for (const auto& a : landmarkColumns[r - numPoses_]) {
+              MatrixX sigmaHpl = MatrixX::Zero(a.block->rows(), Dm.cols());
+              for (const auto& b : landmarkColumns[c - numPoses_])
+                sigmaHpl.noalias() += poseCovariance(a.row, b.row) * (*b.block);
+              inner.noalias() += a.block->transpose() * sigmaHpl;
+            }
+            target.noalias() = Dl * inner * Dm;
+            if (r == c) target += Dl;
+          } else {
+            const int pose = r < numPoses_ ? r : c;
+            const int landmark = (r < numPoses_ ? c : r) - numPoses_;
+            const LandmarkMatrixType& Dl = DInvSchur_->diagonal()[landmark];
+            MatrixX sigmaHpl =
+                MatrixX::Zero(Hpp_->rowsOfBlock(pose), Dl.cols());
+            for (const auto& b : landmarkColumns[landmark])
+              sigmaHpl.noalias() += poseCovariance(pose, b.row) * (*b.block);
+            const MatrixX poseLandmark = -sigmaHpl * Dl;
+            if (r < numPoses_)
+              target = poseLandmark;
+            else
+              target = poseLandmark.transpose();
+          }
+        }
+      });
+  return true;
+}
+
 template <typename Traits>
 bool BlockSolver<Traits>::buildSystem() {
+  ParallelExecutor& executor = optimizer_->executor();
+  const auto& indexMapping = optimizer_->indexMapping();
+  const auto& activeEdges = optimizer_->activeEdges();
+  const int numVertices = static_cast<int>(indexMapping.size());
+  const int numThreads = executor.numThreads();
+  // the edges of a color do not share a vertex, no locking required
+  const bool lockVertices = numThreads > 1 && !edgeColoring_;
+
   // clear b vector
-#ifdef G2O_OPENMP
-#pragma omp parallel for default( \
-    shared) if (optimizer_->indexMapping().size() > 1000)
-#endif
-  for (auto* v : optimizer_->indexMapping()) {
-    assert(v);
-    v->clearQuadraticForm();
-  }
+  parallelFor(executor, clearGrain_, numVertices,
+              [&](int begin, int end, int) {
+                for (int i = begin; i < end; ++i) {
+                  indexMapping[i]->clearQuadraticForm();
+                  indexMapping[i]->setLockQuadraticForm(lockVertices);
+                }
+              });
   Hpp_->clear();
   if (doSchur_) {
     Hll_->clear();
@@ -489,17 +789,15 @@ bool BlockSolver<Traits>::buildSystem() {
   // resetting the terms for the pairwise constraints
   // built up the current system by storing the Hessian blocks in the edges and
   // vertices
-#ifndef G2O_OPENMP
-  // no threading, we do not need to copy the workspace
-  JacobianWorkspace& jacobianWorkspace = optimizer_->jacobianWorkspace();
-#else
-  // if running with threads need to produce copies of the workspace for each
-  // thread
-  JacobianWorkspace jacobianWorkspace = optimizer_->jacobianWorkspace();
-#pragma omp parallel for default(shared) firstprivate( \
-    jacobianWorkspace) if (optimizer_->activeEdges().size() > 100)
-#endif
-  for (const auto& e : optimizer_->activeEdges()) {
+  JacobianWorkspace* jacobianWorkspaces = &optimizer_->jacobianWorkspace();
+  if (numThreads > 1) {
+    // if running with threads need to produce copies of the workspace for
+    // each thread
+    jacobianWorkspaces_.assign(numThreads, optimizer_->jacobianWorkspace());
+    jacobianWorkspaces = jacobianWorkspaces_.data();
+  }
+  auto linearizeEdge = [](OptimizableGraph::Edge* e,
+                          JacobianWorkspace& jacobianWorkspace) {
     e->linearizeOplus(
         jacobianWorkspace);  // jacobian of the nodes' oplus (manifold)
     e->constructQuadraticForm();
@@ -518,44 +816,108 @@ bool BlockSolver<Traits>::buildSystem() {
       }
     }
 #endif
+  };
+  if (edgeColoring_) {
+    if (colorOffsets_.empty()) computeEdgeColoring();
+    for (size_t color = 0; color + 1 < colorOffsets_.size(); ++color) {
+      const int colorBegin = colorOffsets_[color];
+      parallelFor(executor, edgeGrain_, colorOffsets_[color + 1] - colorBegin,
+                  [&](int begin, int end, int thread) {
+                    for (int k = colorBegin + begin; k < colorBegin + end; ++k)
+                      linearizeEdge(activeEdges[coloredEdges_[k]].get(),
+                                    jacobianWorkspaces[thread]);
+                  });
+    }
+  } else {
+    parallelFor(executor, edgeGrain_, static_cast<int>(activeEdges.size()),
+                [&](int begin, int end, int thread) {
+                  for (int k = begin; k < end; ++k)
+                    linearizeEdge(activeEdges[k].get(),
+                                  jacobianWorkspaces[thread]);
+                });
   }
 
   // flush the current system in a sparse block matrix
-#ifdef G2O_OPENMP
-#pragma omp parallel for default( \
-    shared) if (optimizer_->indexMapping().size() > 1000)
-#endif
-  for (auto* v : optimizer_->indexMapping()) {
-    int iBase = v->colInHessian();
-    if (v->marginalized()) iBase += sizePoses_;
-    v->copyB(b_ + iBase);
-  }
+  parallelFor(executor, copyBGrain_, numVertices,
+              [&](int begin, int end, int) {
+                for (int i = begin; i < end; ++i) {
+                  OptimizableGraph::Vertex* v = indexMapping[i];
+                  int iBase = v->colInHessian();
+                  if (v->marginalized()) iBase += sizePoses_;
+                  v->copyB(b_ + iBase);
+                  v->setLockQuadraticForm(true);
+                }
+              });
 
   return false;
 }
 
+template <typename Traits>
+void BlockSolver<Traits>::computeEdgeColoring() {
+  const auto& activeEdges = optimizer_->activeEdges();
+  coloredEdges_.clear();
+  coloredEdges_.reserve(activeEdges.size());
+  colorOffsets_.assign(1, 0);
+
+  // greedy coloring, each round collects the edges of one color in the order
+  // of the active edges. An edge is deferred to the next round if one of its
+  // vertices already has an edge of the current color.
+  std::vector<int> vertexColor(optimizer_->indexMapping().size(), -1);
+  std::vector<int> pending(activeEdges.size());
+  std::iota(pending.begin(), pending.end(), 0);
+  std::vector<int> deferred;
+  for (int color = 0; !pending.empty(); ++color) {
+    deferred.clear();
+    for (int edgeIdx : pending) {
+      const auto& vertices = activeEdges[edgeIdx]->vertices();
+      bool conflict = false;
+      for (const auto& v : vertices) {
+        int idx =
+            static_cast<OptimizableGraph::Vertex*>(v.get())->hessianIndex();
+        if (idx >= 0 && vertexColor[idx] == color) {
+          conflict = true;
+          break;
+        }
+      }
+      if (conflict) {
+        deferred.push_back(edgeIdx);
+        continue;
+      }
+      for (const auto& v : vertices) {
+        int idx =
+            static_cast<OptimizableGraph::Vertex*>(v.get())->hessianIndex();
+        if (idx >= 0) vertexColor[idx] = color;
+      }
+      coloredEdges_.push_back(edgeIdx);
+    }
+    colorOffsets_.push_back(coloredEdges_.size());
+    std::swap(pending, deferred);
+  }
+}
+
 template <typename Traits>
 bool BlockSolver<Traits>::setLambda(number_t lambda, bool backup) {
   if (backup) {
     diagonalBackupPose_.resize(numPoses_);
     diagonalBackupLandmark_.resize(numLandmarks_);
   }
-#ifdef G2O_OPENMP
-#pragma omp parallel for default(shared) if (numPoses_ > 100)
-#endif
-  for (int i = 0; i < numPoses_; ++i) {
-    PoseMatrixType* b = Hpp_->block(i, i);
-    if (backup) diagonalBackupPose_[i] = b->diagonal();
-    b->diagonal().array() += lambda;
-  }
-#ifdef G2O_OPENMP
-#pragma omp parallel for default(shared) if (numLandmarks_ > 100)
-#endif
-  for (int i = 0; i < numLandmarks_; ++i) {
-    LandmarkMatrixType* b = Hll_->block(i, i);
-    if (backup) diagonalBackupLandmark_[i] = b->diagonal();
-    b->diagonal().array() += lambda;
-  }
+  ParallelExecutor& executor = optimizer_->executor();
+  parallelFor(executor, lambdaPoseGrain_, numPoses_,
+              [&](int begin, int end, int) {
+                for (int i = begin; i < end; ++i) {
+                  PoseMatrixType* b = Hpp_->block(i, i);
+                  if (backup) diagonalBackupPose_[i] = b->diagonal();
+                  b->diagonal().array() += lambda;
+                }
+              });
+  parallelFor(executor, lambdaLandmarkGrain_, numLandmarks_,
+              [&](int begin, int end, int) {
+                for (int i = begin; i < end; ++i) {
+                  LandmarkMatrixType* b = Hll_->block(i, i);
+                  if (backup) diagonalBackupLandmark_[i] = b->diagonal();
+                  b->diagonal().array() += lambda;
+                }
+              });
   return true;
 }
 
@@ -582,8 +944,10 @@ bool BlockSolver<Traits>::init(SparseOptimizer* optimizer, bool online) {
     if (Hpp_) Hpp_->clear();
     if (Hpl_) Hpl_->clear();
     if (Hll_) Hll_->clear();
+  } else {
+    // buildStructure() is not called, the pattern changes with each update
+    linearSolver_->init();
   }
-  linearSolver_->init();
   return true;
 }
 
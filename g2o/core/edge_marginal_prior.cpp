@@ -0,0 +1,125 @@
+// g2o - General Graph Optimization
+// Copyright (C) 2011 R. Kuemmerle, G. Grisetti, W. Burgard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "edge_marginal_prior.h"
+
+#include <Eigen/QR>
+#include <cassert>
+
+namespace g2o {
+
+bool EdgeMarginalPrior::estimateData(const OptimizableGraph::Vertex* v,
+                                     bool minimal, VectorX& data) {
+  const int dim =
+      minimal ? v->minimalEstimateDimension() : v->estimateDimension();
+  if (dim < 0) return false;
+  data.resize(dim);
+  return minimal ? v->getMinimalEstimateData(data.data())
+                 : v->getEstimateData(data.data());
+}
+
+bool EdgeMarginalPrior::setLinearizationPoint() {
+  constexpr number_t kDelta = cst(1e-6);
+  constexpr number_t kScalar = 1 / (2 * kDelta);
+  linearizationPoint_.resize(vertices_.size());
+  for (size_t i = 0; i < vertices_.size(); ++i) {
+    OptimizableGraph::Vertex* v = vertexRaw(i);
+    LinearizationPoint& lp = linearizationPoint_[i];
+    lp.minimal = true;
+    if (!estimateData(v, lp.minimal, lp.data)) {
+      lp.minimal = false;
+      if (!estimateData(v, lp.minimal, lp.data)) return false;
+    }
+
+    // derivative of the data with respect to the increment by central
+    // differences, its pseudo-inverse maps a change of the data to delta
+    const int dim = v->dimension();
+    MatrixX derivative(lp.data.size(), dim);
+    VectorX step = VectorX::Zero(dim);
+    VectorX::MapType stepMap(step.data(), dim);
+    VectorX dataPlus;
+    VectorX dataMinus;
+    for (int d = 0; d < dim; ++d) {
+      v->push();
+      step[d] = kDelta;
+      v->oplus(stepMap);
+      estimateData(v, lp.minimal, dataPlus);
+      v->pop();
+      v->push();
+      step[d] = -kDelta;
+      v->oplus(stepMap);
+      estimateData(v, lp.minimal, dataMinus);
+      v->pop();
+      step[d] = 0;
+      derivative.col(d) = kScalar * (dataPlus - dataMinus);
+    }
+    lp.chart = derivative.completeOrthogonalDecomposition().pseudoInverse();
+  }
+  return true;
+}
+
+void EdgeMarginalPrior::setLinearization(const VectorX& error0,
+                                         const MatrixX& jacobian) {
+  assert(error0.size() == jacobian.rows() && "dimension mismatch");
+  setDimension(static_cast<int>(error0.size()));
+  measurement_.setZero(error0.size());
+  information_.setIdentity();
+  error0_ = error0;
+  jacobian_ = jacobian;
+}
+
+void EdgeMarginalPrior::computeError() {
+  assert(linearizationPoint_.size() == vertices_.size() &&
+         "linearization point not set");
+  error_ = error0_;
+  VectorX data;
+  int col = 0;
+  for (size_t i = 0; i < vertices_.size(); ++i) {
+    const OptimizableGraph::Vertex* v = vertexRaw(i);
+    const LinearizationPoint& lp = linearizationPoint_[i];
+    const int dim = v->dimension();
+    estimateData(v, lp.minimal, data);
+    error_.noalias() +=
+        jacobian_.middleCols(col, dim) * (lp.chart * (data - lp.data));
+    col += dim;
+  }
+}
+
+void EdgeMarginalPrior::linearizeOplus() {
+  int col = 0;
+  for (size_t i = 0; i < vertices_.size(); ++i) {
+    const OptimizableGraph::Vertex* v = vertexRaw(i);
+    const int dim = v->dimension();
+    if (!v->fixed()) jacobianOplus_[i] = jacobian_.middleCols(col, dim);
+    col += dim;
+  }
+}
+
+bool EdgeMarginalPrior::read(std::istream&) { return false; }
+
+bool EdgeMarginalPrior::write(std::ostream&) const { return false; }
+
+}  // namespace g2o
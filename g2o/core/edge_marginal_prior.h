@@ -0,0 +1,105 @@
+// g2o - General Graph Optimization
+// Copyright (C) 2011 R. Kuemmerle, G. Grisetti, W. Burgard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef G2O_EDGE_MARGINAL_PRIOR_H
+#define G2O_EDGE_MARGINAL_PRIOR_H
+
+#include <vector>
+
+#include "base_variable_sized_edge.h"
+#include "eigen_types.h"
+#include "g2o_core_api.h"
+
+namespace g2o {
+
+/**
+ * \brief dense prior on a set of vertices, e.g., from marginalization
+ *
+ * Represents the quadratic cost || e0 + J * delta ||^2, where delta stacks
+ * the increments of the vertices with respect to the estimate at which the
+ * prior was linearized and J is kept fixed (first-estimate Jacobian). Hence,
+ * the information is the identity. SparseOptimizer::marginalizeVertices()
+ * creates such an edge from the Schur complement onto the Markov blanket of
+ * the removed vertices.
+ *
+ * The increment of a vertex is approximated from its estimate data, i.e.,
+ * getMinimalEstimateData() or getEstimateData(), as delta = G * (d - d0),
+ * where d0 is the data at the linearization point and G the pseudo-inverse
+ * of the derivative of the data with respect to oplus. Thus, the vertices
+ * have to provide their estimate as data and the prior is only valid while
+ * this data does not wrap around, e.g., an angle at +/- pi.
+ *
+ * The prior is not saved to and loaded from a file.
+ */
+class G2O_CORE_API EdgeMarginalPrior
+    : public BaseVariableSizedEdge<-1, VectorX> {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+  EdgeMarginalPrior() = default;
+
+  /**
+   * stores the current estimate of the vertices as the linearization point.
+   * The vertices have to be set beforehand.
+   * @returns false if a vertex does not provide its estimate as data
+   */
+  bool setLinearizationPoint();
+
+  /**
+   * sets the error at the linearization point and the Jacobian, having a
+   * column for each dimension of the vertices in the order of the vertices.
+   */
+  void setLinearization(const VectorX& error0, const MatrixX& jacobian);
+
+  //! the error at the linearization point
+  const VectorX& error0() const { return error0_; }
+  //! the fixed Jacobian with respect to all the vertices
+  const MatrixX& jacobian() const { return jacobian_; }
+
+  void computeError() override;
+  void linearizeOplus() override;
+
+  bool read(std::istream& is) override;
+  bool write(std::ostream& os) const override;
+
+ protected:
+  //! the estimate data of a vertex at the linearization point
+  struct LinearizationPoint {
+    bool minimal = false;  ///< data from getMinimalEstimateData()
+    VectorX data;          ///< the data d0
+    MatrixX chart;         ///< maps a difference of the data to delta
+  };
+
+  std::vector<LinearizationPoint> linearizationPoint_;
+  VectorX error0_;
+  MatrixX jacobian_;
+
+  static bool estimateData(const OptimizableGraph::Vertex* v, bool minimal,
+                           VectorX& data);
+};
+
+}  // namespace g2o
+
+#endif
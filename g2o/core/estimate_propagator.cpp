@@ -117,10 +117,8 @@ void EstimatePropagator::propagate(
 
     /* std::pair< OptimizableGraph::VertexSet::iterator, bool> insertResult = */
     visited_.insert(u);
-    auto et = u->edges().begin();
-    while (et != u->edges().end()) {
-      auto edge = std::static_pointer_cast<OptimizableGraph::Edge>(et->lock());
-      ++et;
+    for (HyperGraph::Edge* uEdge : u->adjacentEdges()) {
+      auto* edge = static_cast<OptimizableGraph::Edge*>(uEdge);
 
       int maxFrontier = -1;
       OptimizableGraph::VertexSet initializedVertices;
@@ -144,7 +142,7 @@ void EstimatePropagator::propagate(
         const size_t wasInitialized = initializedVertices.erase(z);
 
         const number_t edgeDistance =
-            cost(edge.get(), initializedVertices, z.get());
+            cost(edge, initializedVertices, z.get());
         if (edgeDistance > 0. &&
             edgeDistance != std::numeric_limits<number_t>::max() &&
             edgeDistance < maxEdgeCost) {
@@ -159,7 +157,8 @@ void EstimatePropagator::propagate(
             // cerr << "Updating" << endl;
             ot->second.distance_ = zDistance;
             ot->second.parent_ = initializedVertices;
-            ot->second.edge_ = edge;
+            ot->second.edge_ = std::static_pointer_cast<OptimizableGraph::Edge>(
+                edge->sharedThis());
             ot->second.frontierLevel_ = maxFrontier + 1;
             frontier.push(&ot->second);
           }
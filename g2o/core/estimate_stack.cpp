@@ -0,0 +1,97 @@
+// g2o - General Graph Optimization
+// Copyright (C) 2011 R. Kuemmerle, G. Grisetti, W. Burgard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "estimate_stack.h"
+
+#include <cassert>
+
+namespace g2o {
+
+EstimateStack::~EstimateStack() { clear(); }
+
+void EstimateStack::setVertices(const VertexContainer& vertices) {
+  while (depth_ > 0) discardTop();
+  vertices_ = vertices;
+  offsets_.resize(vertices_.size());
+  constexpr size_t kAlignment = OptimizableGraph::Vertex::kStateAlignment;
+  snapshotSize_ = 0;
+  for (size_t i = 0; i < vertices_.size(); ++i) {
+    const size_t stateSize = vertices_[i]->stateSize();
+    if (stateSize == 0) {
+      offsets_[i] = kOwnStack;
+      continue;
+    }
+    offsets_[i] = snapshotSize_;
+    snapshotSize_ += (stateSize + kAlignment - 1) / kAlignment * kAlignment;
+  }
+  for (auto& snapshot : snapshots_) snapshot.resize(snapshotSize_);
+}
+
+void EstimateStack::push() {
+  if (depth_ == static_cast<int>(snapshots_.size()))
+    snapshots_.emplace_back(snapshotSize_);
+  uint8_t* data = snapshots_[depth_].data();
+  for (size_t i = 0; i < vertices_.size(); ++i) {
+    if (offsets_[i] == kOwnStack)
+      vertices_[i]->push();
+    else
+      vertices_[i]->saveState(data + offsets_[i]);
+  }
+  ++depth_;
+}
+
+void EstimateStack::pop() {
+  assert(depth_ > 0 && "pop() on an empty stack");
+  --depth_;
+  uint8_t* data = snapshots_[depth_].data();
+  for (size_t i = 0; i < vertices_.size(); ++i) {
+    if (offsets_[i] == kOwnStack)
+      vertices_[i]->pop();
+    else
+      vertices_[i]->restoreState(data + offsets_[i]);
+  }
+}
+
+void EstimateStack::discardTop() {
+  assert(depth_ > 0 && "discardTop() on an empty stack");
+  --depth_;
+  uint8_t* data = snapshots_[depth_].data();
+  for (size_t i = 0; i < vertices_.size(); ++i) {
+    if (offsets_[i] == kOwnStack)
+      vertices_[i]->discardTop();
+    else
+      vertices_[i]->discardState(data + offsets_[i]);
+  }
+}
+
+void EstimateStack::clear() {
+  while (depth_ > 0) discardTop();
+  vertices_.clear();
+  offsets_.clear();
+  snapshotSize_ = 0;
+}
+
+}  // namespace g2o
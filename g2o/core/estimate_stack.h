@@ -0,0 +1,97 @@
+// g2o - General Graph Optimization
+// Copyright (C) 2011 R. Kuemmerle, G. Grisetti, W. Burgard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef G2O_ESTIMATE_STACK_H
+#define G2O_ESTIMATE_STACK_H
+
+#include <Eigen/Core>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "g2o_core_api.h"
+#include "optimizable_graph.h"
+
+namespace g2o {
+
+/**
+ * \brief Stack of snapshots of the estimates of a set of vertices
+ *
+ * Instead of pushing the estimate of each vertex onto its own stack, see
+ * OptimizableGraph::Vertex::push(), a snapshot of all the estimates is saved
+ * into one contiguous buffer. The buffers of popped snapshots are kept and
+ * reused by the next push(), hence alternating push() and pop() as done by
+ * the optimization algorithms does not allocate memory for vertices with a
+ * fixed-size estimate.
+ *
+ * Vertices which do not support saving their state, i.e., returning 0 by
+ * OptimizableGraph::Vertex::stateSize(), are pushed onto their own stack.
+ */
+class G2O_CORE_API EstimateStack {
+ public:
+  using VertexContainer =
+      std::vector<std::shared_ptr<OptimizableGraph::Vertex>>;
+
+  EstimateStack() = default;
+  EstimateStack(const EstimateStack&) = delete;
+  EstimateStack& operator=(const EstimateStack&) = delete;
+  ~EstimateStack();
+
+  /**
+   * set the vertices saved by the following calls of push(). Snapshots still
+   * on the stack are discarded.
+   */
+  void setVertices(const VertexContainer& vertices);
+  const VertexContainer& vertices() const { return vertices_; }
+
+  //! save the estimates of the vertices
+  void push();
+  //! restore the estimates of the vertices from the last snapshot
+  void pop();
+  //! drop the last snapshot without restoring the estimates
+  void discardTop();
+  //! number of snapshots on the stack
+  int size() const { return depth_; }
+
+  //! discards all snapshots and forgets the vertices
+  void clear();
+
+ protected:
+  using Buffer = std::vector<uint8_t, Eigen::aligned_allocator<uint8_t>>;
+  //! offset of a vertex which is pushed onto its own stack
+  static constexpr size_t kOwnStack = static_cast<size_t>(-1);
+
+  VertexContainer vertices_;
+  std::vector<size_t> offsets_;  ///< offset of the state of each vertex
+  size_t snapshotSize_ = 0;      ///< number of bytes of one snapshot
+  std::vector<Buffer> snapshots_;
+  int depth_ = 0;
+};
+
+}  // namespace g2o
+
+#endif
@@ -26,7 +26,10 @@
 
 #include "factory.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdint>
 #include <iostream>
 #include <typeinfo>
 
@@ -43,6 +46,22 @@ using std::endl;
 
 std::unique_ptr<Factory> Factory::factoryInstance_;
 
+namespace {
+/**
+ * the type ids of the last types looked up by a thread. The entries are only
+ * valid for the generation of the factory at the time of filling them.
+ */
+struct TypeIdCache {
+  static constexpr size_t kSize = 16;
+  uint64_t generation = 0;
+  const std::type_info* types[kSize] = {};
+  int ids[kSize] = {};
+};
+thread_local TypeIdCache typeIdCache;
+//! source of the generations of all factories, a generation is never reused
+std::atomic<uint64_t> generationCounter{0};
+}  // namespace
+
 Factory* Factory::instance() {
   if (factoryInstance_ == nullptr) {
     factoryInstance_.reset(new Factory);
@@ -62,12 +81,6 @@ void Factory::registerType(
     cerr << "FACTORY WARNING: Overwriting Vertex tag " << tag << endl;
     assert(0);
   }
-  const TagLookup::const_iterator tagIt = tagLookup_.find(c->name());
-  if (tagIt != tagLookup_.end()) {
-    cerr << "FACTORY WARNING: Registering same class for two tags " << c->name()
-         << endl;
-    assert(0);
-  }
 
 #ifdef G2O_DEBUG_FACTORY
   cerr << "# Factory " << (void*)this << " constructing type " << tag << " ";
@@ -102,12 +115,24 @@ void Factory::registerType(
   cerr << endl;
 #endif
 
+  if (foundIt != creator_.end()) unregisterType(tag);
+  const std::type_index type(typeid(*element));
+  if (typeLookup_.count(type) != 0) {
+    cerr << "FACTORY WARNING: Registering same class for two tags " << c->name()
+         << endl;
+    assert(0);
+  }
+
   std::unique_ptr<CreatorInformation> ci =
       std::make_unique<CreatorInformation>();
   ci->elementTypeBit = element->elementType();
   ci->creator = std::move(c);
-  tagLookup_[ci->creator->name()] = tag;
+  ci->id = numTypeIds();
+  ci->tag = tag;
+  types_.push_back(ci.get());
+  typeLookup_[type] = ci->id;
   creator_[tag] = std::move(ci);
+  generation_ = ++generationCounter;
 }
 
 void Factory::unregisterType(const std::string& tag) {
@@ -115,14 +140,17 @@ void Factory::unregisterType(const std::string& tag) {
   auto tagPosition = creator_.find(tag);
 
   if (tagPosition != creator_.end()) {
-    const auto& c = tagPosition->second->creator;
-
-    // If we found it, remove the creator from the tag lookup map
-    auto classPosition = tagLookup_.find(c->name());
-    if (classPosition != tagLookup_.end()) {
-      tagLookup_.erase(classPosition);
+    // If we found it, remove the creator from the type lookup map
+    const int id = tagPosition->second->id;
+    for (auto it = typeLookup_.begin(); it != typeLookup_.end(); ++it) {
+      if (it->second == id) {
+        typeLookup_.erase(it);
+        break;
+      }
     }
+    types_[id] = nullptr;
     creator_.erase(tagPosition);
+    generation_ = ++generationCounter;
   }
 }
 
@@ -137,16 +165,65 @@ std::unique_ptr<HyperGraph::HyperGraphElement> Factory::construct(
   return nullptr;
 }
 
+AbstractHyperGraphElementCreator* Factory::creator(
+    const std::string& tag) const {
+  auto foundIt = creator_.find(tag);
+  if (foundIt == creator_.end()) return nullptr;
+  return foundIt->second->creator.get();
+}
+
 const std::string& Factory::tag(const HyperGraph::HyperGraphElement* e) const {
+  return tag(typeId(e));
+}
+
+int Factory::typeId(const std::string& tag) const {
+  auto foundIt = creator_.find(tag);
+  return foundIt == creator_.end() ? -1 : foundIt->second->id;
+}
+
+int Factory::typeId(const HyperGraph::HyperGraphElement* e) const {
+  const std::type_info& type = typeid(*e);
+  TypeIdCache& cache = typeIdCache;
+  if (cache.generation != generation_) {
+    cache = TypeIdCache();
+    cache.generation = generation_;
+  }
+  const size_t slot =
+      (reinterpret_cast<uintptr_t>(&type) >> 4) % TypeIdCache::kSize;
+  if (cache.types[slot] == &type) return cache.ids[slot];
+  auto foundIt = typeLookup_.find(std::type_index(type));
+  const int id = foundIt == typeLookup_.end() ? -1 : foundIt->second;
+  cache.types[slot] = &type;
+  cache.ids[slot] = id;
+  return id;
+}
+
+std::unique_ptr<HyperGraph::HyperGraphElement> Factory::construct(
+    int id) const {
+  const CreatorInformation* ci = information(id);
+  return ci ? ci->creator->construct() : nullptr;
+}
+
+const std::string& Factory::tag(int id) const {
   static const std::string kEmptyStr;
-  auto foundIt = tagLookup_.find(typeid(*e).name());
-  if (foundIt != tagLookup_.end()) return foundIt->second;
-  return kEmptyStr;
+  const CreatorInformation* ci = information(id);
+  return ci ? ci->tag : kEmptyStr;
+}
+
+int Factory::elementType(int id) const {
+  const CreatorInformation* ci = information(id);
+  return ci ? ci->elementTypeBit : -1;
+}
+
+AbstractHyperGraphElementCreator* Factory::creator(int id) const {
+  const CreatorInformation* ci = information(id);
+  return ci ? ci->creator.get() : nullptr;
 }
 
 void Factory::fillKnownTypes(std::vector<std::string>& types) const {
   types.clear();
   for (const auto& it : creator_) types.push_back(it.first);
+  std::sort(types.begin(), types.end());
 }
 
 bool Factory::knowsTag(const std::string& tag, int* elementType) const {
@@ -167,9 +244,11 @@ void Factory::destroy() {
 void Factory::printRegisteredTypes(std::ostream& os, bool comment) const {
   if (comment) os << "# ";
   os << "types:" << endl;
-  for (const auto& it : creator_) {
+  std::vector<std::string> types;
+  fillKnownTypes(types);
+  for (const auto& type : types) {
     if (comment) os << "#";
-    cerr << "\t" << it.first << endl;
+    cerr << "\t" << type << endl;
   }
 }
 
@@ -27,10 +27,13 @@
 #ifndef G2O_FACTORY_H
 #define G2O_FACTORY_H
 
+#include <cstdint>
 #include <iostream>
-#include <map>
 #include <memory>
 #include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
 
 #include "creators.h"
 #include "g2o/config.h"
@@ -82,6 +85,12 @@ class G2O_CORE_API Factory {
       const std::string& tag,
       const HyperGraph::GraphElemBitset& elemsToConstruct) const;
 
+  /**
+   * return the creator for a tag or nullptr if the tag is unknown. Allows to
+   * construct many elements of the same type with a single look-up.
+   */
+  AbstractHyperGraphElementCreator* creator(const std::string& tag) const;
+
   /**
    * return whether the factory knows this tag or not
    */
@@ -90,6 +99,31 @@ class G2O_CORE_API Factory {
   //! return the TAG given a vertex
   const std::string& tag(const HyperGraph::HyperGraphElement* e) const;
 
+  /**
+   * Each registered type has a dense integer id in [0, numTypeIds()), which
+   * is kept until the type is unregistered. The functions below allow to
+   * identify the type of an element once, e.g., per line of a file, and to
+   * work with the id afterwards.
+   */
+  //! id of the type registered for tag, -1 if the tag is unknown
+  int typeId(const std::string& tag) const;
+  /**
+   * id of the type of the element, -1 if the type is not registered. The
+   * last types looked up by a thread are cached, hence this is cheap to call
+   * per element.
+   */
+  int typeId(const HyperGraph::HyperGraphElement* e) const;
+  //! upper bound for the ids of the registered types
+  int numTypeIds() const { return static_cast<int>(types_.size()); }
+  //! construct an element of the given type, nullptr for an invalid id
+  std::unique_ptr<HyperGraph::HyperGraphElement> construct(int id) const;
+  //! the tag of the type, the empty string for an invalid id
+  const std::string& tag(int id) const;
+  //! the element type of the type, see HyperGraph::HyperGraphElementType
+  int elementType(int id) const;
+  //! the creator of the type, nullptr for an invalid id
+  AbstractHyperGraphElementCreator* creator(int id) const;
+
   /**
    * get a list of all known types
    */
@@ -105,14 +139,25 @@ class G2O_CORE_API Factory {
    public:
     std::unique_ptr<AbstractHyperGraphElementCreator> creator;
     int elementTypeBit = -1;
+    int id = -1;  ///< index in types_
+    std::string tag;
   };
 
-  using CreatorMap = std::map<std::string, std::unique_ptr<CreatorInformation>>;
-  using TagLookup = std::map<std::string, std::string>;
+  using CreatorMap =
+      std::unordered_map<std::string, std::unique_ptr<CreatorInformation>>;
+  using TypeLookup = std::unordered_map<std::type_index, int>;
   Factory() = default;
 
-  CreatorMap creator_;   ///< look-up map for the existing creators
-  TagLookup tagLookup_;  ///< reverse look-up, class name to tag
+  const CreatorInformation* information(int id) const {
+    return id >= 0 && id < numTypeIds() ? types_[id] : nullptr;
+  }
+
+  CreatorMap creator_;     ///< look-up map for the existing creators
+  TypeLookup typeLookup_;  ///< reverse look-up, class to type id
+  //! the registered types by id, nullptr for unregistered ones
+  std::vector<CreatorInformation*> types_;
+  //! changed by (un)registering a type, invalidates the per-thread caches
+  uint64_t generation_ = 0;
 
  private:
   static std::unique_ptr<Factory> factoryInstance_;
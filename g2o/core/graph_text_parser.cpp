@@ -0,0 +1,710 @@
+// g2o - General Graph Optimization
+// Copyright (C) 2011 R. Kuemmerle, G. Grisetti, W. Burgard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "graph_text_parser.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <typeinfo>
+
+#include "factory.h"
+#include "g2o/stuff/color_macros.h"
+#include "g2o/stuff/filesys_tools.h"
+
+#ifdef WINDOWS
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace g2o {
+
+using std::cerr;
+using std::endl;
+
+namespace {
+
+//! chunks smaller than this are not worth a task
+constexpr size_t kMinChunkSize = 1 << 16;
+constexpr size_t kMaxChunkSize = 1 << 20;
+//! number of chunks per thread parsed before adding them to the graph
+constexpr int kChunksPerThread = 4;
+
+//! powers of ten which are exactly representable as double
+constexpr double kExactPowersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+constexpr int kMaxExactPower = 22;
+//! largest integer such that all smaller ones are exactly representable
+constexpr uint64_t kMaxExactMantissa = uint64_t(1) << 53;
+//! number of decimal digits which always fit into uint64_t
+constexpr int kMaxMantissaDigits = 19;
+
+inline bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' ||
+         c == '\f';
+}
+
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+std::ostream& printIdChain(std::ostream& os, const int* begin,
+                           const int* end) {
+  for (const int* it = begin; it != end; ++it) {
+    if (it != begin) os << " <->";
+    os << " " << *it;
+  }
+  return os;
+}
+
+}  // namespace
+
+FastNumGet::iter_type FastNumGet::do_get(iter_type in, iter_type end,
+                                         std::ios_base& str,
+                                         std::ios_base::iostate& err,
+                                         long& v) const {
+  const std::ios_base::fmtflags base =
+      str.flags() & std::ios_base::basefield;
+  if (base != std::ios_base::dec)
+    return std::num_get<char>::do_get(in, end, str, err, v);
+  bool negative = false;
+  if (in != end && (*in == '-' || *in == '+')) {
+    negative = *in == '-';
+    ++in;
+  }
+  uint64_t value = 0;
+  bool anyDigit = false;
+  bool overflow = false;
+  for (; in != end && isDigit(*in); ++in) {
+    anyDigit = true;
+    const auto digit = static_cast<uint64_t>(*in - '0');
+    if (value > (std::numeric_limits<uint64_t>::max() - digit) / 10)
+      overflow = true;
+    else
+      value = value * 10 + digit;
+  }
+  const auto limit =
+      static_cast<uint64_t>(std::numeric_limits<long>::max()) + negative;
+  if (!anyDigit) {
+    v = 0;
+    err = std::ios_base::failbit;
+  } else if (overflow || value > limit) {
+    v = negative ? std::numeric_limits<long>::min()
+                 : std::numeric_limits<long>::max();
+    err = std::ios_base::failbit;
+  } else {
+    err = std::ios_base::goodbit;
+    v = negative ? static_cast<long>(0 - value) : static_cast<long>(value);
+  }
+  if (in == end) err |= std::ios_base::eofbit;
+  return in;
+}
+
+FastNumGet::iter_type FastNumGet::do_get(iter_type in, iter_type end,
+                                         std::ios_base& str,
+                                         std::ios_base::iostate& err,
+                                         float& v) const {
+  double value;
+  in = do_get(in, end, str, err, value);
+  if (std::abs(value) > std::numeric_limits<float>::max()) {
+    v = value > 0 ? std::numeric_limits<float>::max()
+                  : -std::numeric_limits<float>::max();
+    err |= std::ios_base::failbit;
+  } else {
+    v = static_cast<float>(value);
+  }
+  return in;
+}
+
+FastNumGet::iter_type FastNumGet::do_get(iter_type in, iter_type end,
+                                         std::ios_base& /*str*/,
+                                         std::ios_base::iostate& err,
+                                         double& v) const {
+  // the accepted characters are kept for the fall-back to strtod()
+  constexpr int kMaxLength = 128;
+  char text[kMaxLength + 1];
+  int length = 0;
+  auto accept = [&]() {
+    if (length < kMaxLength) text[length] = *in;
+    ++length;
+    ++in;
+  };
+
+  bool negative = false;
+  if (in != end && (*in == '-' || *in == '+')) {
+    negative = *in == '-';
+    accept();
+  }
+  uint64_t mantissa = 0;
+  int digits = 0;  // significant digits in mantissa
+  int exponent = 0;
+  bool truncated = false;
+  bool anyDigit = false;
+  for (; in != end && isDigit(*in); accept()) {
+    anyDigit = true;
+    const int digit = *in - '0';
+    if (mantissa == 0 && digit == 0) continue;
+    if (digits < kMaxMantissaDigits) {
+      mantissa = mantissa * 10 + digit;
+      ++digits;
+    } else {
+      ++exponent;
+      truncated |= digit != 0;
+    }
+  }
+  if (in != end && *in == '.') {
+    accept();
+    for (; in != end && isDigit(*in); accept()) {
+      anyDigit = true;
+      const int digit = *in - '0';
+      if (mantissa == 0 && digit == 0) {
+        --exponent;
+      } else if (digits < kMaxMantissaDigits) {
+        mantissa = mantissa * 10 + digit;
+        ++digits;
+        --exponent;
+      } else {
+        truncated |= digit != 0;
+      }
+    }
+  }
+  if (!anyDigit) {
+    v = 0;
+    err = std::ios_base::failbit;
+    if (in == end) err |= std::ios_base::eofbit;
+    return in;
+  }
+  if (in != end && (*in == 'e' || *in == 'E')) {
+    accept();
+    bool negativeExponent = false;
+    if (in != end && (*in == '-' || *in == '+')) {
+      negativeExponent = *in == '-';
+      accept();
+    }
+    if (in == end || !isDigit(*in)) {
+      v = 0;
+      err = std::ios_base::failbit;
+      if (in == end) err |= std::ios_base::eofbit;
+      return in;
+    }
+    int e = 0;
+    for (; in != end && isDigit(*in); accept()) {
+      if (e < 100000) e = e * 10 + (*in - '0');
+    }
+    exponent += negativeExponent ? -e : e;
+  }
+  err = in == end ? std::ios_base::eofbit : std::ios_base::goodbit;
+
+  if (mantissa == 0) {
+    v = negative ? -0. : 0.;
+    return in;
+  }
+  // Clinger's fast path, the mantissa and the power of ten are exact
+  if (!truncated && mantissa <= kMaxExactMantissa &&
+      std::abs(exponent) <= kMaxExactPower) {
+    double value = static_cast<double>(mantissa);
+    if (exponent < 0)
+      value /= kExactPowersOfTen[-exponent];
+    else
+      value *= kExactPowersOfTen[exponent];
+    v = negative ? -value : value;
+    return in;
+  }
+
+  double value;
+  if (length <= kMaxLength) {
+    text[length] = '\0';
+    value = std::strtod(text, nullptr);
+  } else {
+    value = static_cast<double>(mantissa * std::pow(10.0L, exponent));
+    if (negative) value = -value;
+  }
+  if (std::isinf(value)) {
+    v = value > 0 ? std::numeric_limits<double>::max()
+                  : -std::numeric_limits<double>::max();
+    err |= std::ios_base::failbit;
+  } else {
+    v = value;
+  }
+  return in;
+}
+
+GraphTextParser::Worker::Worker(const std::locale& locale) : stream(&buffer) {
+  stream.imbue(locale);
+}
+
+GraphTextParser::GraphTextParser(OptimizableGraph& graph)
+    : graph_(graph), locale_(std::locale::classic(), new FastNumGet) {}
+
+GraphTextParser::~GraphTextParser() = default;
+
+void GraphTextParser::clearAdded() {
+  addedVertices_.clear();
+  addedEdges_.clear();
+}
+
+bool GraphTextParser::parse(const char* data, size_t size,
+                            ParallelExecutor& executor) {
+  const int numThreads = std::max(executor.numThreads(), 1);
+  while (static_cast<int>(workers_.size()) < numThreads)
+    workers_.emplace_back(g2o::make_unique<Worker>(locale_));
+
+  const size_t chunkSize = std::min(
+      kMaxChunkSize,
+      std::max(kMinChunkSize, size / (numThreads * kChunksPerThread)));
+  const int chunksPerWave = numThreads * kChunksPerThread;
+  const char* current = data;
+  const char* const end = data + size;
+  while (current != end) {
+    // split the next part of the input at line ends
+    int numChunks = 0;
+    for (; numChunks < chunksPerWave && current != end; ++numChunks) {
+      if (static_cast<int>(chunks_.size()) <= numChunks) chunks_.emplace_back();
+      Chunk& chunk = chunks_[numChunks];
+      chunk.begin = current;
+      if (static_cast<size_t>(end - current) <= chunkSize) {
+        current = end;
+      } else {
+        const char* newline = static_cast<const char*>(
+            std::memchr(current + chunkSize, '\n',
+                        end - current - chunkSize));
+        current = newline ? newline + 1 : end;
+      }
+      chunk.end = current;
+    }
+
+    executor.parallelFor(numChunks, 1, [&](int begin, int last, int thread) {
+      for (int i = begin; i < last; ++i)
+        parseChunk(chunks_[i], *workers_[thread]);
+    });
+    for (int i = 0; i < numChunks; ++i) {
+      addRecords(chunks_[i]);
+      lineNumber_ += chunks_[i].numLines;
+      chunks_[i].records.clear();
+      chunks_[i].ids.clear();
+    }
+  }
+  return true;
+}
+
+void GraphTextParser::parseChunk(Chunk& chunk, Worker& worker) const {
+  chunk.numLines = 0;
+  chunk.records.clear();
+  chunk.ids.clear();
+  const char* current = chunk.begin;
+  while (current != chunk.end) {
+    const char* newline = static_cast<const char*>(
+        std::memchr(current, '\n', chunk.end - current));
+    const char* lineEnd = newline ? newline : chunk.end;
+    parseLine(current, lineEnd, chunk, worker);
+    chunk.numLines++;
+    current = newline ? newline + 1 : chunk.end;
+  }
+}
+
+void GraphTextParser::parseLine(const char* begin, const char* end,
+                                Chunk& chunk, Worker& worker) const {
+  while (begin != end && isSpace(*begin)) ++begin;
+  if (begin == end || *begin == '#') return;
+  const char* tagEnd = begin;
+  while (tagEnd != end && !isSpace(*tagEnd)) ++tagEnd;
+
+  chunk.records.emplace_back();
+  Record& record = chunk.records.back();
+  record.line = chunk.numLines;
+  record.restBegin = tagEnd;
+  record.restEnd = end;
+  if (tagEnd - begin == 3 && std::equal(begin, tagEnd, "FIX")) {
+    record.kind = Record::kFix;
+    return;
+  }
+
+  // look-up the type unless it is the same as in the previous line
+  if (worker.fileTag.size() != static_cast<size_t>(tagEnd - begin) ||
+      !std::equal(begin, tagEnd, worker.fileTag.begin())) {
+    worker.fileTag.assign(begin, tagEnd);
+    worker.tag = worker.fileTag;
+    const auto& renamedTypes = graph_.renamedTypes();
+    if (!renamedTypes.empty()) {
+      auto foundIt = renamedTypes.find(worker.tag);
+      if (foundIt != renamedTypes.end()) worker.tag = foundIt->second;
+    }
+    Factory* factory = Factory::instance();
+    const int typeId = factory->typeId(worker.tag);
+    worker.elementType = factory->elementType(typeId);
+    worker.creator = factory->creator(typeId);
+  }
+  record.tag = worker.tag;
+  if (!worker.creator) {
+    record.kind = Record::kUnknown;
+    return;
+  }
+  // elements without a type bit are not constructed by load() either
+  if (worker.elementType < 0) {
+    chunk.records.pop_back();
+    return;
+  }
+
+  std::istream& is = worker.stream;
+  worker.buffer.set(tagEnd, end);
+  is.clear();
+  std::shared_ptr<HyperGraph::HyperGraphElement> element =
+      worker.creator->construct();
+  switch (worker.elementType) {
+    case HyperGraph::kHgetParameter: {
+      auto* p = static_cast<Parameter*>(element.get());
+      is >> record.id;
+      p->setId(record.id);
+      record.kind = Record::kParameter;
+      record.readOk = p->read(is);
+      break;
+    }
+    case HyperGraph::kHgetVertex: {
+      auto* v = static_cast<OptimizableGraph::Vertex*>(element.get());
+      is >> record.id;
+      record.kind = Record::kVertex;
+      record.readOk = v->read(is);
+      v->setId(record.id);
+      break;
+    }
+    case HyperGraph::kHgetEdge: {
+      auto* e = static_cast<OptimizableGraph::Edge*>(element.get());
+      record.kind = Record::kEdge;
+      const size_t numV = e->vertices().size();
+      if (numV == 0) {
+        // the ids are parsed by addEdge() before calling read()
+        record.deferred = true;
+        break;
+      }
+      record.idsBegin = chunk.ids.size();
+      chunk.ids.resize(record.idsBegin + numV);
+      for (size_t l = 0; l < numV; ++l) is >> chunk.ids[record.idsBegin + l];
+      record.idsEnd = chunk.ids.size();
+      record.readOk = e->read(is);
+      break;
+    }
+    case HyperGraph::kHgetData: {
+      auto* d = static_cast<HyperGraph::Data*>(element.get());
+      record.kind = Record::kData;
+      record.readOk = d->read(is);
+      break;
+    }
+    default:
+      chunk.records.pop_back();
+      return;
+  }
+  record.element = std::move(element);
+}
+
+void GraphTextParser::addRecords(const Chunk& chunk) {
+  std::istream& is = workers_.front()->stream;
+  for (const Record& record : chunk.records) {
+    const int lineNumber = lineNumber_ + record.line + 1;
+    switch (record.kind) {
+      case Record::kFix: {
+        workers_.front()->buffer.set(record.restBegin, record.restEnd);
+        is.clear();
+        int id;
+        while (is >> id) {
+          auto v = graph_.vertex(id);
+          if (v) {
+#ifndef NDEBUG
+            cerr << "Fixing vertex " << v->id() << endl;
+#endif
+            v->setFixed(true);
+          } else {
+            cerr << "Warning: Unable to fix vertex with id " << id
+                 << ". Not found in the graph." << endl;
+          }
+        }
+        break;
+      }
+      case Record::kUnknown:
+        if (warnedUnknownTypes_.count(record.tag) != 1) {
+          warnedUnknownTypes_.insert(record.tag);
+          cerr << CL_RED(__PRETTY_FUNCTION__ << " unknown type: " << record.tag)
+               << endl;
+        }
+        break;
+      case Record::kParameter: {
+        if (!record.readOk) {
+          cerr << __PRETTY_FUNCTION__ << ": Error reading data " << record.tag
+               << " for parameter " << record.id << " at line " << lineNumber
+               << endl;
+        } else if (!graph_.parameters().addParameter(
+                       std::static_pointer_cast<Parameter>(record.element))) {
+          cerr << __PRETTY_FUNCTION__ << ": Parameter of type:" << record.tag
+               << " id:" << record.id << " already defined"
+               << " at line " << lineNumber << endl;
+        }
+        break;
+      }
+      case Record::kVertex: {
+        previousData_ = nullptr;
+        auto v =
+            std::static_pointer_cast<OptimizableGraph::Vertex>(record.element);
+        if (!record.readOk)
+          cerr << __PRETTY_FUNCTION__ << ": Error reading vertex "
+               << record.tag << " " << record.id << " at line " << lineNumber
+               << endl;
+        if (updateVertices_ && updateVertex(record, lineNumber)) break;
+        if (!graph_.addVertex(v)) {
+          cerr << __PRETTY_FUNCTION__ << ": Failure adding Vertex, "
+               << record.tag << " " << record.id << " at line " << lineNumber
+               << endl;
+        } else {
+          previousDataContainer_ = v;
+          if (collectAdded_) addedVertices_.insert(v);
+        }
+        break;
+      }
+      case Record::kEdge:
+        addEdge(record, chunk, lineNumber);
+        break;
+      case Record::kData:
+        addData(record, lineNumber);
+        break;
+    }
+  }
+}
+
+void GraphTextParser::addEdge(const Record& record, const Chunk& chunk,
+                              int lineNumber) {
+  previousData_ = nullptr;
+  auto e = std::static_pointer_cast<OptimizableGraph::Edge>(record.element);
+  std::vector<int> dynamicIds;
+  const int* idsBegin = chunk.ids.data() + record.idsBegin;
+  const int* idsEnd = chunk.ids.data() + record.idsEnd;
+  std::istream& is = workers_.front()->stream;
+  if (record.deferred) {
+    // same parsing of the ids as in OptimizableGraph::load()
+    workers_.front()->buffer.set(record.restBegin, record.restEnd);
+    is.clear();
+    const int numV = e->vertices().size();
+    std::string buff;
+    while (is >> buff) {
+      if (buff == "||") break;
+      dynamicIds.push_back(atoi(buff.c_str()));
+      is >> buff;
+    }
+    e->resize(numV);
+    idsBegin = dynamicIds.data();
+    idsEnd = idsBegin + dynamicIds.size();
+  }
+
+  bool vertsOkay = true;
+  for (const int* it = idsBegin; it != idsEnd; ++it) {
+    if (*it == HyperGraph::kUnassignedId) continue;
+    auto v = graph_.vertex(*it);
+    if (!v) {
+      vertsOkay = false;
+      break;
+    }
+    e->setVertex(it - idsBegin, v);
+  }
+  if (!vertsOkay) {
+    cerr << __PRETTY_FUNCTION__ << ": Unable to find vertices for edge "
+         << record.tag << " at line " << lineNumber << " IDs: ";
+    printIdChain(cerr, idsBegin, idsEnd) << std::endl;
+    e = nullptr;
+  } else {
+    const bool r = record.deferred ? e->read(is) : record.readOk;
+    if (!r || !graph_.addEdge(e)) {
+      cerr << __PRETTY_FUNCTION__ << ": Unable to add edge " << record.tag
+           << " at line " << lineNumber << " IDs: ";
+      printIdChain(cerr, idsBegin, idsEnd) << std::endl;
+      e = nullptr;
+    } else if (collectAdded_) {
+      addedEdges_.insert(e);
+    }
+  }
+  previousDataContainer_ = e;
+}
+
+bool GraphTextParser::updateVertex(const Record& record, int lineNumber) {
+  auto existing = graph_.vertex(record.id);
+  if (!existing) return false;
+  // the user data of the vertex is not repeated
+  previousDataContainer_ = nullptr;
+  auto* v = static_cast<OptimizableGraph::Vertex*>(record.element.get());
+  if (typeid(*existing) != typeid(*v)) {
+    cerr << __PRETTY_FUNCTION__ << ": Unable to update vertex " << record.id
+         << " by " << record.tag << " at line " << lineNumber << endl;
+    return true;
+  }
+  const int dim = v->estimateDimension();
+  if (dim >= 0) {
+    estimate_.resize(dim);
+    v->getEstimateData(estimate_.data());
+    existing->setEstimateData(estimate_.data());
+  } else {
+    // no access to the estimate, read the line again into the vertex
+    std::istream& is = workers_.front()->stream;
+    workers_.front()->buffer.set(record.restBegin, record.restEnd);
+    is.clear();
+    int id;
+    is >> id;
+    existing->read(is);
+  }
+  return true;
+}
+
+void GraphTextParser::addData(const Record& record, int lineNumber) {
+  auto d = std::static_pointer_cast<HyperGraph::Data>(record.element);
+  if (!record.readOk) {
+    cerr << __PRETTY_FUNCTION__ << ": Error reading data " << record.tag
+         << " at line " << lineNumber << " IDs: " << endl;
+    previousData_ = nullptr;
+  } else if (previousData_) {
+    previousData_->setNext(d);
+    d->setDataContainer(previousData_->dataContainer());
+    previousData_ = d.get();
+  } else if (previousDataContainer_) {
+    previousDataContainer_->setUserData(d);
+    d->setDataContainer(previousDataContainer_);
+    previousData_ = d.get();
+    previousDataContainer_ = nullptr;
+  } else {
+    cerr << __PRETTY_FUNCTION__
+         << ": got data element, but no data container available" << endl;
+    previousData_ = nullptr;
+  }
+}
+
+GraphStreamReader::GraphStreamReader(OptimizableGraph& graph,
+                                     std::istream& is)
+    : parser_(graph), is_(&is) {
+  parser_.setCollectAdded(true);
+}
+
+GraphStreamReader::GraphStreamReader(OptimizableGraph& graph, int fd)
+    : parser_(graph), fd_(fd) {
+  parser_.setCollectAdded(true);
+}
+
+bool GraphStreamReader::read(size_t n) {
+  n = std::max<size_t>(n, 1);
+  if (buffer_.size() < buffered_ + n) buffer_.resize(buffered_ + n);
+  char* data = buffer_.data() + buffered_;
+  if (is_) {
+    is_->read(data, n);
+    buffered_ += is_->gcount();
+    if (!*is_) atEnd_ = true;
+    return true;
+  }
+  while (true) {
+#ifdef WINDOWS
+    const auto bytesRead = ::_read(fd_, data, static_cast<unsigned int>(n));
+#else
+    const auto bytesRead = ::read(fd_, data, n);
+#endif
+    if (bytesRead > 0) {
+      buffered_ += bytesRead;
+      return true;
+    }
+    if (bytesRead < 0 && errno == EINTR) continue;
+    atEnd_ = true;
+    if (bytesRead < 0) {
+      cerr << __PRETTY_FUNCTION__ << ": error reading from file descriptor "
+           << fd_ << ": " << std::strerror(errno) << endl;
+      return false;
+    }
+    return true;
+  }
+}
+
+bool GraphStreamReader::next(HyperGraph::VertexSet& vertices,
+                             HyperGraph::EdgeSet& edges) {
+  vertices.clear();
+  edges.clear();
+  if (atEnd()) return false;
+
+  // read until the buffer holds a complete line or the input ends, only the
+  // data read by this call may contain a newline
+  size_t parseSize = 0;
+  while (parseSize == 0) {
+    const size_t searchBegin = buffered_;
+    if (!atEnd_ && !read(batchSize_) && buffered_ == 0) return false;
+    for (size_t i = buffered_; i > searchBegin; --i) {
+      if (buffer_[i - 1] == '\n') {
+        parseSize = i;
+        break;
+      }
+    }
+    if (atEnd_) {
+      parseSize = buffered_;
+      break;
+    }
+  }
+  if (parseSize == 0) return false;
+
+  parser_.clearAdded();
+  parser_.parse(buffer_.data(), parseSize, executor());
+  vertices.swap(parser_.addedVertices());
+  edges.swap(parser_.addedEdges());
+
+  // keep the incomplete last line for the next batch
+  std::copy(buffer_.begin() + parseSize, buffer_.begin() + buffered_,
+            buffer_.begin());
+  buffered_ -= parseSize;
+  return true;
+}
+
+bool OptimizableGraph::loadParallel(const char* data, size_t size,
+                                    ParallelExecutor& executor) {
+  GraphTextParser parser(*this);
+  const bool result = parser.parse(data, size, executor);
+#ifndef NDEBUG
+  cerr << "Loaded " << parameters_.size() << " parameters" << endl;
+#endif
+  return result;
+}
+
+bool OptimizableGraph::loadParallel(std::istream& is,
+                                    ParallelExecutor& executor) {
+  const std::string content((std::istreambuf_iterator<char>(is)),
+                            std::istreambuf_iterator<char>());
+  return loadParallel(content.data(), content.size(), executor);
+}
+
+bool OptimizableGraph::loadParallel(const char* filename,
+                                    ParallelExecutor& executor) {
+  if (isBinaryFile(filename)) return loadBinary(filename);
+  MappedFile file(filename);
+  if (!file.isOpen()) {
+    cerr << __PRETTY_FUNCTION__ << " unable to open file " << filename << endl;
+    return false;
+  }
+  return loadParallel(file.data(), file.size(), executor);
+}
+
+}  // namespace g2o
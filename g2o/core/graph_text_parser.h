@@ -0,0 +1,258 @@
+// g2o - General Graph Optimization
+// Copyright (C) 2011 R. Kuemmerle, G. Grisetti, W. Burgard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef G2O_GRAPH_TEXT_PARSER_H
+#define G2O_GRAPH_TEXT_PARSER_H
+
+#include <cstddef>
+#include <istream>
+#include <locale>
+#include <memory>
+#include <set>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "creators.h"
+#include "g2o_core_api.h"
+#include "hyper_graph.h"
+#include "optimizable_graph.h"
+#include "parallel_executor.h"
+
+namespace g2o {
+
+/**
+ * \brief Number parsing facet which does not depend on the locale
+ *
+ * Replaces the conversion of operator>> for integers and floating point
+ * numbers. Decimal numbers with at most 15 significant digits and a small
+ * exponent are converted exactly by a single multiplication or division,
+ * other numbers are handed to strtod().
+ */
+class G2O_CORE_API FastNumGet : public std::num_get<char> {
+ public:
+  explicit FastNumGet(size_t refs = 0) : std::num_get<char>(refs) {}
+
+ protected:
+  iter_type do_get(iter_type in, iter_type end, std::ios_base& str,
+                   std::ios_base::iostate& err, long& v) const override;
+  iter_type do_get(iter_type in, iter_type end, std::ios_base& str,
+                   std::ios_base::iostate& err, float& v) const override;
+  iter_type do_get(iter_type in, iter_type end, std::ios_base& str,
+                   std::ios_base::iostate& err, double& v) const override;
+};
+
+/**
+ * \brief Parses the text format of a graph on several threads
+ *
+ * The input is split into chunks of complete lines. The tokenizing, the
+ * construction of the elements and their read() run on the threads of an
+ * executor, the elements are afterwards added to the graph in the order of
+ * the input. Thus, FIX commands, parameters and user data chained to the
+ * preceding vertex or edge behave as in OptimizableGraph::load(). Edges with
+ * a varying number of vertices are read while being added.
+ *
+ * The state required to continue a graph, i.e., the line number and the
+ * element to which the following data is attached, is kept across calls of
+ * parse(). Hence, a graph may be parsed in several pieces of complete lines.
+ */
+class G2O_CORE_API GraphTextParser {
+ public:
+  explicit GraphTextParser(OptimizableGraph& graph);
+  ~GraphTextParser();
+  GraphTextParser(const GraphTextParser&) = delete;
+  GraphTextParser& operator=(const GraphTextParser&) = delete;
+
+  /**
+   * parse the lines in [data, data + size) and add the elements to the graph.
+   * The last line does not need to be terminated by a newline.
+   */
+  bool parse(const char* data, size_t size, ParallelExecutor& executor);
+
+  //! if true, the vertices and edges added to the graph are collected
+  bool collectAdded() const { return collectAdded_; }
+  void setCollectAdded(bool collectAdded) { collectAdded_ = collectAdded; }
+  //! the vertices added since the last call of clearAdded()
+  HyperGraph::VertexSet& addedVertices() { return addedVertices_; }
+  //! the edges added since the last call of clearAdded()
+  HyperGraph::EdgeSet& addedEdges() { return addedEdges_; }
+  void clearAdded();
+
+  //! number of lines parsed so far
+  int lineNumber() const { return lineNumber_; }
+
+  /**
+   * if true, a vertex whose id is already in the graph updates the estimate
+   * of the existing vertex instead of being rejected. Allows to apply the
+   * changes written by GraphTextWriter::saveChanges().
+   */
+  bool updateVertices() const { return updateVertices_; }
+  void setUpdateVertices(bool updateVertices) {
+    updateVertices_ = updateVertices;
+  }
+
+ protected:
+  //! an input line which yields an element or a command
+  struct Record {
+    enum Kind { kFix, kUnknown, kParameter, kVertex, kEdge, kData };
+    Kind kind = kUnknown;
+    bool readOk = false;
+    bool deferred = false;  ///< read() is called while adding the edge
+    int line = 0;           ///< line number relative to the chunk
+    int id = 0;             ///< id of a vertex or parameter
+    size_t idsBegin = 0;    ///< vertex ids of an edge in Chunk::ids
+    size_t idsEnd = 0;
+    const char* restBegin = nullptr;  ///< text following the ids
+    const char* restEnd = nullptr;
+    std::string tag;
+    std::shared_ptr<HyperGraph::HyperGraphElement> element;
+  };
+
+  struct Chunk {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    int numLines = 0;
+    std::vector<Record> records;
+    std::vector<int> ids;
+  };
+
+  //! reads from memory without copying it
+  class MemoryBuffer : public std::streambuf {
+   public:
+    void set(const char* begin, const char* end) {
+      char* b = const_cast<char*>(begin);
+      setg(b, b, const_cast<char*>(end));
+    }
+  };
+
+  //! per-thread state of the parsing
+  struct Worker {
+    explicit Worker(const std::locale& locale);
+    MemoryBuffer buffer;
+    std::istream stream;
+    std::string fileTag;  ///< tag of the last line as given in the input
+    std::string tag;      ///< the tag after renaming and its properties
+    AbstractHyperGraphElementCreator* creator = nullptr;
+    int elementType = -1;
+  };
+
+  void parseChunk(Chunk& chunk, Worker& worker) const;
+  void parseLine(const char* begin, const char* end, Chunk& chunk,
+                 Worker& worker) const;
+  void addRecords(const Chunk& chunk);
+  void addEdge(const Record& record, const Chunk& chunk, int lineNumber);
+  void addData(const Record& record, int lineNumber);
+  bool updateVertex(const Record& record, int lineNumber);
+
+  OptimizableGraph& graph_;
+  std::locale locale_;  ///< classic locale with FastNumGet
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<Chunk> chunks_;
+  std::set<std::string> warnedUnknownTypes_;
+  std::shared_ptr<HyperGraph::DataContainer> previousDataContainer_;
+  HyperGraph::Data* previousData_ = nullptr;
+  int lineNumber_ = 0;
+  bool collectAdded_ = false;
+  bool updateVertices_ = false;
+  std::vector<number_t> estimate_;  ///< temporary for updating a vertex
+  HyperGraph::VertexSet addedVertices_;
+  HyperGraph::EdgeSet addedEdges_;
+};
+
+/**
+ * \brief Reads a graph in the text format piece by piece
+ *
+ * Reads the input in batches of about batchSize() bytes, adds the elements
+ * of the complete lines of a batch to the graph and reports them, e.g., for
+ * SparseOptimizer::updateInitialization(). A line split by the end of a batch
+ * is carried over to the next one. Hence, the memory is bounded by the batch
+ * size and the longest line, independent of the length of the input.
+ *
+ * \code
+ * GraphStreamReader reader(optimizer, std::cin);
+ * HyperGraph::VertexSet vertices;
+ * HyperGraph::EdgeSet edges;
+ * while (reader.next(vertices, edges)) {
+ *   optimizer.updateInitialization(vertices, edges);
+ *   optimizer.optimize(1);
+ * }
+ * \endcode
+ */
+class G2O_CORE_API GraphStreamReader {
+ public:
+  //! read from a stream, a batch blocks until it is full or the stream ends
+  GraphStreamReader(OptimizableGraph& graph, std::istream& is);
+  /**
+   * read from a file descriptor, e.g., a pipe or a socket. A batch contains
+   * the data available at the time of the call, at least one complete line.
+   */
+  GraphStreamReader(OptimizableGraph& graph, int fd);
+
+  /**
+   * read the next batch and add its elements to the graph. vertices and edges
+   * are cleared and receive the added elements.
+   * @returns false if the input is exhausted or cannot be read.
+   */
+  bool next(HyperGraph::VertexSet& vertices, HyperGraph::EdgeSet& edges);
+
+  //! true if the end of the input has been reached
+  bool atEnd() const { return atEnd_ && buffered_ == 0; }
+
+  //! the number of bytes read from the input per batch
+  size_t batchSize() const { return batchSize_; }
+  void setBatchSize(size_t batchSize) { batchSize_ = batchSize; }
+
+  /**
+   * the executor for parsing the lines of a batch, if none is set
+   * ParallelExecutor::defaultExecutor() is used.
+   */
+  ParallelExecutor& executor() const {
+    return executor_ ? *executor_ : ParallelExecutor::defaultExecutor();
+  }
+  void setExecutor(const std::shared_ptr<ParallelExecutor>& executor) {
+    executor_ = executor;
+  }
+
+  //! number of lines read so far
+  int lineNumber() const { return parser_.lineNumber(); }
+
+ protected:
+  //! append up to n bytes of the input to the buffer
+  bool read(size_t n);
+
+  GraphTextParser parser_;
+  std::istream* is_ = nullptr;
+  int fd_ = -1;
+  std::vector<char> buffer_;
+  size_t buffered_ = 0;  ///< number of valid bytes in buffer_
+  size_t batchSize_ = 1 << 20;
+  bool atEnd_ = false;
+  std::shared_ptr<ParallelExecutor> executor_;
+};
+
+}  // namespace g2o
+
+#endif
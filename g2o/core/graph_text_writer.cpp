@@ -0,0 +1,365 @@
+// g2o - General Graph Optimization
+// Copyright (C) 2011 R. Kuemmerle, G. Grisetti, W. Burgard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "graph_text_writer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include "factory.h"
+
+namespace g2o {
+
+namespace {
+
+//! number of vertices or edges formatted by a task
+constexpr int kElementsPerChunk = 1024;
+//! number of chunks per thread formatted before writing them
+constexpr int kChunksPerThread = 4;
+
+//! powers of ten which are exactly representable as double
+constexpr double kExactPowersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,
+    1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17};
+constexpr uint64_t kIntegerPowersOfTen[] = {1ULL,
+                                            10ULL,
+                                            100ULL,
+                                            1000ULL,
+                                            10000ULL,
+                                            100000ULL,
+                                            1000000ULL,
+                                            10000000ULL,
+                                            100000000ULL,
+                                            1000000000ULL,
+                                            10000000000ULL,
+                                            100000000000ULL,
+                                            1000000000000ULL,
+                                            10000000000000ULL,
+                                            100000000000000ULL,
+                                            1000000000000000ULL,
+                                            10000000000000000ULL,
+                                            100000000000000000ULL};
+constexpr int kMaxFractionDigits = 17;
+//! largest integer such that all smaller ones are exactly representable
+constexpr double kMaxExactInteger = 9007199254740992.;  // 2^53
+//! numbers below are written in the exponent notation
+constexpr double kMinFixedNotation = 1e-5;
+
+//! writes the decimal digits of value to the end of buffer, returns the start
+char* formatUnsigned(uint64_t value, char* end) {
+  do {
+    *--end = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  return end;
+}
+
+//! FNV-1a hash of a string
+uint64_t hashBytes(const char* data, size_t size) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+}  // namespace
+
+int FastNumPut::format(double v, char* buffer) {
+  const double a = std::abs(v);
+  if (a >= kMinFixedNotation && a < kMaxExactInteger) {
+    // find the fewest fraction digits k such that round(a * 10^k) / 10^k
+    // reads back to a. Both the integer and the power of ten are exact, so
+    // the division is correctly rounded as in strtod().
+    for (int k = 0; k <= kMaxFractionDigits; ++k) {
+      const double scaled = a * kExactPowersOfTen[k];
+      if (scaled >= kMaxExactInteger) break;
+      const auto mantissa = static_cast<uint64_t>(scaled + 0.5);
+      if (static_cast<double>(mantissa) / kExactPowersOfTen[k] != a) continue;
+      char digits[kMaxLength];
+      char* const end = digits + kMaxLength;
+      const uint64_t power = kIntegerPowersOfTen[k];
+      char* begin = formatUnsigned(mantissa % power, end);
+      int length = 0;
+      if (std::signbit(v)) buffer[length++] = '-';
+      char* integral = formatUnsigned(mantissa / power, begin);
+      std::memcpy(buffer + length, integral, begin - integral);
+      length += begin - integral;
+      if (k > 0) {
+        buffer[length++] = '.';
+        for (int i = end - begin; i < k; ++i) buffer[length++] = '0';
+        std::memcpy(buffer + length, begin, end - begin);
+        length += end - begin;
+      }
+      return length;
+    }
+  }
+  if (v == 0) {
+    const char* zero = std::signbit(v) ? "-0" : "0";
+    std::strcpy(buffer, zero);
+    return static_cast<int>(std::strlen(zero));
+  }
+  if (!std::isfinite(v)) return std::snprintf(buffer, kMaxLength, "%g", v);
+  int length = 0;
+  for (int precision = 15; precision <= 17; ++precision) {
+    length = std::snprintf(buffer, kMaxLength, "%.*g", precision, v);
+    if (std::strtod(buffer, nullptr) == v) break;
+  }
+  return length;
+}
+
+FastNumPut::iter_type FastNumPut::do_put(iter_type out, std::ios_base& str,
+                                         char_type fill, long v) const {
+  const std::ios_base::fmtflags flags = str.flags();
+  if ((flags & std::ios_base::basefield) != std::ios_base::dec ||
+      (flags & std::ios_base::showpos) || str.width() != 0)
+    return std::num_put<char>::do_put(out, str, fill, v);
+  char digits[kMaxLength];
+  char* const end = digits + kMaxLength;
+  const uint64_t magnitude =
+      v < 0 ? 0 - static_cast<uint64_t>(v) : static_cast<uint64_t>(v);
+  char* begin = formatUnsigned(magnitude, end);
+  if (v < 0) *--begin = '-';
+  for (const char* c = begin; c != end; ++c) *out++ = *c;
+  return out;
+}
+
+FastNumPut::iter_type FastNumPut::do_put(iter_type out, std::ios_base& str,
+                                         char_type fill, double v) const {
+  const std::ios_base::fmtflags flags = str.flags();
+  if ((flags & std::ios_base::floatfield) != 0 ||
+      (flags & (std::ios_base::showpos | std::ios_base::showpoint |
+                std::ios_base::uppercase)) ||
+      str.width() != 0)
+    return std::num_put<char>::do_put(out, str, fill, v);
+  char text[kMaxLength];
+  const int length = format(v, text);
+  for (int i = 0; i < length; ++i) *out++ = text[i];
+  return out;
+}
+
+void GraphTextWriter::OutputBuffer::truncate(size_t position) {
+  char* begin = pbase();
+  char* end = epptr();
+  setp(begin, end);
+  pbump(static_cast<int>(position));
+}
+
+void GraphTextWriter::OutputBuffer::reserve(size_t n) {
+  const size_t used = size();
+  if (storage_.size() - used >= n) return;
+  storage_.resize(std::max(2 * storage_.size(), used + n + 4096));
+  char* begin = &storage_[0];
+  setp(begin, begin + storage_.size());
+  pbump(static_cast<int>(used));
+}
+
+GraphTextWriter::OutputBuffer::int_type GraphTextWriter::OutputBuffer::overflow(
+    int_type c) {
+  if (traits_type::eq_int_type(c, traits_type::eof()))
+    return traits_type::not_eof(c);
+  reserve(1);
+  *pptr() = traits_type::to_char_type(c);
+  pbump(1);
+  return c;
+}
+
+std::streamsize GraphTextWriter::OutputBuffer::xsputn(const char* s,
+                                                      std::streamsize n) {
+  reserve(n);
+  std::memcpy(pptr(), s, n);
+  pbump(static_cast<int>(n));
+  return n;
+}
+
+GraphTextWriter::GraphTextWriter(const OptimizableGraph& graph)
+    : graph_(graph), locale_(std::locale::classic(), new FastNumPut) {}
+
+GraphTextWriter::~GraphTextWriter() = default;
+
+void GraphTextWriter::reset() {
+  vertexHashes_.clear();
+  savedEdgeIdEnd_ = 0;
+  hasCheckpoint_ = false;
+}
+
+bool GraphTextWriter::save(std::ostream& os, ParallelExecutor& executor,
+                           int level) {
+  vertexHashes_.clear();
+  return write(os, executor, level, false);
+}
+
+bool GraphTextWriter::saveChanges(std::ostream& os, ParallelExecutor& executor,
+                                  int level) {
+  return write(os, executor, level, hasCheckpoint_);
+}
+
+void GraphTextWriter::writeUserData(std::ostream& os,
+                                    HyperGraph::Data* d) const {
+  const Factory* factory = Factory::instance();
+  for (; d; d = d->next().get()) {
+    const std::string& t = factory->tag(d);
+    if (t.empty()) continue;
+    os << t << " ";
+    d->write(os);
+    os << '\n';
+  }
+}
+
+void GraphTextWriter::writeVertices(
+    const std::vector<OptimizableGraph::Vertex*>& vertices, int begin, int end,
+    bool changesOnly, Chunk& chunk) const {
+  std::ostream os(&chunk.buffer);
+  os.imbue(locale_);
+  const Factory* factory = Factory::instance();
+  for (int i = begin; i < end; ++i) {
+    OptimizableGraph::Vertex* v = vertices[i];
+    const std::string& t = factory->tag(v);
+    if (t.empty()) continue;
+    const size_t start = chunk.buffer.size();
+    os << t << " " << v->id() << " ";
+    v->write(os);
+    os << '\n';
+    const uint64_t hash =
+        hashBytes(chunk.buffer.data() + start, chunk.buffer.size() - start) ^
+        static_cast<uint64_t>(v->fixed());
+    auto foundIt = vertexHashes_.find(v->id());
+    const bool isNew = foundIt == vertexHashes_.end();
+    if (changesOnly && !isNew && foundIt->second == hash) {
+      chunk.buffer.truncate(start);
+      continue;
+    }
+    chunk.hashes.emplace_back(v->id(), hash);
+    if (!changesOnly || isNew) writeUserData(os, v->userData().get());
+    if (v->fixed()) os << "FIX " << v->id() << '\n';
+  }
+}
+
+void GraphTextWriter::writeEdges(
+    const std::vector<OptimizableGraph::Edge*>& edges, int begin, int end,
+    Chunk& chunk) const {
+  std::ostream os(&chunk.buffer);
+  os.imbue(locale_);
+  const Factory* factory = Factory::instance();
+  for (int i = begin; i < end; ++i) {
+    OptimizableGraph::Edge* e = edges[i];
+    const std::string& t = factory->tag(e);
+    if (t.empty()) continue;
+    os << t << " ";
+    for (const auto& v : e->vertices()) {
+      os << (v ? v->id() : HyperGraph::kUnassignedId) << " ";
+    }
+    e->write(os);
+    os << '\n';
+    writeUserData(os, e->userData().get());
+  }
+}
+
+bool GraphTextWriter::write(std::ostream& os, ParallelExecutor& executor,
+                            int level, bool changesOnly) {
+  if (!changesOnly && !graph_.parameters().write(os)) return false;
+  std::vector<OptimizableGraph::Vertex*> vertices;
+  std::vector<OptimizableGraph::Edge*> edges;
+  graph_.elementsToSave(level, vertices, edges);
+  if (changesOnly) {
+    edges.erase(std::remove_if(edges.begin(), edges.end(),
+                               [this](const OptimizableGraph::Edge* e) {
+                                 return e->internalId() < savedEdgeIdEnd_;
+                               }),
+                edges.end());
+  }
+
+  const int numThreads = std::max(executor.numThreads(), 1);
+  const int chunksPerWave = numThreads * kChunksPerThread;
+  while (static_cast<int>(chunks_.size()) < chunksPerWave)
+    chunks_.emplace_back(g2o::make_unique<Chunk>());
+
+  // format the vertices followed by the edges, a wave of chunks at a time
+  const int numVertices = static_cast<int>(vertices.size());
+  const int numElements = numVertices + static_cast<int>(edges.size());
+  const int numChunks =
+      (numElements + kElementsPerChunk - 1) / kElementsPerChunk;
+  auto chunkRange = [&](int chunk, int& begin, int& end) {
+    begin = chunk * kElementsPerChunk;
+    end = std::min(begin + kElementsPerChunk, numElements);
+  };
+  for (int waveBegin = 0; waveBegin < numChunks; waveBegin += chunksPerWave) {
+    const int waveSize = std::min(chunksPerWave, numChunks - waveBegin);
+    executor.parallelFor(waveSize, 1, [&](int first, int last, int) {
+      for (int c = first; c < last; ++c) {
+        Chunk& chunk = *chunks_[c];
+        chunk.buffer.truncate(0);
+        chunk.hashes.clear();
+        int begin;
+        int end;
+        chunkRange(waveBegin + c, begin, end);
+        if (begin < numVertices) {
+          writeVertices(vertices, begin, std::min(end, numVertices),
+                        changesOnly, chunk);
+        }
+        if (end > numVertices) {
+          writeEdges(edges, std::max(begin, numVertices) - numVertices,
+                     end - numVertices, chunk);
+        }
+      }
+    });
+    for (int c = 0; c < waveSize; ++c) {
+      const Chunk& chunk = *chunks_[c];
+      os.write(chunk.buffer.data(), chunk.buffer.size());
+      for (const auto& idHash : chunk.hashes)
+        vertexHashes_[idHash.first] = idHash.second;
+    }
+  }
+
+  for (const auto* e : edges)
+    savedEdgeIdEnd_ = std::max(savedEdgeIdEnd_, e->internalId() + 1);
+  hasCheckpoint_ = true;
+  os.flush();
+  return os.good();
+}
+
+bool OptimizableGraph::saveParallel(std::ostream& os,
+                                    ParallelExecutor& executor,
+                                    int level) const {
+  GraphTextWriter writer(*this);
+  return writer.save(os, executor, level);
+}
+
+bool OptimizableGraph::saveParallel(const char* filename,
+                                    ParallelExecutor& executor,
+                                    int level) const {
+  std::ofstream ofs(filename);
+  if (!ofs) return false;
+  return saveParallel(ofs, executor, level);
+}
+
+}  // namespace g2o
@@ -0,0 +1,153 @@
+// g2o - General Graph Optimization
+// Copyright (C) 2011 R. Kuemmerle, G. Grisetti, W. Burgard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef G2O_GRAPH_TEXT_WRITER_H
+#define G2O_GRAPH_TEXT_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <locale>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "g2o_core_api.h"
+#include "optimizable_graph.h"
+#include "parallel_executor.h"
+
+namespace g2o {
+
+/**
+ * \brief Number formatting facet which does not depend on the locale
+ *
+ * Replaces the conversion of operator<< for integers and floating point
+ * numbers. A floating point number is written with the fewest digits which
+ * read back to the same value, independent of the precision of the stream.
+ * Numbers with a short decimal representation are formatted with integer
+ * arithmetic, others by snprintf().
+ */
+class G2O_CORE_API FastNumPut : public std::num_put<char> {
+ public:
+  explicit FastNumPut(size_t refs = 0) : std::num_put<char>(refs) {}
+
+  /**
+   * write the shortest representation of v which reads back to v into
+   * buffer, which has to hold kMaxLength characters. Returns the length.
+   */
+  static int format(double v, char* buffer);
+  static constexpr int kMaxLength = 32;
+
+ protected:
+  iter_type do_put(iter_type out, std::ios_base& str, char_type fill,
+                   long v) const override;
+  iter_type do_put(iter_type out, std::ios_base& str, char_type fill,
+                   double v) const override;
+};
+
+/**
+ * \brief Writes a graph in the text format on several threads
+ *
+ * The vertices and edges are formatted in chunks on the threads of an
+ * executor into separate buffers, which are written in the order of save().
+ * Tags are looked up via the type ids of the Factory and numbers are
+ * formatted by FastNumPut, i.e., the output reads back to exactly the same
+ * values.
+ *
+ * Besides complete checkpoints, the writer can save the changes since its
+ * last checkpoint: the vertices whose line differs from the last one
+ * written, e.g., after optimizing, and the edges added since. A changed
+ * vertex is written without its user data, while new elements are written
+ * as by save(). Removed elements and changes of edges are not part of the
+ * changes. Load a graph followed by its changes with a GraphTextParser which
+ * updates existing vertices, see GraphTextParser::setUpdateVertices().
+ */
+class G2O_CORE_API GraphTextWriter {
+ public:
+  explicit GraphTextWriter(const OptimizableGraph& graph);
+  ~GraphTextWriter();
+  GraphTextWriter(const GraphTextWriter&) = delete;
+  GraphTextWriter& operator=(const GraphTextWriter&) = delete;
+
+  //! write the complete graph of the given level, as OptimizableGraph::save()
+  bool save(std::ostream& os, ParallelExecutor& executor, int level = 0);
+  /**
+   * write the vertices which changed and the edges added since the last call
+   * of save() or saveChanges(). The parameters are not written. Writes the
+   * complete graph if there was no previous call.
+   */
+  bool saveChanges(std::ostream& os, ParallelExecutor& executor,
+                   int level = 0);
+
+  //! forget the last checkpoint, the next saveChanges() writes everything
+  void reset();
+
+ protected:
+  //! an output buffer in memory which grows as needed
+  class OutputBuffer : public std::streambuf {
+   public:
+    const char* data() const { return pbase(); }
+    size_t size() const { return pptr() - pbase(); }
+    //! discard the content from position on
+    void truncate(size_t position);
+
+   protected:
+    int_type overflow(int_type c) override;
+    std::streamsize xsputn(const char* s, std::streamsize n) override;
+    void reserve(size_t n);
+    std::string storage_;
+  };
+
+  //! a range of vertices or edges formatted by one task
+  struct Chunk {
+    OutputBuffer buffer;
+    //! the new hashes of the lines of changed vertices
+    std::vector<std::pair<int, uint64_t>> hashes;
+  };
+
+  bool write(std::ostream& os, ParallelExecutor& executor, int level,
+             bool changesOnly);
+  void writeVertices(const std::vector<OptimizableGraph::Vertex*>& vertices,
+                     int begin, int end, bool changesOnly, Chunk& chunk) const;
+  void writeEdges(const std::vector<OptimizableGraph::Edge*>& edges,
+                  int begin, int end, Chunk& chunk) const;
+  void writeUserData(std::ostream& os, HyperGraph::Data* d) const;
+
+  const OptimizableGraph& graph_;
+  std::locale locale_;  ///< classic locale with FastNumPut
+  std::vector<std::unique_ptr<Chunk>> chunks_;
+  //! hash of the line written for each vertex at the last checkpoint
+  std::unordered_map<int, uint64_t> vertexHashes_;
+  //! edges with an internal id below were written by the last checkpoint
+  int64_t savedEdgeIdEnd_ = 0;
+  bool hasCheckpoint_ = false;
+};
+
+}  // namespace g2o
+
+#endif
@@ -123,18 +123,14 @@ void HyperDijkstra::shortestPaths(HyperGraph::VertexSet& vset,
     const std::pair<HyperGraph::VertexSet::iterator, bool> insertResult =
         visited_.insert(u);
     (void)insertResult;
-    auto et = u->edges().begin();
-    while (et != u->edges().end()) {
-      auto edge = et->lock();
-      ++et;
-
-      if (directed && edge->vertex(0) != u) continue;
+    for (HyperGraph::Edge* edge : u->adjacentEdges()) {
+      if (directed && edge->vertices()[0] != u) continue;
 
       for (size_t i = 0; i < edge->vertices().size(); ++i) {
-        auto z = edge->vertex(i);
+        const auto& z = edge->vertices()[i];
         if (z == u) continue;
 
-        const number_t edgeDistance = cost(edge.get(), u.get(), z.get());
+        const number_t edgeDistance = cost(edge, u.get(), z.get());
         if (edgeDistance == std::numeric_limits<number_t>::max() ||
             edgeDistance > maxEdgeCost)
           continue;
@@ -148,7 +144,7 @@ void HyperDijkstra::shortestPaths(HyperGraph::VertexSet& vset,
             zDistance < maxDistance) {
           ot->second.distance_ = zDistance;
           ot->second.parent_ = u;
-          ot->second.edge_ = edge;
+          ot->second.edge_ = edge->sharedThis();
           frontier.push(ot->second);
         }
       }
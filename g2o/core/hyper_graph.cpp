@@ -45,6 +45,24 @@ HyperGraph::Vertex::Vertex(int id) : id_(id) {}
 
 HyperGraph::Vertex::~Vertex() = default;
 
+bool HyperGraph::Vertex::connectEdge(const std::shared_ptr<Edge>& e) {
+  if (!edges_.emplace(e).second) return false;
+  adjacentEdges_.push_back(e.get());
+  return true;
+}
+
+bool HyperGraph::Vertex::disconnectEdge(const std::shared_ptr<Edge>& e) {
+  if (edges_.erase(e) == 0) return false;
+  auto it = std::find(adjacentEdges_.begin(), adjacentEdges_.end(), e.get());
+  if (it != adjacentEdges_.end()) adjacentEdges_.erase(it);
+  return true;
+}
+
+void HyperGraph::Vertex::disconnectAllEdges() {
+  edges_.clear();
+  adjacentEdges_.clear();
+}
+
 HyperGraph::Edge::Edge(int id) : id_(id) {}
 
 HyperGraph::Edge::~Edge() = default;
@@ -111,8 +129,9 @@ bool HyperGraph::addEdge(const std::shared_ptr<Edge>& e) {
   const std::pair<EdgeSet::iterator, bool> result = edges_.emplace(e);
   if (!result.second) return false;
 
+  e->self_ = e;
   for (auto& v : e->vertices()) {  // connect the vertices to this edge
-    v->edges().emplace(e);
+    v->connectEdge(e);
   }
 
   return true;
@@ -121,9 +140,9 @@ bool HyperGraph::addEdge(const std::shared_ptr<Edge>& e) {
 bool HyperGraph::setEdgeVertex(const std::shared_ptr<Edge>& e, int pos,
                                const std::shared_ptr<Vertex>& v) {
   auto vOld = e->vertex(pos);
-  if (vOld) vOld->edges().erase(e);
+  if (vOld) vOld->disconnectEdge(e);
   e->setVertex(pos, v);
-  if (v) v->edges().emplace(e);
+  if (v) v->connectEdge(e);
   return true;
 }
 
@@ -194,9 +213,9 @@ bool HyperGraph::removeEdge(const std::shared_ptr<Edge>& e) {
   for (auto vit = e->vertices().begin(); vit != e->vertices().end(); ++vit) {
     auto& v = *vit;
     if (!v) continue;
-    auto foundIt = v->edges().find(e);
-    assert(foundIt != v->edges().end());
-    v->edges().erase(foundIt);
+    const bool disconnected = v->disconnectEdge(e);
+    (void)disconnected;
+    assert(disconnected);
   }
   return true;
 }
@@ -204,6 +223,8 @@ bool HyperGraph::removeEdge(const std::shared_ptr<Edge>& e) {
 HyperGraph::HyperGraph() = default;
 
 void HyperGraph::clear() {
+  // the vertices may outlive the graph, which owns the edges
+  for (auto& it : vertices_) it.second->disconnectAllEdges();
   vertices_.clear();
   edges_.clear();
 }
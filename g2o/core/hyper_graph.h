@@ -163,11 +163,27 @@ class G2O_CORE_API HyperGraph {
     const EdgeSetWeak& edges() const { return edges_; }
     //! returns the set of hyper-edges that are leaving/entering in this vertex
     EdgeSetWeak& edges() { return edges_; }
+    /**
+     * the same edges as edges() in the order they were connected, as plain
+     * pointers for traversing the graph without touching reference counts.
+     * The graph keeps them alive as long as they belong to it. Only kept up
+     * to date if the edges are connected through the HyperGraph.
+     */
+    const std::vector<Edge*>& adjacentEdges() const { return adjacentEdges_; }
     HyperGraphElementType elementType() const override { return kHgetVertex; }
 
    protected:
     int id_;
     EdgeSetWeak edges_;
+    std::vector<Edge*> adjacentEdges_;
+
+   private:
+    friend class HyperGraph;
+    //! adds e to edges() and adjacentEdges(), false if it was connected before
+    bool connectEdge(const std::shared_ptr<Edge>& e);
+    //! removes e from edges() and adjacentEdges(), false if it was not there
+    bool disconnectEdge(const std::shared_ptr<Edge>& e);
+    void disconnectAllEdges();
   };
 
   /**
@@ -223,9 +239,20 @@ class G2O_CORE_API HyperGraph {
 
     int numUndefinedVertices() const;
 
+    /**
+     * a shared pointer to this edge for code which reached the edge by a
+     * plain pointer, e.g., through Vertex::adjacentEdges(). Known once the
+     * edge was added to a HyperGraph, otherwise nullptr.
+     */
+    std::shared_ptr<Edge> sharedThis() const { return self_.lock(); }
+
    protected:
     VertexContainer vertices_;
     int id_;  ///< unique id
+
+   private:
+    friend class HyperGraph;
+    std::weak_ptr<Edge> self_;
   };
 
   //! constructs an empty hyper graph
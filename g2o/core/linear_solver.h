@@ -64,6 +64,29 @@ class LinearSolver {
   virtual bool solve(const SparseBlockMatrix<MatrixType>& A, number_t* x,
                      number_t* b) = 0;
 
+  //! computes dest = A * src for a matrix A which is not formed explicitly
+  using MatrixVectorProduct =
+      std::function<void(number_t* dest, const number_t* src)>;
+
+  /**
+   * Solve Ax = b where A is only given by its product with a vector, e.g.,
+   * the implicit Schur complement. diagonal contains the diagonal blocks of
+   * A, which may be used for pre-conditioning.
+   * @returns false if not supported by the solver.
+   */
+  virtual bool solveImplicit(const SparseBlockMatrix<MatrixType>& diagonal,
+                             const MatrixVectorProduct& product, number_t* x,
+                             number_t* b) {
+    (void)diagonal;
+    (void)product;
+    (void)x;
+    (void)b;
+    return false;
+  }
+
+  //! true if the solver implements solveImplicit()
+  virtual bool supportsImplicit() const { return false; }
+
   /**
    * Inverts the diagonal blocks of A
    * @returns false if not defined.
@@ -93,6 +116,16 @@ class LinearSolver {
   bool writeDebug() const { return writeDebug_; }
   void setWriteDebug(bool b) { writeDebug_ = b; }
 
+  /**
+   * executor for computing the marginal covariances by solveBlocks() and
+   * solvePattern(). Not owned, nullptr selects
+   * ParallelExecutor::defaultExecutor().
+   */
+  ParallelExecutor* marginalsExecutor() const { return marginalsExecutor_; }
+  void setMarginalsExecutor(ParallelExecutor* executor) {
+    marginalsExecutor_ = executor;
+  }
+
   //! allocate block memory structure
   static void allocateBlocks(const SparseBlockMatrix<MatrixType>& A,
                              number_t**& blocks) {
@@ -141,6 +174,7 @@ class LinearSolver {
 
  protected:
   bool writeDebug_ = true;
+  ParallelExecutor* marginalsExecutor_ = nullptr;
 };
 
 /**
@@ -155,6 +189,7 @@ class LinearSolverCCS : public LinearSolver<MatrixType> {
   bool solveBlocks(number_t**& blocks,
                    const SparseBlockMatrix<MatrixType>& A) override {
     auto compute = [&](MarginalCovarianceCholesky& mcc) {
+      mcc.setExecutor(this->marginalsExecutor_);
       if (!blocks) LinearSolverCCS<MatrixType>::allocateBlocks(A, blocks);
       mcc.computeCovariance(blocks, A.rowBlockIndices());
     };
@@ -165,6 +200,7 @@ class LinearSolverCCS : public LinearSolver<MatrixType> {
                     const std::vector<std::pair<int, int> >& blockIndices,
                     const SparseBlockMatrix<MatrixType>& A) override {
     auto compute = [&](MarginalCovarianceCholesky& mcc) {
+      mcc.setExecutor(this->marginalsExecutor_);
       mcc.computeCovariance(spinv, A.rowBlockIndices(), blockIndices);
     };
     return solveBlocks_impl(A, compute);
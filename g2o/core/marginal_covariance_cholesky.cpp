@@ -28,19 +28,13 @@
 
 #include <algorithm>
 #include <cassert>
+#include <functional>
+#include <unordered_set>
 
 #include "g2o/core/eigen_types.h"
 
 namespace g2o {
 
-struct MatrixElem {
-  int r, c;
-  MatrixElem(int r_, int c_) : r(r_), c(c_) {}
-  bool operator<(const MatrixElem& other) const {
-    return c > other.c || (c == other.c && r > other.r);
-  }
-};
-
 void MarginalCovarianceCholesky::setCholeskyFactor(int n, int* Lp, int* Li,
                                                    number_t* Lx, int* permInv) {
   n_ = n;
@@ -59,65 +53,119 @@ void MarginalCovarianceCholesky::setCholeskyFactor(int n, int* Lp, int* Li,
   }
 }
 
-number_t MarginalCovarianceCholesky::computeEntry(int r, int c)  // NOLINT
-{
+number_t MarginalCovarianceCholesky::entry(int r, int c) const {
   assert(r <= c);
-  const int idx = computeIndex(r, c);
+  const std::vector<int>& rows = rows_[c];
+  const auto it =
+      std::lower_bound(rows.begin(), rows.end(), r, std::greater<int>());
+  assert(it != rows.end() && *it == r && "entry was not computed");
+  return values_[c][it - rows.begin()];
+}
+
+void MarginalCovarianceCholesky::computeColumn(int c) {
+  const std::vector<int>& rows = rows_[c];
+  std::vector<number_t>& values = values_[c];
+  // descending rows, the entries of column c below r are known
+  for (size_t k = 0; k < rows.size(); ++k) {
+    const int r = rows[k];
+    // compute the summation over column r
+    number_t s = 0.;
+    const int& sc = Ap_[r];
+    const int& ec = Ap_[r + 1];
+    // sum over row r while skipping the element on the diagonal
+    for (int j = sc + 1; j < ec; ++j) {
+      const int& rr = Ai_[j];
+      const number_t val = rr <= c ? entry(rr, c) : entry(c, rr);
+      s += val * Ax_[j];
+    }
+    if (r == c) {
+      const number_t& diagElem = diag_[r];
+      values[k] = diagElem * (diagElem - s);
+    } else {
+      values[k] = -s * diag_[r];
+    }
+  }
+}
 
-  const LookupMap::const_iterator foundIt = map_.find(idx);
-  if (foundIt != map_.end()) {
-    return foundIt->second;
+void MarginalCovarianceCholesky::computeEntries(
+    const std::vector<Entry>& entries) {
+  rows_.assign(n_, std::vector<int>());
+  values_.assign(n_, std::vector<number_t>());
+
+  // determine all entries required by the recursion, without recursing
+  std::unordered_set<int64_t> known;
+  std::vector<Entry> pending;
+  auto require = [&](const Entry& e) {
+    if (!known.insert(computeIndex(e.first, e.second)).second) return;
+    rows_[e.second].push_back(e.first);
+    pending.push_back(e);
+  };
+  for (const Entry& e : entries) require(e);
+  while (!pending.empty()) {
+    const Entry e = pending.back();
+    pending.pop_back();
+    const int c = e.second;
+    for (int j = Ap_[e.first] + 1; j < Ap_[e.first + 1]; ++j) {
+      const int rr = Ai_[j];
+      require(rr <= c ? Entry(rr, c) : Entry(c, rr));
+    }
   }
 
-  // compute the summation over column r
-  number_t s = 0.;
-  const int& sc = Ap_[r];
-  const int& ec = Ap_[r + 1];
-  // sum over row r while skipping the element on the diagonal
-  for (int j = sc + 1; j < ec; ++j) {
-    const int& rr = Ai_[j];
-    const number_t val =
-        rr < c ? computeEntry(rr, c) : computeEntry(c, rr);  // NOLINT
-    s += val * Ax_[j];
+  // A column depends on the columns of the rows of L below its entries, which
+  // are right of it. The level of a column is one above its dependencies.
+  std::vector<int> level(n_, -1);
+  int numLevels = 0;
+  for (int c = n_ - 1; c >= 0; --c) {
+    std::vector<int>& rows = rows_[c];
+    if (rows.empty()) continue;
+    std::sort(rows.begin(), rows.end(), std::greater<int>());
+    values_[c].resize(rows.size());
+    int columnLevel = 0;
+    for (const int r : rows) {
+      for (int j = Ap_[r] + 1; j < Ap_[r + 1]; ++j) {
+        if (Ai_[j] > c) columnLevel = std::max(columnLevel, level[Ai_[j]] + 1);
+      }
+    }
+    level[c] = columnLevel;
+    numLevels = std::max(numLevels, columnLevel + 1);
   }
 
-  number_t result;
-  if (r == c) {
-    const number_t& diagElem = diag_[r];
-    result = diagElem * (diagElem - s);
-  } else {
-    result = -s * diag_[r];
+  // bucket the columns by their level and evaluate level by level
+  std::vector<int> levelOffsets(numLevels + 1, 0);
+  for (int c = 0; c < n_; ++c)
+    if (level[c] >= 0) ++levelOffsets[level[c] + 1];
+  for (int l = 0; l < numLevels; ++l) levelOffsets[l + 1] += levelOffsets[l];
+  std::vector<int> columns(levelOffsets.back());
+  std::vector<int> fill(levelOffsets.begin(), levelOffsets.end() - 1);
+  for (int c = 0; c < n_; ++c)
+    if (level[c] >= 0) columns[fill[level[c]]++] = c;
+
+  ParallelExecutor& exec = executor();
+  for (int l = 0; l < numLevels; ++l) {
+    const int levelBegin = levelOffsets[l];
+    exec.parallelFor(levelOffsets[l + 1] - levelBegin, 1,
+                     [&](int begin, int end, int) {
+                       for (int k = levelBegin + begin; k < levelBegin + end;
+                            ++k)
+                         computeColumn(columns[k]);
+                     });
   }
-  map_[idx] = result;
-  return result;
 }
 
 void MarginalCovarianceCholesky::computeCovariance(
     number_t** covBlocks, const std::vector<int>& blockIndices) {
-  map_.clear();
   int base = 0;
-  std::vector<MatrixElem> elemsToCompute;
+  std::vector<Entry> elemsToCompute;
   for (const int nbase : blockIndices) {
     const int vdim = nbase - base;
     for (int rr = 0; rr < vdim; ++rr)
-      for (int cc = rr; cc < vdim; ++cc) {
-        int r = perm_ ? perm_[rr + base] : rr + base;  // apply permutation
-        int c = perm_ ? perm_[cc + base] : cc + base;
-        if (r > c)  // make sure it's still upper triangular after applying the
-                    // permutation
-          std::swap(r, c);
-        elemsToCompute.emplace_back(r, c);
-      }
+      for (int cc = rr; cc < vdim; ++cc)
+        elemsToCompute.push_back(permutedEntry(rr + base, cc + base));
     base = nbase;
   }
 
-  // sort the elems to reduce the recursive calls
-  std::sort(elemsToCompute.begin(), elemsToCompute.end());
-
   // compute the inverse elements we need
-  for (auto& me : elemsToCompute) {
-    computeEntry(me.r, me.c);
-  }
+  computeEntries(elemsToCompute);
 
   // set the marginal covariance for the vertices, by writing to the blocks
   // memory
@@ -128,15 +176,10 @@ void MarginalCovarianceCholesky::computeCovariance(
     number_t* cov = covBlocks[i];
     for (int rr = 0; rr < vdim; ++rr)
       for (int cc = rr; cc < vdim; ++cc) {
-        int r = perm_ ? perm_[rr + base] : rr + base;  // apply permutation
-        int c = perm_ ? perm_[cc + base] : cc + base;
-        if (r > c)  // upper triangle
-          std::swap(r, c);
-        const int idx = computeIndex(r, c);
-        const LookupMap::const_iterator foundIt = map_.find(idx);
-        assert(foundIt != map_.end());
-        cov[rr * vdim + cc] = foundIt->second;
-        if (rr != cc) cov[cc * vdim + rr] = foundIt->second;
+        const Entry e = permutedEntry(rr + base, cc + base);
+        const number_t value = entry(e.first, e.second);
+        cov[rr * vdim + cc] = value;
+        if (rr != cc) cov[cc * vdim + rr] = value;
       }
     base = nbase;
   }
@@ -149,8 +192,7 @@ void MarginalCovarianceCholesky::computeCovariance(
   spinv = SparseBlockMatrix<MatrixX>(
       rowBlockIndices.data(), rowBlockIndices.data(), rowBlockIndices.size(),
       rowBlockIndices.size(), true);
-  map_.clear();
-  std::vector<MatrixElem> elemsToCompute;
+  std::vector<Entry> elemsToCompute;
   for (const auto& blockIndice : blockIndices) {
     const int blockRow = blockIndice.first;
     const int blockCol = blockIndice.second;
@@ -165,23 +207,12 @@ void MarginalCovarianceCholesky::computeCovariance(
     MatrixX* block = spinv.block(blockRow, blockCol, true);
     assert(block);
     for (int iRow = 0; iRow < block->rows(); ++iRow)
-      for (int iCol = 0; iCol < block->cols(); ++iCol) {
-        const int rr = rowBase + iRow;
-        const int cc = colBase + iCol;
-        int r = perm_ ? perm_[rr] : rr;  // apply permutation
-        int c = perm_ ? perm_[cc] : cc;
-        if (r > c) std::swap(r, c);
-        elemsToCompute.emplace_back(r, c);
-      }
+      for (int iCol = 0; iCol < block->cols(); ++iCol)
+        elemsToCompute.push_back(permutedEntry(rowBase + iRow, colBase + iCol));
   }
 
-  // sort the elems to reduce the number of recursive calls
-  sort(elemsToCompute.begin(), elemsToCompute.end());
-
   // compute the inverse elements we need
-  for (auto& me : elemsToCompute) {
-    computeEntry(me.r, me.c);
-  }
+  computeEntries(elemsToCompute);
 
   // set the marginal covariance
   for (const auto& blockIndice : blockIndices) {
@@ -194,15 +225,8 @@ void MarginalCovarianceCholesky::computeCovariance(
     assert(block);
     for (int iRow = 0; iRow < block->rows(); ++iRow)
       for (int iCol = 0; iCol < block->cols(); ++iCol) {
-        const int rr = rowBase + iRow;
-        const int cc = colBase + iCol;
-        int r = perm_ ? perm_[rr] : rr;  // apply permutation
-        int c = perm_ ? perm_[cc] : cc;
-        if (r > c) std::swap(r, c);
-        const int idx = computeIndex(r, c);
-        const LookupMap::const_iterator foundIt = map_.find(idx);
-        assert(foundIt != map_.end());
-        (*block)(iRow, iCol) = foundIt->second;
+        const Entry e = permutedEntry(rowBase + iRow, colBase + iCol);
+        (*block)(iRow, iCol) = entry(e.first, e.second);
       }
   }
 }
@@ -27,10 +27,12 @@
 #ifndef G2O_MARGINAL_COVARIANCE_CHOLESKY_H
 #define G2O_MARGINAL_COVARIANCE_CHOLESKY_H
 
-#include <unordered_map>
+#include <cstdint>
+#include <utility>
 #include <vector>
 
 #include "g2o_core_api.h"
+#include "parallel_executor.h"
 #include "sparse_block_matrix.h"
 
 namespace g2o {
@@ -38,15 +40,15 @@ namespace g2o {
 /**
  * \brief computing the marginal covariance given a cholesky factor (lower
  * triangle of the factor)
+ *
+ * The entries of the inverse are computed by the Takahashi equations
+ * restricted to the pattern of L. Entry (r, c) depends on the entries of
+ * column c with a larger row and on entries of columns right of c. The
+ * required entries are determined first, afterwards the columns are
+ * evaluated level by level, where the columns of one level do not depend on
+ * each other and are computed in parallel by the executor.
  */
 class G2O_CORE_API MarginalCovarianceCholesky {
- protected:
-  /**
-   * hash struct for storing the matrix elements needed to compute the
-   * covariance
-   */
-  using LookupMap = std::unordered_map<int, number_t>;
-
  public:
   MarginalCovarianceCholesky() = default;
   ~MarginalCovarianceCholesky() = default;
@@ -77,7 +79,19 @@ class G2O_CORE_API MarginalCovarianceCholesky {
    */
   void setCholeskyFactor(int n, int* Lp, int* Li, number_t* Lx, int* permInv);
 
+  /**
+   * the executor evaluating the independent columns, if none is set
+   * ParallelExecutor::defaultExecutor() is used. Not owned.
+   */
+  ParallelExecutor& executor() const {
+    return executor_ ? *executor_ : ParallelExecutor::defaultExecutor();
+  }
+  void setExecutor(ParallelExecutor* executor) { executor_ = executor; }
+
  protected:
+  //! an entry (r, c) of the inverse with r <= c
+  using Entry = std::pair<int, int>;
+
   // information about the cholesky factor (lower triangle)
   int n_{0};               ///< L is an n X n matrix
   int* Ap_{nullptr};       ///< column pointer of the CCS storage
@@ -86,19 +100,37 @@ class G2O_CORE_API MarginalCovarianceCholesky {
   int* perm_{nullptr};     ///< permutation of the cholesky factor. Variable
                            ///< re-ordering for better fill-in
 
-  LookupMap map_;  ///< hash look up table for the already computed entries
   std::vector<number_t> diag_;  ///< cache 1 / H_ii to avoid recalculations
+  ParallelExecutor* executor_ = nullptr;
+
+  //! rows of the computed entries of each column, sorted descending
+  std::vector<std::vector<int> > rows_;
+  //! values of the computed entries, aligned with rows_
+  std::vector<std::vector<number_t> > values_;
 
   //! compute the index used for hashing
-  int computeIndex(int r, int c) const { /*assert(r <= c);*/
-    return r * n_ + c;
+  int64_t computeIndex(int r, int c) const {
+    return static_cast<int64_t>(r) * n_ + c;
   }
+
+  //! the entry (r, c) after applying the permutation, upper triangular
+  Entry permutedEntry(int r, int c) const {
+    if (perm_) {
+      r = perm_[r];
+      c = perm_[c];
+    }
+    return r <= c ? Entry(r, c) : Entry(c, r);
+  }
+
   /**
-   * compute one entry in the covariance, r and c are values after applying the
-   * permutation, and upper triangular. May issue recursive calls to itself to
-   * compute the missing values.
+   * compute the given entries of the inverse along with all the entries they
+   * depend on, the entries are afterwards available by entry()
    */
-  number_t computeEntry(int r, int c);
+  void computeEntries(const std::vector<Entry>& entries);
+  //! evaluate the entries of column c, the columns right of c are done
+  void computeColumn(int c);
+  //! look up a computed entry, r and c are after permutation and r <= c
+  number_t entry(int r, int c) const;
 };
 
 }  // namespace g2o
@@ -32,7 +32,7 @@
 #ifdef G2O_OPENMP
 #include <omp.h>
 #else
-#include <cassert>
+#include <mutex>
 #endif
 
 namespace g2o {
@@ -55,26 +55,22 @@ class OpenMPMutex {
 
 #else
 
-/*
- * dummy which does nothing in case we don't have OpenMP support.
- * In debug mode, the mutex allows to verify the correct lock and unlock
- * behavior
+/**
+ * \brief Mutex realized via std::mutex in case we don't have OpenMP support.
+ *
+ * Required if the loops of the optimizer run on a WorkStealingExecutor.
+ * Copying creates a new unlocked mutex.
  */
 class OpenMPMutex {
  public:
   OpenMPMutex() = default;
-  ~OpenMPMutex() { assert(cnt_ == 0 && "Freeing locked mutex"); }
-  void lock() {  // NOLINT
-    assert(++cnt_ == 1 && "Locking already locked mutex");
-  }
-  void unlock() { // NOLINT
-    assert(--cnt_ == 0 && "Trying to unlock a mutex which is not locked");
-  }
+  OpenMPMutex(const OpenMPMutex&) {}
+  OpenMPMutex& operator=(const OpenMPMutex&) { return *this; }
+  void lock() { mutex_.lock(); }
+  void unlock() { mutex_.unlock(); }
 
  protected:
-#ifndef NDEBUG
-  char cnt_ = 0;
-#endif
+  std::mutex mutex_;
 };
 
 #endif
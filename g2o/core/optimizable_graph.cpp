@@ -374,12 +374,6 @@ bool OptimizableGraph::load(std::istream& is) {
   string token;
 
   Factory* factory = Factory::instance();
-  HyperGraph::GraphElemBitset elemBitset;
-  elemBitset[HyperGraph::kHgetParameter] = true;
-  elemBitset.flip();
-
-  HyperGraph::GraphElemBitset elemParamBitset;
-  elemParamBitset[HyperGraph::kHgetParameter] = true;
 
   std::shared_ptr<HyperGraph::DataContainer> previousDataContainer;
   Data* previousData = nullptr;
@@ -419,7 +413,8 @@ bool OptimizableGraph::load(std::istream& is) {
       }
     }
 
-    if (!factory->knowsTag(token)) {
+    const int typeId = factory->typeId(token);
+    if (typeId < 0) {
       if (warnedUnknownTypes.count(token) != 1) {
         warnedUnknownTypes.insert(token);
         cerr << CL_RED(__PRETTY_FUNCTION__ << " unknown type: " << token)
@@ -429,12 +424,10 @@ bool OptimizableGraph::load(std::istream& is) {
     }
 
     // first handle the parameters
-    const std::shared_ptr<HyperGraph::HyperGraphElement> pelement =
-        factory->construct(token, elemParamBitset);
-    if (pelement) {  // not a parameter or otherwise unknown tag
-      assert(pelement->elementType() == HyperGraph::kHgetParameter &&
-             "Should be a param");
-      auto p = std::static_pointer_cast<Parameter>(pelement);
+    const int elementType = factory->elementType(typeId);
+    if (elementType == HyperGraph::kHgetParameter) {
+      auto p = std::shared_ptr<Parameter>(
+          static_cast<Parameter*>(factory->construct(typeId).release()));
       int pid;
       currentLine >> pid;
       p->setId(pid);
@@ -452,8 +445,10 @@ bool OptimizableGraph::load(std::istream& is) {
       continue;
     }
 
+    // elements without a type bit are not constructed
+    if (elementType < 0) continue;
     const std::shared_ptr<HyperGraph::HyperGraphElement> element =
-        factory->construct(token, elemBitset);
+        factory->construct(typeId);
     if (dynamic_cast<Vertex*>(element.get())) {  // it's a vertex type
       previousData = nullptr;
       auto v = std::static_pointer_cast<Vertex>(element);
@@ -552,6 +547,7 @@ bool OptimizableGraph::load(std::istream& is) {
 }
 
 bool OptimizableGraph::load(const char* filename) {
+  if (isBinaryFile(filename)) return loadBinary(filename);
   std::ifstream ifs(filename);
   if (!ifs) {
     cerr << __PRETTY_FUNCTION__ << " unable to open file " << filename << endl;
@@ -566,32 +562,31 @@ bool OptimizableGraph::save(const char* filename, int level) const {
   return save(ofs, level);
 }
 
-bool OptimizableGraph::save(std::ostream& os, int level) const {
-  // write the parameters to the top of the file
-  if (!parameters_.write(os)) return false;
+void OptimizableGraph::elementsToSave(int level, std::vector<Vertex*>& vertices,
+                                      std::vector<Edge*>& edges) const {
   std::set<Vertex*, VertexIDCompare> verticesToSave;  // set sorted by ID
-  for (const auto& it : edges()) {
+  edges.clear();
+  for (const auto& it : this->edges()) {
     auto* e = static_cast<OptimizableGraph::Edge*>(it.get());
-    if (e->level() == level) {
-      for (auto& it : e->vertices()) {
-        if (it)
-          verticesToSave.insert(
-              static_cast<OptimizableGraph::Vertex*>(it.get()));
-      }
+    if (e->level() != level) continue;
+    edges.push_back(e);
+    for (auto& it : e->vertices()) {
+      if (it)
+        verticesToSave.insert(static_cast<OptimizableGraph::Vertex*>(it.get()));
     }
   }
+  vertices.assign(verticesToSave.begin(), verticesToSave.end());
+  sort(edges.begin(), edges.end(), EdgeIDCompare());
+}
 
+bool OptimizableGraph::save(std::ostream& os, int level) const {
+  // write the parameters to the top of the file
+  if (!parameters_.write(os)) return false;
+  std::vector<Vertex*> verticesToSave;
+  std::vector<Edge*> edgesToSave;
+  elementsToSave(level, verticesToSave, edgesToSave);
   for (auto* v : verticesToSave) saveVertex(os, v);
-
-  std::vector<std::shared_ptr<HyperGraph::Edge>> edgesToSave;
-  std::copy_if(edges().begin(), edges().end(), std::back_inserter(edgesToSave),
-               [level](const std::shared_ptr<HyperGraph::Edge>& ee) {
-                 auto* e = dynamic_cast<OptimizableGraph::Edge*>(ee.get());
-                 return (e->level() == level);
-               });
-  sort(edgesToSave.begin(), edgesToSave.end(), EdgeIDCompare());
-  for (const auto& e : edgesToSave) saveEdge(os, static_cast<Edge*>(e.get()));
-
+  for (auto* e : edgesToSave) saveEdge(os, e);
   return os.good();
 }
 
@@ -747,7 +742,7 @@ bool OptimizableGraph::removePostIterationAction(
 bool OptimizableGraph::saveUserData(std::ostream& os, HyperGraph::Data* d) {
   Factory* factory = Factory::instance();
   while (d) {  // write the data packet for the vertex
-    const string tag = factory->tag(d);
+    const string& tag = factory->tag(d);
     if (!tag.empty()) {
       os << tag << " ";
       d->write(os);
@@ -761,7 +756,7 @@ bool OptimizableGraph::saveUserData(std::ostream& os, HyperGraph::Data* d) {
 bool OptimizableGraph::saveVertex(std::ostream& os,
                                   OptimizableGraph::Vertex* v) {
   Factory* factory = Factory::instance();
-  const string tag = factory->tag(v);
+  const string& tag = factory->tag(v);
   if (!tag.empty()) {
     os << tag << " " << v->id() << " ";
     v->write(os);
@@ -777,7 +772,7 @@ bool OptimizableGraph::saveVertex(std::ostream& os,
 
 bool OptimizableGraph::saveParameter(std::ostream& os, Parameter* p) {
   Factory* factory = Factory::instance();
-  const string tag = factory->tag(p);
+  const string& tag = factory->tag(p);
   if (!tag.empty()) {
     os << tag << " " << p->id() << " ";
     p->write(os);
@@ -788,7 +783,7 @@ bool OptimizableGraph::saveParameter(std::ostream& os, Parameter* p) {
 
 bool OptimizableGraph::saveEdge(std::ostream& os, OptimizableGraph::Edge* e) {
   Factory* factory = Factory::instance();
-  const string tag = factory->tag(e);
+  const string& tag = factory->tag(e);
   if (!tag.empty()) {
     os << tag << " ";
     for (auto& it : e->vertices()) {
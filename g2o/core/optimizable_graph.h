@@ -45,6 +45,7 @@
 namespace g2o {
 
 class HyperGraphAction;
+class ParallelExecutor;
 struct OptimizationAlgorithmProperty;
 class CacheContainer;
 class RobustKernel;
@@ -127,6 +128,7 @@ struct G2O_CORE_API OptimizableGraph : public HyperGraph {
                               public HyperGraph::DataContainer {
    private:
     friend struct OptimizableGraph;
+    friend class SparseOptimizer;
 
    public:
     Vertex() = default;
@@ -335,6 +337,22 @@ struct G2O_CORE_API OptimizableGraph : public HyperGraph {
     //! return the stack size
     virtual int stackSize() const = 0;
 
+    /**
+     * Saving the estimate into memory owned by the graph, see EstimateStack.
+     * Returns the number of bytes needed by saveState(), or 0 if not
+     * supported, in which case push() and pop() are used instead.
+     */
+    virtual size_t stateSize() const { return 0; }
+    //! alignment of the memory handed to saveState()
+    static constexpr size_t kStateAlignment =
+        EIGEN_MAX_ALIGN_BYTES > 16 ? EIGEN_MAX_ALIGN_BYTES : 16;
+    //! copy the estimate into the uninitialized memory state
+    virtual void saveState(void* state) const { (void)state; }
+    //! restore the estimate from state, calls updateCache(), releases state
+    virtual void restoreState(void* state) { (void)state; }
+    //! release state without restoring the estimate
+    virtual void discardState(void* state) const { (void)state; }
+
     /**
      * Update the position of the node from the parameters in v.
      * Depends on the implementation of oplusImpl in derived classes to actually
@@ -381,12 +399,24 @@ struct G2O_CORE_API OptimizableGraph : public HyperGraph {
      * lock for the block of the hessian and the b vector associated with this
      * vertex, to avoid race-conditions if multi-threaded.
      */
-    void lockQuadraticForm() { quadraticFormMutex_.lock(); }
+    void lockQuadraticForm() {
+      if (lockQuadraticForm_) quadraticFormMutex_.lock();
+    }
     /**
      * unlock the block of the hessian and the b vector associated with this
      * vertex
      */
-    void unlockQuadraticForm() { quadraticFormMutex_.unlock(); }
+    void unlockQuadraticForm() {
+      if (lockQuadraticForm_) quadraticFormMutex_.unlock();
+    }
+    /**
+     * enable or disable the locking of the quadratic form. Disabling is only
+     * safe if the caller guarantees exclusive access to the vertex while
+     * constructing the quadratic form, e.g., by processing only edges which do
+     * not share a vertex in parallel.
+     */
+    void setLockQuadraticForm(bool lock) { lockQuadraticForm_ = lock; }
+    bool lockQuadraticFormEnabled() const { return lockQuadraticForm_; }
 
     //! read the vertex from a stream, i.e., the internal state of the vertex
     virtual bool read(std::istream& is) = 0;
@@ -396,6 +426,8 @@ struct G2O_CORE_API OptimizableGraph : public HyperGraph {
     virtual void updateCache();
 
     std::shared_ptr<CacheContainer> cacheContainer();
+    //! true if cacheContainer() was created, i.e., caches depend on the vertex
+    bool hasCacheContainer() const { return cacheContainer_ != nullptr; }
 
    protected:
     OptimizableGraph* graph_{nullptr};
@@ -405,6 +437,9 @@ struct G2O_CORE_API OptimizableGraph : public HyperGraph {
     int dimension_;
     int colInHessian_{-1};
     OpenMPMutex quadraticFormMutex_;
+    bool lockQuadraticForm_{true};
+    //! scratch of SparseOptimizer::initializeOptimization(), false otherwise
+    bool initializationMark_{false};
 
     std::shared_ptr<CacheContainer> cacheContainer_{nullptr};
 
@@ -687,12 +722,59 @@ struct G2O_CORE_API OptimizableGraph : public HyperGraph {
   //! load the graph from a stream. Uses the Factory singleton for creating the
   //! vertices and edges.
   virtual bool load(std::istream& is);
+  //! load a text or a binary file, the latter is detected by its header
   bool load(const char* filename);
+
+  /**
+   * Load a graph in the text format, parsing chunks of lines in parallel on
+   * the threads of the executor. The elements are added in the order of the
+   * input, hence the graph is the same as after load(). The variant taking
+   * a file name memory-maps the file and also accepts the binary format.
+   */
+  bool loadParallel(const char* data, size_t size, ParallelExecutor& executor);
+  bool loadParallel(std::istream& is, ParallelExecutor& executor);
+  bool loadParallel(const char* filename, ParallelExecutor& executor);
+
+  /**
+   * Save the graph in the versioned binary format. The file starts with a
+   * table of the types, followed by a record per element. Elements of a
+   * type whose state is fully described by the estimate, respectively the
+   * measurement and the information matrix, are stored as fixed-width
+   * records of raw doubles. Other types, parameters and user data are stored
+   * as the text written by their write() method.
+   */
+  bool saveBinary(std::ostream& os, int level = 0) const;
+  bool saveBinary(const char* filename, int level = 0) const;
+  //! load a graph stored by saveBinary()
+  bool loadBinary(std::istream& is);
+  //! load a graph stored by saveBinary(), the file is memory-mapped
+  bool loadBinary(const char* filename);
+  //! load a graph stored by saveBinary() from memory
+  bool loadBinary(const char* data, size_t size);
+  //! true if the file starts with the header of the binary format
+  static bool isBinaryFile(const char* filename);
   //! save the graph to a stream. Again uses the Factory system.
   virtual bool save(std::ostream& os, int level = 0) const;
   //! function provided for convenience, see save() above
   bool save(const char* filename, int level = 0) const;
 
+  /**
+   * Save the graph as save() does, but format the elements on the threads of
+   * the executor. Numbers are written with the digits needed to read back
+   * the same value. See GraphTextWriter for saving changes only.
+   */
+  bool saveParallel(std::ostream& os, ParallelExecutor& executor,
+                    int level = 0) const;
+  bool saveParallel(const char* filename, ParallelExecutor& executor,
+                    int level = 0) const;
+
+  /**
+   * the edges of the given level in the order of their IDs and their vertices
+   * ordered by ID, as written by save()
+   */
+  void elementsToSave(int level, std::vector<Vertex*>& vertices,
+                      std::vector<Edge*>& edges) const;
+
   //! save a subgraph to a stream. Again uses the Factory system.
   bool saveSubset(std::ostream& os, HyperGraph::VertexSet& vset, int level = 0);
 
@@ -717,6 +799,10 @@ struct G2O_CORE_API OptimizableGraph : public HyperGraph {
    * VERTEX_SE3:EXPMAP
    */
   void setRenamedTypesFromString(const std::string& types);
+  //! the mapping of the tags in a file to the tags of the Factory
+  const std::map<std::string, std::string>& renamedTypes() const {
+    return renamedTypesLookup_;
+  }
 
   /**
    * test whether a solver is suitable for optimizing this graph.
@@ -0,0 +1,625 @@
+// g2o - General Graph Optimization
+// Copyright (C) 2011 R. Kuemmerle, G. Grisetti, W. Burgard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "factory.h"
+#include "g2o/stuff/color_macros.h"
+#include "g2o/stuff/filesys_tools.h"
+#include "optimizable_graph.h"
+
+namespace g2o {
+
+using std::cerr;
+using std::endl;
+using std::string;
+
+namespace {
+
+/**
+ * Layout of the binary format, all values in the byte order of the machine
+ * which wrote the file:
+ *
+ * header: kMagic, uint32 version, uint32 kByteOrderMark
+ * types: uint32 count, for each type: string tag, uint8 element type,
+ *        uint8 raw, uint32 vertices, uint32 parameters, uint32 data
+ *        dimension, uint32 information dimension
+ * records until the end of the file: uint32 type index followed by
+ *   parameter:  int32 id, string text
+ *   vertex:     int32 id, uint8 fixed, then double[data dimension] if raw,
+ *               string text otherwise
+ *   edge (raw): int32[vertices] ids, int32[parameters] parameter ids,
+ *               double[data dimension] measurement, double[n * (n + 1) / 2]
+ *               upper triangle of the information matrix
+ *   edge:       uint32 count, int32[count] ids, string text
+ *   data:       string text, attached to the preceding vertex or edge
+ * A string is stored as uint32 length followed by the characters.
+ */
+constexpr char kMagic[8] = {'G', '2', 'O', 'B', 'I', 'N', '\n', '\0'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+//! number of elements checked per type before storing the type as raw data
+constexpr int kRawChecks = 8;
+
+struct BinaryTypeInfo {
+  string tag;
+  uint8_t elementType = HyperGraph::kHgetNumElems;
+  uint8_t raw = 0;
+  uint32_t numVertices = 0;
+  uint32_t numParameters = 0;
+  uint32_t dataDimension = 0;
+  uint32_t informationDimension = 0;
+  int checked = 0;  ///< number of elements passing the raw check
+};
+
+//! buffers the output and writes it in large chunks
+class BinaryWriter {
+ public:
+  explicit BinaryWriter(std::ostream& os) : os_(os) {}
+  ~BinaryWriter() { flush(); }
+
+  template <typename T>
+  void put(T value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    buffer_.append(bytes, sizeof(T));
+    if (buffer_.size() > kFlushSize) flush();
+  }
+  void putString(const string& s) {
+    put(static_cast<uint32_t>(s.size()));
+    buffer_.append(s);
+  }
+  void putDoubles(const number_t* values, int n) {
+    for (int i = 0; i < n; ++i) put(static_cast<double>(values[i]));
+  }
+  void flush() {
+    os_.write(buffer_.data(), buffer_.size());
+    buffer_.clear();
+  }
+
+ protected:
+  static constexpr size_t kFlushSize = 1 << 20;
+  std::ostream& os_;
+  string buffer_;
+};
+
+//! reads values from memory, fails on reading beyond the end
+class BinaryReader {
+ public:
+  BinaryReader(const char* data, size_t size)
+      : current_(data), end_(data + size) {}
+
+  bool atEnd() const { return current_ == end_; }
+
+  template <typename T>
+  bool get(T& value) {
+    if (static_cast<size_t>(end_ - current_) < sizeof(T)) return false;
+    std::memcpy(&value, current_, sizeof(T));
+    current_ += sizeof(T);
+    return true;
+  }
+  bool getString(string& s) {
+    uint32_t length;
+    if (!get(length) || static_cast<size_t>(end_ - current_) < length)
+      return false;
+    s.assign(current_, length);
+    current_ += length;
+    return true;
+  }
+  bool getDoubles(number_t* values, int n) {
+    if (static_cast<size_t>(end_ - current_) < n * sizeof(double))
+      return false;
+    for (int i = 0; i < n; ++i) {
+      double value;
+      std::memcpy(&value, current_, sizeof(double));
+      current_ += sizeof(double);
+      values[i] = static_cast<number_t>(value);
+    }
+    return true;
+  }
+  template <typename T>
+  bool getVector(std::vector<T>& values, size_t n) {
+    values.resize(n);
+    if (static_cast<size_t>(end_ - current_) < n * sizeof(T)) return false;
+    if (n > 0) std::memcpy(values.data(), current_, n * sizeof(T));
+    current_ += n * sizeof(T);
+    return true;
+  }
+
+ protected:
+  const char* current_;
+  const char* end_;
+};
+
+template <typename T>
+string writeToString(const T* element) {
+  std::stringstream ss;
+  element->write(ss);
+  return ss.str();
+}
+
+int upperTriangleSize(int n) { return n * (n + 1) / 2; }
+
+void getUpperTriangle(const OptimizableGraph::Edge* e,
+                      std::vector<number_t>& values) {
+  const int n = e->dimension();
+  const number_t* information = e->informationData();
+  values.clear();
+  for (int c = 0; c < n; ++c)
+    for (int r = 0; r <= c; ++r) values.push_back(information[c * n + r]);
+}
+
+void setUpperTriangle(OptimizableGraph::Edge* e, const number_t* values) {
+  const int n = e->dimension();
+  number_t* information = e->informationData();
+  for (int c = 0; c < n; ++c) {
+    for (int r = 0; r <= c; ++r) {
+      information[c * n + r] = *values;
+      information[r * n + c] = *values;
+      ++values;
+    }
+  }
+}
+
+//! the raw data describes v if a copy restored from it writes the same text
+bool rawRoundTrip(const BinaryTypeInfo& type, OptimizableGraph::Vertex* v,
+                  std::vector<number_t>& values) {
+  if (v->estimateDimension() != static_cast<int>(type.dataDimension))
+    return false;
+  values.resize(type.dataDimension);
+  if (!v->getEstimateData(values.data())) return false;
+  std::unique_ptr<HyperGraph::HyperGraphElement> element =
+      Factory::instance()->construct(type.tag);
+  auto* copy = dynamic_cast<OptimizableGraph::Vertex*>(element.get());
+  if (!copy || !copy->setEstimateData(values.data())) return false;
+  return writeToString(v) == writeToString(copy);
+}
+
+bool rawRoundTrip(const BinaryTypeInfo& type, OptimizableGraph::Edge* e,
+                  std::vector<number_t>& values) {
+  if (e->measurementDimension() != static_cast<int>(type.dataDimension) ||
+      e->vertices().size() != type.numVertices ||
+      e->numParameters() != type.numParameters ||
+      e->dimension() != static_cast<int>(type.informationDimension))
+    return false;
+  values.resize(type.dataDimension);
+  if (!e->getMeasurementData(values.data())) return false;
+  std::unique_ptr<HyperGraph::HyperGraphElement> element =
+      Factory::instance()->construct(type.tag);
+  auto* copy = dynamic_cast<OptimizableGraph::Edge*>(element.get());
+  // edges with a varying number of vertices are stored as text
+  if (!copy || copy->vertices().size() != type.numVertices ||
+      copy->numParameters() != type.numParameters)
+    return false;
+  for (size_t i = 0; i < e->vertices().size(); ++i)
+    copy->setVertex(i, e->vertices()[i]);
+  for (size_t i = 0; i < e->numParameters(); ++i)
+    copy->setParameterId(i, e->parameterIds()[i]);
+  if (!copy->setMeasurementData(values.data())) return false;
+  getUpperTriangle(e, values);
+  setUpperTriangle(copy, values.data());
+  return writeToString(e) == writeToString(copy);
+}
+
+//! collects the types of the elements to save and their binary layout
+class BinaryTypeTable {
+ public:
+  //! index of the type of element in the table, adds the type if necessary
+  int index(const HyperGraph::HyperGraphElement* element) {
+    const Factory* factory = Factory::instance();
+    const int typeId = factory->typeId(element);
+    if (typeId < 0) return -1;
+    if (typeId >= static_cast<int>(indices_.size()))
+      indices_.resize(factory->numTypeIds(), -1);
+    if (indices_[typeId] >= 0) return indices_[typeId];
+    BinaryTypeInfo info;
+    info.tag = factory->tag(typeId);
+    info.elementType = element->elementType();
+    if (const auto* v =
+            dynamic_cast<const OptimizableGraph::Vertex*>(element)) {
+      info.raw = v->estimateDimension() >= 0;
+      info.dataDimension = std::max(0, v->estimateDimension());
+    } else if (const auto* e =
+                   dynamic_cast<const OptimizableGraph::Edge*>(element)) {
+      info.raw = e->measurementDimension() >= 0;
+      info.numVertices = static_cast<uint32_t>(e->vertices().size());
+      info.numParameters = static_cast<uint32_t>(e->numParameters());
+      info.dataDimension = std::max(0, e->measurementDimension());
+      info.informationDimension = e->dimension();
+    }
+    types_.push_back(info);
+    return indices_[typeId] = static_cast<int>(types_.size()) - 1;
+  }
+
+  //! check whether the raw data describes the element, see rawRoundTrip()
+  template <typename T>
+  void check(T* element) {
+    const int idx = index(element);
+    if (idx < 0) return;
+    BinaryTypeInfo& type = types_[idx];
+    if (!type.raw) return;
+    if (type.checked < kRawChecks) {
+      type.raw = rawRoundTrip(type, element, values_);
+      ++type.checked;
+    } else {
+      // only the layout needs to match for the remaining elements
+      type.raw = hasLayout(type, element);
+    }
+  }
+
+  void addUserData(HyperGraph::Data* d) {
+    for (; d; d = d->next().get()) index(d);
+  }
+
+  const std::vector<BinaryTypeInfo>& types() const { return types_; }
+
+ protected:
+  static bool hasLayout(const BinaryTypeInfo& type,
+                        const OptimizableGraph::Vertex* v) {
+    return v->estimateDimension() == static_cast<int>(type.dataDimension);
+  }
+  static bool hasLayout(const BinaryTypeInfo& type,
+                        const OptimizableGraph::Edge* e) {
+    return e->measurementDimension() ==
+               static_cast<int>(type.dataDimension) &&
+           e->vertices().size() == type.numVertices &&
+           e->numParameters() == type.numParameters &&
+           e->dimension() == static_cast<int>(type.informationDimension);
+  }
+
+  //! index in types_ by the type id of the Factory, -1 if not added yet
+  std::vector<int> indices_;
+  std::vector<BinaryTypeInfo> types_;
+  std::vector<number_t> values_;
+};
+
+}  // namespace
+
+bool OptimizableGraph::saveBinary(std::ostream& os, int level) const {
+  std::vector<Vertex*> verticesToSave;
+  std::vector<Edge*> edgesToSave;
+  elementsToSave(level, verticesToSave, edgesToSave);
+
+  // first pass: the table of types, decides which types are stored raw
+  BinaryTypeTable table;
+  for (const auto& p : parameters_) table.index(p.second.get());
+  for (auto* v : verticesToSave) {
+    table.check(v);
+    table.addUserData(v->userData().get());
+  }
+  for (auto* e : edgesToSave) {
+    table.check(e);
+    table.addUserData(e->userData().get());
+  }
+
+  BinaryWriter out(os);
+  for (char c : kMagic) out.put(c);
+  out.put(kVersion);
+  out.put(kByteOrderMark);
+  const std::vector<BinaryTypeInfo>& types = table.types();
+  out.put(static_cast<uint32_t>(types.size()));
+  for (const auto& type : types) {
+    out.putString(type.tag);
+    out.put(type.elementType);
+    out.put(type.raw);
+    out.put(type.numVertices);
+    out.put(type.numParameters);
+    out.put(type.dataDimension);
+    out.put(type.informationDimension);
+  }
+
+  // second pass: the records
+  std::vector<number_t> values;
+  auto saveUserData = [&](HyperGraph::Data* d) {
+    for (; d; d = d->next().get()) {
+      const int idx = table.index(d);
+      if (idx < 0) continue;
+      out.put(static_cast<uint32_t>(idx));
+      out.putString(writeToString(d));
+    }
+  };
+
+  for (const auto& p : parameters_) {
+    const int idx = table.index(p.second.get());
+    if (idx < 0) continue;
+    out.put(static_cast<uint32_t>(idx));
+    out.put(static_cast<int32_t>(p.second->id()));
+    out.putString(writeToString(p.second.get()));
+  }
+
+  for (auto* v : verticesToSave) {
+    const int idx = table.index(v);
+    if (idx < 0) continue;
+    const BinaryTypeInfo& type = types[idx];
+    out.put(static_cast<uint32_t>(idx));
+    out.put(static_cast<int32_t>(v->id()));
+    out.put(static_cast<uint8_t>(v->fixed()));
+    if (type.raw) {
+      values.resize(type.dataDimension);
+      v->getEstimateData(values.data());
+      out.putDoubles(values.data(), type.dataDimension);
+    } else {
+      out.putString(writeToString(v));
+    }
+    saveUserData(v->userData().get());
+  }
+
+  for (auto* e : edgesToSave) {
+    const int idx = table.index(e);
+    if (idx < 0) continue;
+    const BinaryTypeInfo& type = types[idx];
+    out.put(static_cast<uint32_t>(idx));
+    if (!type.raw) out.put(static_cast<uint32_t>(e->vertices().size()));
+    for (const auto& v : e->vertices())
+      out.put(static_cast<int32_t>(v ? v->id() : HyperGraph::kUnassignedId));
+    if (type.raw) {
+      for (int id : e->parameterIds()) out.put(static_cast<int32_t>(id));
+      values.resize(type.dataDimension);
+      e->getMeasurementData(values.data());
+      out.putDoubles(values.data(), type.dataDimension);
+      getUpperTriangle(e, values);
+      out.putDoubles(values.data(), static_cast<int>(values.size()));
+    } else {
+      out.putString(writeToString(e));
+    }
+    saveUserData(e->userData().get());
+  }
+  out.flush();
+  return os.good();
+}
+
+bool OptimizableGraph::saveBinary(const char* filename, int level) const {
+  std::ofstream ofs(filename, std::ios::binary);
+  if (!ofs) return false;
+  return saveBinary(ofs, level);
+}
+
+bool OptimizableGraph::loadBinary(std::istream& is) {
+  const string content((std::istreambuf_iterator<char>(is)),
+                       std::istreambuf_iterator<char>());
+  return loadBinary(content.data(), content.size());
+}
+
+bool OptimizableGraph::loadBinary(const char* filename) {
+  MappedFile file(filename);
+  if (!file.isOpen()) {
+    cerr << __PRETTY_FUNCTION__ << " unable to open file " << filename << endl;
+    return false;
+  }
+  return loadBinary(file.data(), file.size());
+}
+
+bool OptimizableGraph::isBinaryFile(const char* filename) {
+  std::ifstream ifs(filename, std::ios::binary);
+  char magic[sizeof(kMagic)];
+  if (!ifs.read(magic, sizeof(magic))) return false;
+  return std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+bool OptimizableGraph::loadBinary(const char* data, size_t size) {
+  BinaryReader in(data, size);
+  char magic[sizeof(kMagic)] = {};
+  uint32_t version = 0;
+  uint32_t byteOrder = 0;
+  for (char& c : magic) in.get(c);
+  if (std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 || !in.get(version) ||
+      !in.get(byteOrder)) {
+    cerr << __PRETTY_FUNCTION__ << ": not a binary graph" << endl;
+    return false;
+  }
+  if (version != kVersion || byteOrder != kByteOrderMark) {
+    cerr << __PRETTY_FUNCTION__ << ": unsupported version " << version
+         << " or byte order" << endl;
+    return false;
+  }
+
+  Factory* factory = Factory::instance();
+  uint32_t numTypes = 0;
+  if (!in.get(numTypes)) return false;
+  std::vector<BinaryTypeInfo> types(numTypes);
+  std::vector<AbstractHyperGraphElementCreator*> creators(numTypes);
+  for (uint32_t i = 0; i < numTypes; ++i) {
+    BinaryTypeInfo& type = types[i];
+    if (!in.getString(type.tag) || !in.get(type.elementType) ||
+        !in.get(type.raw) || !in.get(type.numVertices) ||
+        !in.get(type.numParameters) || !in.get(type.dataDimension) ||
+        !in.get(type.informationDimension)) {
+      cerr << __PRETTY_FUNCTION__ << ": truncated type table" << endl;
+      return false;
+    }
+    auto renamed = renamedTypesLookup_.find(type.tag);
+    if (renamed != renamedTypesLookup_.end()) type.tag = renamed->second;
+    creators[i] = factory->creator(type.tag);
+    if (!creators[i])
+      cerr << CL_RED(__PRETTY_FUNCTION__ << " unknown type: " << type.tag)
+           << endl;
+  }
+
+  std::shared_ptr<HyperGraph::DataContainer> previousDataContainer;
+  Data* previousData = nullptr;
+  std::vector<int32_t> ids;
+  std::vector<number_t> values;
+  string text;
+  auto construct = [&](uint32_t idx) {
+    std::shared_ptr<HyperGraph::HyperGraphElement> element;
+    if (creators[idx]) element = creators[idx]->construct();
+    return element;
+  };
+  auto readText = [&text](HyperGraph::HyperGraphElement* element) {
+    std::stringstream is(text);
+    if (auto* v = dynamic_cast<Vertex*>(element)) return v->read(is);
+    if (auto* e = dynamic_cast<Edge*>(element)) return e->read(is);
+    if (auto* p = dynamic_cast<Parameter*>(element)) return p->read(is);
+    if (auto* d = dynamic_cast<Data*>(element)) return d->read(is);
+    return false;
+  };
+
+  while (!in.atEnd()) {
+    uint32_t idx;
+    if (!in.get(idx) || idx >= numTypes) {
+      cerr << __PRETTY_FUNCTION__ << ": invalid record" << endl;
+      return false;
+    }
+    const BinaryTypeInfo& type = types[idx];
+    bool ok = true;
+    switch (type.elementType) {
+      case HyperGraph::kHgetParameter: {
+        int32_t id;
+        ok = in.get(id) && in.getString(text);
+        auto p = std::dynamic_pointer_cast<Parameter>(construct(idx));
+        if (!ok || !p) break;
+        p->setId(id);
+        if (!readText(p.get())) {
+          cerr << __PRETTY_FUNCTION__ << ": Error reading data " << type.tag
+               << " for parameter " << id << endl;
+        } else if (!parameters_.addParameter(p)) {
+          cerr << __PRETTY_FUNCTION__ << ": Parameter of type:" << type.tag
+               << " id:" << id << " already defined" << endl;
+        }
+        break;
+      }
+      case HyperGraph::kHgetVertex: {
+        int32_t id;
+        uint8_t fixed;
+        ok = in.get(id) && in.get(fixed);
+        if (type.raw) {
+          values.resize(type.dataDimension);
+          ok = ok && in.getDoubles(values.data(), type.dataDimension);
+        } else {
+          ok = ok && in.getString(text);
+        }
+        previousData = nullptr;
+        auto v = std::dynamic_pointer_cast<Vertex>(construct(idx));
+        if (!ok || !v) break;
+        const bool r = type.raw ? v->setEstimateData(values.data())
+                                : readText(v.get());
+        if (!r)
+          cerr << __PRETTY_FUNCTION__ << ": Error reading vertex " << type.tag
+               << " " << id << endl;
+        v->setId(id);
+        v->setFixed(fixed != 0);
+        if (!addVertex(v)) {
+          cerr << __PRETTY_FUNCTION__ << ": Failure adding Vertex, "
+               << type.tag << " " << id << endl;
+        } else {
+          previousDataContainer = v;
+        }
+        break;
+      }
+      case HyperGraph::kHgetEdge: {
+        uint32_t numVertices = type.numVertices;
+        ok = type.raw || in.get(numVertices);
+        ok = ok && in.getVector(ids, numVertices);
+        std::vector<int32_t> parameterIds;
+        if (type.raw) {
+          values.resize(type.dataDimension +
+                        upperTriangleSize(type.informationDimension));
+          ok = ok && in.getVector(parameterIds, type.numParameters) &&
+               in.getDoubles(values.data(), static_cast<int>(values.size()));
+        } else {
+          ok = ok && in.getString(text);
+        }
+        previousData = nullptr;
+        previousDataContainer = nullptr;
+        auto e = std::dynamic_pointer_cast<Edge>(construct(idx));
+        if (!ok || !e) break;
+        if (e->vertices().size() != numVertices) e->resize(numVertices);
+        bool vertsOkay = true;
+        for (size_t l = 0; l < ids.size(); ++l) {
+          if (ids[l] == HyperGraph::kUnassignedId) continue;
+          auto v = vertex(ids[l]);
+          if (!v) {
+            vertsOkay = false;
+            break;
+          }
+          e->setVertex(l, v);
+        }
+        bool r = vertsOkay;
+        if (r && type.raw) {
+          for (size_t l = 0; l < parameterIds.size(); ++l)
+            r = r && e->setParameterId(l, parameterIds[l]);
+          r = r && e->setMeasurementData(values.data()) &&
+              e->dimension() == static_cast<int>(type.informationDimension);
+          if (r) setUpperTriangle(e.get(), values.data() + type.dataDimension);
+        } else if (r) {
+          r = readText(e.get());
+        }
+        if (!r || !addEdge(e)) {
+          cerr << __PRETTY_FUNCTION__ << ": Unable to add edge " << type.tag
+               << " IDs:";
+          for (int id : ids) cerr << " " << id;
+          cerr << endl;
+          break;
+        }
+        previousDataContainer = e;
+        break;
+      }
+      case HyperGraph::kHgetData: {
+        ok = in.getString(text);
+        auto d = std::dynamic_pointer_cast<Data>(construct(idx));
+        if (!ok || !d) break;
+        if (!readText(d.get())) {
+          cerr << __PRETTY_FUNCTION__ << ": Error reading data " << type.tag
+               << endl;
+          previousData = nullptr;
+        } else if (previousData) {
+          previousData->setNext(d);
+          d->setDataContainer(previousData->dataContainer());
+          previousData = d.get();
+        } else if (previousDataContainer) {
+          previousDataContainer->setUserData(d);
+          d->setDataContainer(previousDataContainer);
+          previousData = d.get();
+          previousDataContainer = nullptr;
+        } else {
+          cerr << __PRETTY_FUNCTION__
+               << ": got data element, but no data container available"
+               << endl;
+          previousData = nullptr;
+        }
+        break;
+      }
+      default:
+        ok = false;
+        break;
+    }
+    if (!ok) {
+      cerr << __PRETTY_FUNCTION__ << ": truncated or invalid record of type "
+           << type.tag << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace g2o
@@ -0,0 +1,274 @@
+// g2o - General Graph Optimization
+// Copyright (C) 2011 R. Kuemmerle, G. Grisetti, W. Burgard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "optimization_algorithm_incremental.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "batch_stats.h"
+#include "g2o/stuff/timeutil.h"
+#include "robust_kernel.h"
+#include "solver.h"
+#include "sparse_optimizer.h"
+
+namespace g2o {
+
+namespace {
+/**
+ * negates the weight of the wrapped kernel, or of the squared error if no
+ * kernel is given, to subtract the contribution of an edge from the Hessian
+ */
+class NegatedRobustKernel : public RobustKernel {
+ public:
+  void setKernel(std::shared_ptr<RobustKernel> kernel) {
+    kernel_ = std::move(kernel);
+  }
+
+  void robustify(number_t squaredError, Vector3& rho) const override {
+    if (kernel_) {
+      kernel_->robustify(squaredError, rho);
+    } else {
+      rho << squaredError, 1., 0.;
+    }
+    rho[1] = -rho[1];
+  }
+
+ protected:
+  std::shared_ptr<RobustKernel> kernel_;
+};
+}  // namespace
+
+OptimizationAlgorithmIncremental::OptimizationAlgorithmIncremental(
+    std::unique_ptr<Solver> solver)
+    : OptimizationAlgorithmWithHessian(*solver),
+      m_solver_{std::move(solver)} {
+  batchEveryN_ = properties_.makeProperty<Property<int> >("batchEveryN", 100);
+  relinearizeThreshold_ = properties_.makeProperty<Property<number_t> >(
+      "relinearizeThreshold", 0.1);
+}
+
+bool OptimizationAlgorithmIncremental::init(bool online) {
+  if (!online) {
+    // a batch optimization starts from the current estimate
+    linearizationPoint_.clear();
+    pendingEdges_.clear();
+    linearizedEdges_.clear();
+    linearized_ = false;
+  }
+  return OptimizationAlgorithmWithHessian::init(online);
+}
+
+void OptimizationAlgorithmIncremental::setBatchEveryN(int n) {
+  batchEveryN_->setValue(n);
+}
+
+void OptimizationAlgorithmIncremental::setRelinearizeThreshold(
+    number_t threshold) {
+  relinearizeThreshold_->setValue(threshold);
+}
+
+OptimizationAlgorithm::SolverResult OptimizationAlgorithmIncremental::solve(
+    int iteration, bool online) {
+  assert(solver_.optimizer() == optimizer_ &&
+         "underlying linear solver operates on different graph");
+  // the Schur complement is not extended by updateStructure()
+  lastStepWasBatch_ = !online || !linearized_ || solver_.schur() ||
+                      stepsSinceBatch_ >= batchEveryN_->value();
+  relinearizedVertices_ = 0;
+  if (lastStepWasBatch_) return batchStep(iteration, online);
+  return incrementalStep();
+}
+
+OptimizationAlgorithm::SolverResult OptimizationAlgorithmIncremental::batchStep(
+    int iteration, bool online) {
+  number_t t = get_monotonic_time();
+  optimizer_->computeActiveErrors();
+  G2OBatchStatistics* globalStats = G2OBatchStatistics::globalStats();
+  if (globalStats) {
+    globalStats->timeResiduals = get_monotonic_time() - t;
+  }
+
+  if (iteration == 0 && !online) {
+    if (!solver_.buildStructure()) {
+      std::cerr << __PRETTY_FUNCTION__
+                << ": Failure while building CCS structure" << std::endl;
+      return OptimizationAlgorithm::kFail;
+    }
+  }
+
+  t = get_monotonic_time();
+  solver_.buildSystem();
+  if (globalStats) {
+    globalStats->timeQuadraticForm = get_monotonic_time() - t;
+  }
+
+  // the current estimate becomes the linearization point
+  linearizationPoint_.setVertices(optimizer_->activeVertices());
+  linearizationPoint_.push();
+  pendingEdges_.clear();
+  linearizedEdges_.clear();
+  for (const auto& e : optimizer_->activeEdges())
+    linearizedEdges_.insert(e.get());
+  linearized_ = true;
+  stepsSinceBatch_ = 0;
+  return solveAndUpdate();
+}
+
+OptimizationAlgorithm::SolverResult
+OptimizationAlgorithmIncremental::incrementalStep() {
+  // back to the linearization point, new vertices keep their estimate
+  linearizationPoint_.pop();
+
+  number_t t = get_monotonic_time();
+  relinearize();
+  for (const auto& e : pendingEdges_) e->computeError();
+  G2OBatchStatistics* globalStats = G2OBatchStatistics::globalStats();
+  if (globalStats) {
+    globalStats->timeResiduals = get_monotonic_time() - t;
+  }
+
+  // the Hessian and the gradient of the vertices still contain the
+  // contribution of the edges linearized before
+  t = get_monotonic_time();
+  JacobianWorkspace& jacobianWorkspace = optimizer_->jacobianWorkspace();
+  for (const auto& e : pendingEdges_) {
+    e->linearizeOplus(jacobianWorkspace);
+    e->constructQuadraticForm();
+    linearizedEdges_.insert(e.get());
+  }
+  number_t* b = solver_.b();
+  for (auto* v : optimizer_->indexMapping()) v->copyB(b + v->colInHessian());
+  if (globalStats) {
+    globalStats->timeQuadraticForm = get_monotonic_time() - t;
+  }
+
+  linearizationPoint_.setVertices(optimizer_->activeVertices());
+  linearizationPoint_.push();
+  pendingEdges_.clear();
+  ++stepsSinceBatch_;
+  return solveAndUpdate();
+}
+
+void OptimizationAlgorithmIncremental::relinearize() {
+  const number_t threshold = relinearizeThreshold_->value();
+  if (threshold <= 0) return;
+
+  // vertices added after the last step are not part of delta_
+  std::vector<OptimizableGraph::Vertex*> vertices;
+  for (auto* v : optimizer_->indexMapping()) {
+    const int base = v->colInHessian();
+    if (base < 0 || base + v->dimension() > delta_.size()) continue;
+    if (delta_.segment(base, v->dimension()).lpNorm<Eigen::Infinity>() >
+        threshold)
+      vertices.push_back(v);
+  }
+  relinearizedVertices_ = static_cast<int>(vertices.size());
+  if (vertices.empty()) return;
+
+  // the edges of an already linearized vertex which are in the Hessian,
+  // ordered by their id for a deterministic sum
+  std::vector<OptimizableGraph::Edge*> edges;
+  for (auto* v : vertices) {
+    for (HyperGraph::Edge* e : v->adjacentEdges()) {
+      auto* edge = static_cast<OptimizableGraph::Edge*>(e);
+      if (linearizedEdges_.count(edge)) edges.push_back(edge);
+    }
+  }
+  std::sort(edges.begin(), edges.end(),
+            [](const OptimizableGraph::Edge* e1,
+               const OptimizableGraph::Edge* e2) {
+              return e1->internalId() < e2->internalId();
+            });
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+  // subtract the contribution at the old linearization point, where all the
+  // vertices are after restoring the estimate
+  JacobianWorkspace& jacobianWorkspace = optimizer_->jacobianWorkspace();
+  auto negatedKernel = std::make_shared<NegatedRobustKernel>();
+  for (auto* e : edges) {
+    std::shared_ptr<RobustKernel> kernel = e->robustKernel();
+    negatedKernel->setKernel(kernel);
+    e->setRobustKernel(negatedKernel);
+    e->computeError();
+    e->linearizeOplus(jacobianWorkspace);
+    e->constructQuadraticForm();
+    e->setRobustKernel(kernel);
+  }
+
+  // the estimate of the last step becomes the linearization point
+  for (auto* v : vertices) {
+    VectorX::MapType update(delta_.data() + v->colInHessian(), v->dimension());
+    v->oplus(update);
+  }
+  for (auto* e : edges) {
+    e->computeError();
+    e->linearizeOplus(jacobianWorkspace);
+    e->constructQuadraticForm();
+  }
+}
+
+OptimizationAlgorithm::SolverResult
+OptimizationAlgorithmIncremental::solveAndUpdate() {
+  number_t t = get_monotonic_time();
+  const bool ok = solver_.solve();
+  delta_ = VectorX::ConstMapType(solver_.x(), solver_.vectorSize());
+  G2OBatchStatistics* globalStats = G2OBatchStatistics::globalStats();
+  if (globalStats) {
+    globalStats->timeLinearSolution = get_monotonic_time() - t;
+    t = get_monotonic_time();
+  }
+
+  optimizer_->update(solver_.x());
+  if (globalStats) {
+    globalStats->timeUpdate = get_monotonic_time() - t;
+  }
+  return ok ? kOk : kFail;
+}
+
+bool OptimizationAlgorithmIncremental::updateStructure(
+    const HyperGraph::VertexContainer& vset, const HyperGraph::EdgeSet& edges) {
+  if (!OptimizationAlgorithmWithHessian::updateStructure(vset, edges))
+    return false;
+  for (const auto& v : vset)
+    static_cast<OptimizableGraph::Vertex*>(v.get())->clearQuadraticForm();
+  JacobianWorkspace& jacobianWorkspace = optimizer_->jacobianWorkspace();
+  for (const auto& it : edges) {
+    auto e = std::static_pointer_cast<OptimizableGraph::Edge>(it);
+    if (e->allVerticesFixed()) continue;
+    jacobianWorkspace.updateSize(e.get());
+    pendingEdges_.push_back(e);
+  }
+  jacobianWorkspace.allocate();
+  return true;
+}
+
+void OptimizationAlgorithmIncremental::printVerbose(std::ostream& os) const {
+  os << "\t batch= " << lastStepWasBatch_
+     << "\t relinearized= " << relinearizedVertices_;
+}
+
+}  // namespace g2o
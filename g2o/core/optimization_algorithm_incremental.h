@@ -0,0 +1,131 @@
+// g2o - General Graph Optimization
+// Copyright (C) 2011 R. Kuemmerle, G. Grisetti, W. Burgard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef G2O_OPTIMIZATION_ALGORITHM_INCREMENTAL_H
+#define G2O_OPTIMIZATION_ALGORITHM_INCREMENTAL_H
+
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "estimate_stack.h"
+#include "g2o_core_api.h"
+#include "optimizable_graph.h"
+#include "optimization_algorithm_with_hessian.h"
+
+namespace g2o {
+
+/**
+ * \brief Gauss-Newton for online operation, keeping the linearization point
+ *
+ * Intended for growing a graph by SparseOptimizer::updateInitialization()
+ * followed by SparseOptimizer::optimize() with online set to true. The
+ * system is linearized around the estimate of the last batch step. An online
+ * step restores this linearization point and linearizes only the edges which
+ * were added since the previous step, adding their contribution to the
+ * Hessian and the gradient. The estimate is the linearization point updated
+ * by the solution of the system. As the Hessian of the earlier part of the
+ * graph does not change, an incremental linear solver, e.g.,
+ * LinearSolverSupernodal::setIncremental(), only re-factorizes the part of
+ * the factor affected by the new edges.
+ *
+ * Optimizing with online set to false, the first online step, and every
+ * batchEveryN-th online step relinearize all the edges at the current
+ * estimate like OptimizationAlgorithmGaussNewton.
+ *
+ * In between, the linearization point is kept per vertex (fluid
+ * relinearization). An online step relinearizes the vertices whose update
+ * from their linearization point exceeds relinearizeThreshold in one of its
+ * components: the contribution of their edges at the old linearization point
+ * is subtracted from the Hessian and the gradient and added again at the
+ * current estimate. Only the part of the factor depending on those vertices
+ * is re-factorized. A threshold of zero or less disables the fluid
+ * relinearization.
+ */
+class G2O_CORE_API OptimizationAlgorithmIncremental
+    : public OptimizationAlgorithmWithHessian {
+ public:
+  /**
+   * construct the algorithm, which uses the given Solver for solving the
+   * linearized system.
+   */
+  explicit OptimizationAlgorithmIncremental(std::unique_ptr<Solver> solver);
+
+  bool init(bool online = false) override;
+
+  SolverResult solve(int iteration, bool online = false) override;
+
+  bool updateStructure(const HyperGraph::VertexContainer& vset,
+                       const HyperGraph::EdgeSet& edges) override;
+
+  void printVerbose(std::ostream& os) const override;
+
+  //! number of online steps after which all edges are relinearized
+  int batchEveryN() const { return batchEveryN_->value(); }
+  void setBatchEveryN(int n);
+
+  //! update of a vertex above which an online step relinearizes it
+  number_t relinearizeThreshold() const {
+    return relinearizeThreshold_->value();
+  }
+  void setRelinearizeThreshold(number_t threshold);
+
+  //! true if the last step linearized all edges
+  bool lastStepWasBatch() const { return lastStepWasBatch_; }
+
+  //! number of vertices relinearized by the last online step
+  int relinearizedVertices() const { return relinearizedVertices_; }
+
+ protected:
+  std::unique_ptr<Solver> m_solver_;
+  std::shared_ptr<Property<int>> batchEveryN_;
+  std::shared_ptr<Property<number_t>> relinearizeThreshold_;
+  //! estimate of the active vertices at their last linearization
+  EstimateStack linearizationPoint_;
+  //! active edges added after the last step
+  std::vector<std::shared_ptr<OptimizableGraph::Edge>> pendingEdges_;
+  //! edges whose contribution is part of the Hessian
+  std::unordered_set<const OptimizableGraph::Edge*> linearizedEdges_;
+  //! solution of the last step, the update from the linearization point
+  VectorX delta_;
+  bool linearized_ = false;
+  bool lastStepWasBatch_ = false;
+  int stepsSinceBatch_ = 0;
+  int relinearizedVertices_ = 0;
+
+  //! linearize all the edges at the current estimate
+  SolverResult batchStep(int iteration, bool online);
+  //! add the pending edges to the system of the linearization point
+  SolverResult incrementalStep();
+  //! move the linearization point of the vertices exceeding the threshold
+  void relinearize();
+  //! solve the linear system and update the estimate
+  SolverResult solveAndUpdate();
+};
+
+}  // namespace g2o
+
+#endif
@@ -0,0 +1,236 @@
+// g2o - General Graph Optimization
+// Copyright (C) 2011 R. Kuemmerle, G. Grisetti, W. Burgard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parallel_executor.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "g2o/config.h"
+
+#ifdef G2O_OPENMP
+#include <omp.h>
+#endif
+
+namespace g2o {
+
+namespace {
+
+//! the pool and index of the current thread while it runs a loop of a pool
+thread_local const WorkStealingExecutor* currentExecutor = nullptr;
+thread_local int currentThread = 0;
+
+#ifdef G2O_OPENMP
+/**
+ * \brief Runs the loops with OpenMP, each chunk of grain items is a task
+ */
+class OpenMPExecutor : public ParallelExecutor {
+ public:
+  int numThreads() const override { return omp_get_max_threads(); }
+  void parallelFor(int n, int grain, const RangeFunction& body) override {
+    grain = std::max(grain, 1);
+    const int numChunks = (n + grain - 1) / grain;
+#pragma omp parallel for default(shared) schedule(dynamic) if (numChunks > 1)
+    for (int chunk = 0; chunk < numChunks; ++chunk) {
+      const int begin = chunk * grain;
+      body(begin, std::min(n, begin + grain), omp_get_thread_num());
+    }
+  }
+};
+#endif
+
+}  // namespace
+
+ParallelExecutor& ParallelExecutor::defaultExecutor() {
+#ifdef G2O_OPENMP
+  static OpenMPExecutor executor;
+#else
+  static SequentialExecutor executor;
+#endif
+  return executor;
+}
+
+void SequentialExecutor::parallelFor(int n, int /*grain*/,
+                                     const RangeFunction& body) {
+  if (n > 0) body(0, n, 0);
+}
+
+WorkStealingExecutor::WorkStealingExecutor(int numThreads) {
+  if (numThreads <= 0) {
+    numThreads =
+        std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+  ranges_.reset(new WorkerRange[numThreads]);
+  workers_.reserve(numThreads - 1);
+  for (int i = 1; i < numThreads; ++i)
+    workers_.emplace_back(&WorkStealingExecutor::workerLoop, this, i);
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wakeUp_.notify_all();
+  for (auto& worker : workers_) worker.join();
+}
+
+void WorkStealingExecutor::parallelFor(int n, int grain,
+                                       const RangeFunction& body) {
+  if (n <= 0) return;
+  grain = std::max(grain, 1);
+  // nested loops and loops issued while the pool is busy run sequentially
+  if (currentExecutor == this) {
+    body(0, n, currentThread);
+    return;
+  }
+  std::unique_lock<std::mutex> jobLock(jobMutex_, std::try_to_lock);
+  if (workers_.empty() || grain >= n || !jobLock.owns_lock()) {
+    body(0, n, 0);
+    return;
+  }
+
+  const int numThreads = this->numThreads();
+  for (int i = 0; i < numThreads; ++i) {
+    ranges_[i].begin =
+        static_cast<int>(static_cast<int64_t>(n) * i / numThreads);
+    ranges_[i].end =
+        static_cast<int>(static_cast<int64_t>(n) * (i + 1) / numThreads);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    body_ = &body;
+    grain_ = grain;
+    cancelled_ = false;
+    error_ = nullptr;
+    pendingWorkers_ = static_cast<int>(workers_.size());
+    ++generation_;
+  }
+  wakeUp_.notify_all();
+
+  const WorkStealingExecutor* previousExecutor = currentExecutor;
+  const int previousThread = currentThread;
+  currentExecutor = this;
+  currentThread = 0;
+  runJob(0);
+  currentExecutor = previousExecutor;
+  currentThread = previousThread;
+
+  std::exception_ptr error;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return pendingWorkers_ == 0; });
+    body_ = nullptr;
+    std::swap(error, error_);
+  }
+  if (error) std::rethrow_exception(error);
+}
+
+void WorkStealingExecutor::workerLoop(int thread) {
+  currentExecutor = this;
+  currentThread = thread;
+  uint64_t generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wakeUp_.wait(lock, [&] { return stop_ || generation_ != generation; });
+      if (stop_) return;
+      generation = generation_;
+    }
+    runJob(thread);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--pendingWorkers_ == 0) done_.notify_one();
+    }
+  }
+}
+
+void WorkStealingExecutor::runJob(int thread) {
+  WorkerRange& own = ranges_[thread];
+  while (true) {
+    int begin;
+    int end;
+    {
+      std::lock_guard<std::mutex> lock(own.mutex);
+      begin = own.begin;
+      end = std::min(own.end, begin + grain_);
+      own.begin = end;
+    }
+    if (begin >= end) {
+      if (steal(thread)) continue;
+      return;
+    }
+    try {
+      (*body_)(begin, end, thread);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!error_) error_ = std::current_exception();
+      cancelled_ = true;
+    }
+    if (cancelled_) return;
+  }
+}
+
+bool WorkStealingExecutor::steal(int thread) {
+  const int numThreads = this->numThreads();
+  for (int k = 1; k < numThreads; ++k) {
+    WorkerRange& victim = ranges_[(thread + k) % numThreads];
+    int begin;
+    int end;
+    {
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      const int remaining = victim.end - victim.begin;
+      if (remaining <= 0) continue;
+      end = victim.end;
+      begin = end - (remaining + 1) / 2;
+      victim.end = begin;
+    }
+    WorkerRange& own = ranges_[thread];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    own.begin = begin;
+    own.end = end;
+    return true;
+  }
+  return false;
+}
+
+int AdaptiveGrain::grain(int n, int numThreads) const {
+  if (numThreads <= 1 || n <= 1) return n;
+  // not yet measured, a few chunks per thread
+  if (secondsPerItem_ <= 0.) return std::max(1, n / (4 * numThreads));
+  if (n * secondsPerItem_ < 2 * kTaskSeconds) return n;
+  const double items = std::ceil(kTaskSeconds / secondsPerItem_);
+  return static_cast<int>(std::min<double>(std::max(items, 1.), n));
+}
+
+void AdaptiveGrain::update(int n, int numThreads, double seconds) {
+  if (n <= 0) return;
+  const double sample = seconds * std::max(numThreads, 1) / n;
+  secondsPerItem_ =
+      secondsPerItem_ <= 0. ? sample : 0.75 * secondsPerItem_ + 0.25 * sample;
+}
+
+}  // namespace g2o
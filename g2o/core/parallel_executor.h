@@ -0,0 +1,195 @@
+// g2o - General Graph Optimization
+// Copyright (C) 2011 R. Kuemmerle, G. Grisetti, W. Burgard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef G2O_PARALLEL_EXECUTOR_H
+#define G2O_PARALLEL_EXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "g2o/stuff/timeutil.h"
+#include "g2o_core_api.h"
+
+namespace g2o {
+
+/**
+ * \brief Interface for running the parallel loops of the optimization
+ *
+ * An executor splits the index range [0, n) of a loop into disjoint ranges and
+ * runs a function on each of them, possibly in parallel. Implement this
+ * interface to run g2o on an existing thread pool.
+ */
+class G2O_CORE_API ParallelExecutor {
+ public:
+  /**
+   * function processing the items [begin, end) of a loop. thread is the index
+   * of the thread running the function, in [0, numThreads()), and allows to
+   * use per-thread temporary storage.
+   */
+  using RangeFunction = std::function<void(int begin, int end, int thread)>;
+
+  virtual ~ParallelExecutor() = default;
+
+  //! maximal number of threads executing a loop
+  virtual int numThreads() const = 0;
+
+  /**
+   * run body on disjoint ranges covering [0, n) of at most grain items each.
+   * Returns after all ranges have been processed. Two ranges processed
+   * concurrently never have the same thread index.
+   */
+  virtual void parallelFor(int n, int grain, const RangeFunction& body) = 0;
+
+  /**
+   * the executor used if none is configured. It runs the loops with OpenMP if
+   * g2o was compiled with it, otherwise sequentially.
+   */
+  static ParallelExecutor& defaultExecutor();
+};
+
+/**
+ * \brief Runs all loops on the calling thread
+ */
+class G2O_CORE_API SequentialExecutor : public ParallelExecutor {
+ public:
+  int numThreads() const override { return 1; }
+  void parallelFor(int n, int grain, const RangeFunction& body) override;
+};
+
+/**
+ * \brief Thread pool based on std::thread with work stealing
+ *
+ * Each thread owns a contiguous part of the loop and processes it in chunks of
+ * grain items. A thread running out of work steals the back half of the
+ * remaining part of another thread. The calling thread takes part in the loop,
+ * idle workers block on a condition variable instead of spinning.
+ */
+class G2O_CORE_API WorkStealingExecutor : public ParallelExecutor {
+ public:
+  /**
+   * create a pool running loops on numThreads threads including the calling
+   * thread. numThreads <= 0 selects the number of hardware threads.
+   */
+  explicit WorkStealingExecutor(int numThreads = 0);
+  ~WorkStealingExecutor() override;
+  WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+  WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+  int numThreads() const override {
+    return static_cast<int>(workers_.size()) + 1;
+  }
+  void parallelFor(int n, int grain, const RangeFunction& body) override;
+
+ protected:
+  //! the part of the loop owned by a thread
+  struct alignas(64) WorkerRange {
+    std::mutex mutex;
+    int begin = 0;
+    int end = 0;
+  };
+
+  void workerLoop(int thread);
+  void runJob(int thread);
+  bool steal(int thread);
+
+  std::vector<std::thread> workers_;
+  std::unique_ptr<WorkerRange[]> ranges_;
+
+  std::mutex jobMutex_;  ///< only one loop at a time runs on the pool
+  std::mutex mutex_;     ///< protects the state below
+  std::condition_variable wakeUp_;
+  std::condition_variable done_;
+  const RangeFunction* body_ = nullptr;
+  int grain_ = 1;
+  int pendingWorkers_ = 0;
+  uint64_t generation_ = 0;
+  bool stop_ = false;
+  std::atomic<bool> cancelled_{false};  ///< a thread threw an exception
+  std::exception_ptr error_;
+};
+
+/**
+ * \brief Estimates the number of loop items per task
+ *
+ * Keeps track of the time spent per item of a specific loop and derives the
+ * chunk size such that a task takes about kTaskSeconds. Loops whose total work
+ * is below two tasks are run on the calling thread.
+ */
+class G2O_CORE_API AdaptiveGrain {
+ public:
+  //! target duration of a single task
+  static constexpr double kTaskSeconds = 5e-5;
+
+  /**
+   * number of items per task for a loop over n items on numThreads threads.
+   * Returns n if the loop should be run on the calling thread.
+   */
+  int grain(int n, int numThreads) const;
+
+  //! record the time spent on a loop over n items on numThreads threads
+  void update(int n, int numThreads, double seconds);
+
+  //! estimated time per item, zero if not yet measured
+  double secondsPerItem() const { return secondsPerItem_; }
+
+ protected:
+  double secondsPerItem_ = 0.;
+};
+
+/**
+ * run body(begin, end, thread) over [0, n) on the executor using the grain
+ * estimated by adaptiveGrain and update the estimate afterwards.
+ */
+template <typename Body>
+void parallelFor(ParallelExecutor& executor, AdaptiveGrain& adaptiveGrain,
+                 int n, Body&& body) {
+  if (n <= 0) return;
+  const int numThreads = executor.numThreads();
+  if (numThreads <= 1) {
+    body(0, n, 0);
+    return;
+  }
+  const int grain = adaptiveGrain.grain(n, numThreads);
+  const double start = get_monotonic_time();
+  if (grain >= n) {
+    body(0, n, 0);
+    adaptiveGrain.update(n, 1, get_monotonic_time() - start);
+    return;
+  }
+  executor.parallelFor(n, grain, std::forward<Body>(body));
+  adaptiveGrain.update(n, numThreads, get_monotonic_time() - start);
+}
+
+}  // namespace g2o
+
+#endif
@@ -28,6 +28,7 @@
 #define G2O_SPARSE_BLOCK_MATRIX_
 
 #include <Eigen/Core>
+#include <algorithm>
 #include <cassert>
 #include <fstream>
 #include <iomanip>
@@ -39,6 +40,7 @@
 #include "g2o/config.h"
 #include "g2o/stuff/misc.h"
 #include "g2o/stuff/sparse_helper.h"
+#include "block_arena.h"
 #include "matrix_operations.h"
 #include "matrix_structure.h"
 #include "sparse_block_matrix_ccs.h"
@@ -59,6 +61,15 @@ namespace g2o {
  * template argument.  If this is not the case, and you have different
  * block sizes than you have to use a dynamic-block matrix (default
  * template argument).
+ *
+ * By default each block is allocated individually on the heap. Enabling the
+ * arena storage (see setArenaStorage()) places the blocks into a few
+ * contiguous slabs which are recycled by clear(true).
+ *
+ * The pattern is stored as a map per block-column which allows inserting new
+ * blocks efficiently. Once the pattern is complete, freezeStructure() copies
+ * it into compressed-column arrays which are used by the computational
+ * kernels, e.g., multiply() or fillCCS(), instead of traversing the maps.
  */
 template <class MatrixType = MatrixX>
 class SparseBlockMatrix {
@@ -95,13 +106,49 @@ class SparseBlockMatrix {
                     bool hasStorage = true);
 
   SparseBlockMatrix();
+  SparseBlockMatrix(const SparseBlockMatrix&) = delete;
+  SparseBlockMatrix(SparseBlockMatrix&& other) noexcept;
 
   ~SparseBlockMatrix();
 
+  SparseBlockMatrix& operator=(const SparseBlockMatrix&) = delete;
+  //! takes over the blocks of other, the blocks of this matrix are freed
+  SparseBlockMatrix& operator=(SparseBlockMatrix&& other) noexcept;
+
   //! this zeroes all the blocks. If dealloc=true the blocks are removed from
-  //! memory
+  //! memory. With arena storage the memory is kept for re-use.
   void clear(bool dealloc = false);
 
+  /**
+   * allocate the blocks from a contiguous arena instead of the heap. Can only
+   * be changed as long as the matrix has no blocks.
+   * @returns false if the storage mode cannot be changed.
+   */
+  bool setArenaStorage(bool arena);
+  //! are the blocks allocated from an arena
+  bool arenaStorage() const { return arena_ != nullptr; }
+  //! the arena holding the blocks, nullptr if blocks are on the heap
+  const BlockArena<MatrixType>* arena() const { return arena_.get(); }
+
+  /**
+   * re-allocate all blocks in a single slab of the arena laid out column by
+   * column. Enables the arena storage if not yet enabled. All pointers to the
+   * blocks are invalidated by this call.
+   */
+  void compactStorage();
+
+  /**
+   * store the current block pattern in compressed-column arrays which are
+   * traversed by the computational kernels. The frozen pattern is dropped as
+   * soon as the pattern changes, e.g., by allocating a new block or by
+   * accessing the non-const blockCols().
+   */
+  void freezeStructure();
+  //! drop the compressed-column arrays of the pattern
+  void unfreezeStructure();
+  //! is the pattern available in compressed-column arrays
+  bool frozen() const { return frozen_; }
+
   //! returns the block at location r,c. if alloc=true he block is created if it
   //! does not exist
   SparseMatrixBlock* block(int r, int c, bool alloc = false);
@@ -210,7 +257,11 @@ class SparseBlockMatrix {
 
   //! the block matrices per block-column
   const std::vector<IntBlockMap>& blockCols() const { return blockCols_; }
-  std::vector<IntBlockMap>& blockCols() { return blockCols_; }
+  //! the block matrices per block-column, drops the frozen pattern
+  std::vector<IntBlockMap>& blockCols() {
+    unfreezeStructure();
+    return blockCols_;
+  }
 
   //! indices of the row blocks
   const std::vector<int>& rowBlockIndices() const { return rowBlockIndices_; }
@@ -257,8 +308,31 @@ class SparseBlockMatrix {
   //! matrix_block_ptr.
   std::vector<IntBlockMap> blockCols_;
   bool hasStorage_{true};
+  std::unique_ptr<BlockArena<MatrixType>>
+      arena_;  ///< storage of the blocks, if nullptr each block is on the heap
+
+  //! the frozen pattern in compressed-column form, see freezeStructure()
+  bool frozen_{false};
+  std::vector<int> frozenColPtr_;  ///< start of each block-column in the arrays
+  std::vector<int> frozenRowIdx_;  ///< block-row of each block
+  std::vector<SparseMatrixBlock*> frozenBlocks_;  ///< pointer to each block
 
  private:
+  //! create a new zero block at the given block-row and block-column
+  SparseMatrixBlock* allocateBlock(int r, int c);
+  //! create a new block which is a copy of other
+  SparseMatrixBlock* allocateBlock(const SparseMatrixBlock& other);
+
+  //! returns the block at r,c of the frozen pattern or nullptr
+  SparseMatrixBlock* frozenBlock(int r, int c) const;
+
+  /**
+   * calls f(r, block) for all blocks of the block-column c in increasing order
+   * of the block-row r.
+   */
+  template <typename Func>
+  void forEachBlockInColumn(int c, Func&& f) const;
+
   template <class MatrixTransposedType>
   void transpose_internal(SparseBlockMatrix<MatrixTransposedType>& dest) const;
 
@@ -38,8 +38,53 @@ SparseBlockMatrix<MatrixType>::SparseBlockMatrix(const int* rbi, const int* cbi,
 template <class MatrixType>
 SparseBlockMatrix<MatrixType>::SparseBlockMatrix() : blockCols_(0) {}
 
+template <class MatrixType>
+SparseBlockMatrix<MatrixType>::SparseBlockMatrix(
+    SparseBlockMatrix&& other) noexcept
+    : rowBlockIndices_(std::move(other.rowBlockIndices_)),
+      colBlockIndices_(std::move(other.colBlockIndices_)),
+      blockCols_(std::move(other.blockCols_)),
+      hasStorage_(other.hasStorage_),
+      arena_(std::move(other.arena_)),
+      frozen_(other.frozen_),
+      frozenColPtr_(std::move(other.frozenColPtr_)),
+      frozenRowIdx_(std::move(other.frozenRowIdx_)),
+      frozenBlocks_(std::move(other.frozenBlocks_)) {
+  other.blockCols_.clear();
+  other.unfreezeStructure();
+}
+
+template <class MatrixType>
+SparseBlockMatrix<MatrixType>& SparseBlockMatrix<MatrixType>::operator=(
+    SparseBlockMatrix&& other) noexcept {
+  if (this == &other) return *this;
+  if (hasStorage_) clear(true);
+  rowBlockIndices_ = std::move(other.rowBlockIndices_);
+  colBlockIndices_ = std::move(other.colBlockIndices_);
+  blockCols_ = std::move(other.blockCols_);
+  hasStorage_ = other.hasStorage_;
+  arena_ = std::move(other.arena_);
+  frozen_ = other.frozen_;
+  frozenColPtr_ = std::move(other.frozenColPtr_);
+  frozenRowIdx_ = std::move(other.frozenRowIdx_);
+  frozenBlocks_ = std::move(other.frozenBlocks_);
+  other.blockCols_.clear();
+  other.unfreezeStructure();
+  return *this;
+}
+
 template <class MatrixType>
 void SparseBlockMatrix<MatrixType>::clear(bool dealloc) {
+  const bool freeBlocks = hasStorage_ && dealloc;
+  if (frozen_ && !freeBlocks) {
+#ifdef G2O_OPENMP
+#pragma omp parallel for default(shared) if (frozenBlocks_.size() > 100)
+#endif
+    for (int i = 0; i < static_cast<int>(frozenBlocks_.size()); ++i)
+      frozenBlocks_[i]->setZero();
+    return;
+  }
+  if (freeBlocks) unfreezeStructure();
 #ifdef G2O_OPENMP
 #pragma omp parallel for default(shared) if (blockCols_.size() > 100)
 #endif
@@ -48,13 +93,112 @@ void SparseBlockMatrix<MatrixType>::clear(bool dealloc) {
              it = blockCols_[i].begin();
          it != blockCols_[i].end(); ++it) {
       typename SparseBlockMatrix<MatrixType>::SparseMatrixBlock* b = it->second;
-      if (hasStorage_ && dealloc)
-        delete b;
-      else
+      if (!freeBlocks)
         b->setZero();
+      else if (!arena_)
+        delete b;
+    }
+    if (freeBlocks) blockCols_[i].clear();
+  }
+  // the arena keeps its memory for re-using it
+  if (freeBlocks && arena_) arena_->reset();
+}
+
+template <class MatrixType>
+bool SparseBlockMatrix<MatrixType>::setArenaStorage(bool arena) {
+  if (arena == arenaStorage()) return true;
+  if (!hasStorage_ || nonZeroBlocks() > 0) return false;
+  if (arena)
+    arena_ = g2o::make_unique<BlockArena<MatrixType>>();
+  else
+    arena_.reset();
+  return true;
+}
+
+template <class MatrixType>
+void SparseBlockMatrix<MatrixType>::compactStorage() {
+  if (!hasStorage_) return;
+  auto compacted = g2o::make_unique<BlockArena<MatrixType>>();
+  compacted->reserve(nonZeroBlocks());
+  for (auto& column : blockCols_) {
+    for (auto& block : column) {
+      SparseMatrixBlock* b = compacted->allocate(*block.second);
+      if (!arena_) delete block.second;
+      block.second = b;
+    }
+  }
+  arena_ = std::move(compacted);
+  // the frozen pattern holds the old block pointers
+  if (frozen_) freezeStructure();
+}
+
+template <class MatrixType>
+void SparseBlockMatrix<MatrixType>::freezeStructure() {
+  frozenColPtr_.resize(blockCols_.size() + 1);
+  frozenRowIdx_.clear();
+  frozenBlocks_.clear();
+  size_t numBlocks = 0;
+  for (const auto& column : blockCols_) numBlocks += column.size();
+  frozenRowIdx_.reserve(numBlocks);
+  frozenBlocks_.reserve(numBlocks);
+  for (size_t i = 0; i < blockCols_.size(); ++i) {
+    frozenColPtr_[i] = frozenRowIdx_.size();
+    for (const auto& block : blockCols_[i]) {
+      frozenRowIdx_.push_back(block.first);
+      frozenBlocks_.push_back(block.second);
     }
-    if (hasStorage_ && dealloc) blockCols_[i].clear();
   }
+  frozenColPtr_.back() = frozenRowIdx_.size();
+  frozen_ = true;
+}
+
+template <class MatrixType>
+void SparseBlockMatrix<MatrixType>::unfreezeStructure() {
+  if (!frozen_) return;
+  frozen_ = false;
+  frozenColPtr_.clear();
+  frozenRowIdx_.clear();
+  frozenBlocks_.clear();
+}
+
+template <class MatrixType>
+typename SparseBlockMatrix<MatrixType>::SparseMatrixBlock*
+SparseBlockMatrix<MatrixType>::frozenBlock(int r, int c) const {
+  const auto first = frozenRowIdx_.begin() + frozenColPtr_[c];
+  const auto last = frozenRowIdx_.begin() + frozenColPtr_[c + 1];
+  const auto it = std::lower_bound(first, last, r);
+  if (it == last || *it != r) return nullptr;
+  return frozenBlocks_[it - frozenRowIdx_.begin()];
+}
+
+template <class MatrixType>
+template <typename Func>
+void SparseBlockMatrix<MatrixType>::forEachBlockInColumn(int c,
+                                                         Func&& f) const {
+  if (frozen_) {
+    for (int k = frozenColPtr_[c]; k < frozenColPtr_[c + 1]; ++k)
+      f(frozenRowIdx_[k], frozenBlocks_[k]);
+    return;
+  }
+  for (const auto& block : blockCols_[c]) f(block.first, block.second);
+}
+
+template <class MatrixType>
+typename SparseBlockMatrix<MatrixType>::SparseMatrixBlock*
+SparseBlockMatrix<MatrixType>::allocateBlock(int r, int c) {
+  const int rb = rowsOfBlock(r);
+  const int cb = colsOfBlock(c);
+  if (arena_) return arena_->allocate(rb, cb);
+  auto* b = new SparseMatrixBlock(rb, cb);
+  b->setZero();
+  return b;
+}
+
+template <class MatrixType>
+typename SparseBlockMatrix<MatrixType>::SparseMatrixBlock*
+SparseBlockMatrix<MatrixType>::allocateBlock(const SparseMatrixBlock& other) {
+  if (arena_) return arena_->allocate(other);
+  return new SparseMatrixBlock(other);
 }
 
 template <class MatrixType>
@@ -65,15 +209,16 @@ SparseBlockMatrix<MatrixType>::~SparseBlockMatrix() {
 template <class MatrixType>
 typename SparseBlockMatrix<MatrixType>::SparseMatrixBlock*
 SparseBlockMatrix<MatrixType>::block(int r, int c, bool alloc) {
+  if (frozen_) {
+    SparseMatrixBlock* b = frozenBlock(r, c);
+    if (b || !alloc) return b;
+    unfreezeStructure();  // the pattern is going to change
+  }
   auto it = blockCols_[c].find(r);
   typename SparseBlockMatrix<MatrixType>::SparseMatrixBlock* _block = nullptr;
   if (it == blockCols_[c].end()) {
     if (!hasStorage_ && !alloc) return nullptr;
-    int rb = rowsOfBlock(r);
-    int cb = colsOfBlock(c);
-    _block =
-        new typename SparseBlockMatrix<MatrixType>::SparseMatrixBlock(rb, cb);
-    _block->setZero();
+    _block = allocateBlock(r, c);
     std::pair<typename SparseBlockMatrix<MatrixType>::IntBlockMap::iterator,
               bool>
         result = blockCols_[c].insert(std::make_pair(r, _block));
@@ -89,6 +234,7 @@ SparseBlockMatrix<MatrixType>::block(int r, int c, bool alloc) {
 template <class MatrixType>
 const typename SparseBlockMatrix<MatrixType>::SparseMatrixBlock*
 SparseBlockMatrix<MatrixType>::block(int r, int c) const {
+  if (frozen_) return frozenBlock(r, c);
   auto it = blockCols_[c].find(r);
   if (it == blockCols_[c].end()) return nullptr;
   return it->second;
@@ -99,16 +245,21 @@ SparseBlockMatrix<MatrixType>* SparseBlockMatrix<MatrixType>::clone() const {
   auto* ret =
       new SparseBlockMatrix(rowBlockIndices_.data(), colBlockIndices_.data(),
                             rowBlockIndices_.size(), colBlockIndices_.size());
+  if (arena_) {
+    ret->setArenaStorage(true);
+    ret->arena_->reserve(nonZeroBlocks());
+  }
   for (size_t i = 0; i < blockCols_.size(); ++i) {
     for (typename SparseBlockMatrix<MatrixType>::IntBlockMap::const_iterator
              it = blockCols_[i].begin();
          it != blockCols_[i].end(); ++it) {
-      auto* b = new typename SparseBlockMatrix<MatrixType>::SparseMatrixBlock(
-          *it->second);
-      ret->blockCols_[i].insert(std::make_pair(it->first, b));
+      auto* b = ret->allocateBlock(*it->second);
+      ret->blockCols_[i].insert(ret->blockCols_[i].end(),
+                                std::make_pair(it->first, b));
     }
   }
   ret->hasStorage_ = true;
+  if (frozen_) ret->freezeStructure();
   return ret;
 }
 
@@ -160,12 +311,10 @@ template <class MatrixType>
 void SparseBlockMatrix<MatrixType>::add_internal(
     SparseBlockMatrix<MatrixType>& dest) const {
   for (size_t i = 0; i < blockCols_.size(); ++i) {
-    for (auto it = blockCols_[i].begin(); it != blockCols_[i].end(); ++it) {
-      typename SparseBlockMatrix<MatrixType>::SparseMatrixBlock* s = it->second;
-      typename SparseBlockMatrix<MatrixType>::SparseMatrixBlock* d =
-          dest.block(it->first, i, true);
+    forEachBlockInColumn(i, [&](int r, const SparseMatrixBlock* s) {
+      SparseMatrixBlock* d = dest.block(r, i, true);
       (*d) += *s;
-    }
+    });
   }
 }
 
@@ -251,17 +400,12 @@ void SparseBlockMatrix<MatrixType>::multiply(number_t*& dest,
   for (size_t i = 0; i < blockCols_.size(); ++i) {
     int srcOffset = i ? colBlockIndices_[i - 1] : 0;
 
-    for (typename SparseBlockMatrix<MatrixType>::IntBlockMap::const_iterator
-             it = blockCols_[i].begin();
-         it != blockCols_[i].end(); ++it) {
-      const typename SparseBlockMatrix<MatrixType>::SparseMatrixBlock* a =
-          it->second;
-      int destOffset = it->first ? rowBlockIndices_[it->first - 1] : 0;
+    forEachBlockInColumn(i, [&](int r, const SparseMatrixBlock* a) {
+      int destOffset = r ? rowBlockIndices_[r - 1] : 0;
       // destVec += *a * srcVec (according to the sub-vector parts)
-      internal::template axpy<
-          typename SparseBlockMatrix<MatrixType>::SparseMatrixBlock>(
-          *a, srcVec, srcOffset, destVec, destOffset);
-    }
+      internal::template axpy<SparseMatrixBlock>(*a, srcVec, srcOffset, destVec,
+                                                 destOffset);
+    });
   }
 }
 
@@ -280,21 +424,17 @@ void SparseBlockMatrix<MatrixType>::multiplySymmetricUpperTriangle(
 
   for (size_t i = 0; i < blockCols_.size(); ++i) {
     int srcOffset = colBaseOfBlock(i);
-    for (auto it = blockCols_[i].begin(); it != blockCols_[i].end(); ++it) {
-      const typename SparseBlockMatrix<MatrixType>::SparseMatrixBlock* a =
-          it->second;
-      int destOffset = rowBaseOfBlock(it->first);
+    forEachBlockInColumn(i, [&](int r, const SparseMatrixBlock* a) {
+      int destOffset = rowBaseOfBlock(r);
       if (destOffset > srcOffset)  // only upper triangle
-        break;
+        return;
       // destVec += *a * srcVec (according to the sub-vector parts)
-      internal::template axpy<
-          typename SparseBlockMatrix<MatrixType>::SparseMatrixBlock>(
-          *a, srcVec, srcOffset, destVec, destOffset);
+      internal::template axpy<SparseMatrixBlock>(*a, srcVec, srcOffset, destVec,
+                                                 destOffset);
       if (destOffset < srcOffset)
-        internal::template atxpy<
-            typename SparseBlockMatrix<MatrixType>::SparseMatrixBlock>(
-            *a, srcVec, destOffset, destVec, srcOffset);
-    }
+        internal::template atxpy<SparseMatrixBlock>(*a, srcVec, destOffset,
+                                                    destVec, srcOffset);
+    });
   }
 }
 
@@ -317,22 +457,21 @@ void SparseBlockMatrix<MatrixType>::rightMultiply(number_t*& dest,
 #endif
   for (int i = 0; i < static_cast<int>(blockCols_.size()); ++i) {
     int destOffset = colBaseOfBlock(i);
-    for (typename SparseBlockMatrix<MatrixType>::IntBlockMap::const_iterator
-             it = blockCols_[i].begin();
-         it != blockCols_[i].end(); ++it) {
-      const typename SparseBlockMatrix<MatrixType>::SparseMatrixBlock* a =
-          it->second;
-      int srcOffset = rowBaseOfBlock(it->first);
+    forEachBlockInColumn(i, [&](int r, const SparseMatrixBlock* a) {
+      int srcOffset = rowBaseOfBlock(r);
       // destVec += *a.transpose() * srcVec (according to the sub-vector parts)
-      internal::template atxpy<
-          typename SparseBlockMatrix<MatrixType>::SparseMatrixBlock>(
-          *a, srcVec, srcOffset, destVec, destOffset);
-    }
+      internal::template atxpy<SparseMatrixBlock>(*a, srcVec, srcOffset,
+                                                  destVec, destOffset);
+    });
   }
 }
 
 template <class MatrixType>
 void SparseBlockMatrix<MatrixType>::scale(number_t a_) {
+  if (frozen_) {
+    for (auto* a : frozenBlocks_) *a *= a_;
+    return;
+  }
   for (size_t i = 0; i < blockCols_.size(); ++i) {
     for (typename SparseBlockMatrix<MatrixType>::IntBlockMap::const_iterator
              it = blockCols_[i].begin();
@@ -360,6 +499,7 @@ SparseBlockMatrix<MatrixType>* SparseBlockMatrix<MatrixType>::slice(
     colIdx[i] = colIdx[i - 1] + colsOfBlock(cmin + i);
   }
   auto* s = new SparseBlockMatrix(rowIdx, colIdx, m, n, true);
+  if (alloc && arena_) s->setArenaStorage(true);
   for (int i = 0; i < n; ++i) {
     int mc = cmin + i;
     for (typename SparseBlockMatrix<MatrixType>::IntBlockMap::const_iterator
@@ -367,10 +507,7 @@ SparseBlockMatrix<MatrixType>* SparseBlockMatrix<MatrixType>::slice(
          it != blockCols_[mc].end(); ++it) {
       if (it->first >= rmin && it->first < rmax) {
         typename SparseBlockMatrix<MatrixType>::SparseMatrixBlock* b =
-            alloc ? new
-                typename SparseBlockMatrix<MatrixType>::SparseMatrixBlock(
-                    *(it->second))
-                  : it->second;
+            alloc ? s->allocateBlock(*(it->second)) : it->second;
         s->blockCols_[i].insert(std::make_pair(it->first - rmin, b));
       }
     }
@@ -381,6 +518,7 @@ SparseBlockMatrix<MatrixType>* SparseBlockMatrix<MatrixType>::slice(
 
 template <class MatrixType>
 size_t SparseBlockMatrix<MatrixType>::nonZeroBlocks() const {
+  if (frozen_) return frozenBlocks_.size();
   size_t count = 0;
   for (size_t i = 0; i < blockCols_.size(); ++i) count += blockCols_[i].size();
   return count;
@@ -497,16 +635,14 @@ int SparseBlockMatrix<MatrixType>::fillCCS(number_t* Cx,
     int cstart = i ? colBlockIndices_[i - 1] : 0;
     int csize = colsOfBlock(i);
     for (int c = 0; c < csize; ++c) {
-      for (auto it = blockCols_[i].begin(); it != blockCols_[i].end(); ++it) {
-        const typename SparseBlockMatrix<MatrixType>::SparseMatrixBlock* b =
-            it->second;
-        int rstart = it->first ? rowBlockIndices_[it->first - 1] : 0;
+      forEachBlockInColumn(i, [&](int r, const SparseMatrixBlock* b) {
+        int rstart = r ? rowBlockIndices_[r - 1] : 0;
 
         int elemsToCopy = b->rows();
         if (upperTriangle && rstart == cstart) elemsToCopy = c + 1;
         memcpy(Cx, b->data() + c * b->rows(), elemsToCopy * sizeof(number_t));
         Cx += elemsToCopy;
-      }
+      });
     }
   }
   return Cx - CxStart;
@@ -522,10 +658,8 @@ int SparseBlockMatrix<MatrixType>::fillCCS(int* Cp, int* Ci, number_t* Cx,
     int csize = colsOfBlock(i);
     for (int c = 0; c < csize; ++c) {
       *Cp = nz;
-      for (auto it = blockCols_[i].begin(); it != blockCols_[i].end(); ++it) {
-        const typename SparseBlockMatrix<MatrixType>::SparseMatrixBlock* b =
-            it->second;
-        int rstart = it->first ? rowBlockIndices_[it->first - 1] : 0;
+      forEachBlockInColumn(i, [&](int br, const SparseMatrixBlock* b) {
+        int rstart = br ? rowBlockIndices_[br - 1] : 0;
 
         int elemsToCopy = b->rows();
         if (upperTriangle && rstart == cstart) elemsToCopy = c + 1;
@@ -534,7 +668,7 @@ int SparseBlockMatrix<MatrixType>::fillCCS(int* Cp, int* Ci, number_t* Cx,
           *Ci++ = rstart++;
           ++nz;
         }
-      }
+      });
       ++Cp;
     }
   }
@@ -555,13 +689,12 @@ void SparseBlockMatrix<MatrixType>::fillBlockStructure(int* Cp, int* Ci) const {
   int nz = 0;
   for (int c = 0; c < static_cast<int>(blockCols_.size()); ++c) {
     *Cp = nz;
-    for (auto it = blockCols_[c].begin(); it != blockCols_[c].end(); ++it) {
-      const int& r = it->first;
+    forEachBlockInColumn(c, [&](int r, const SparseMatrixBlock*) {
       if (r <= c) {
         *Ci++ = r;
         ++nz;
       }
-    }
+    });
     Cp++;
   }
   *Cp = nz;
@@ -616,16 +749,14 @@ int SparseBlockMatrix<MatrixType>::fillSparseBlockMatrixCCS(
   blockCCS.blockCols().resize(blockCols().size());
   int numblocks = 0;
   for (size_t i = 0; i < blockCols().size(); ++i) {
-    const IntBlockMap& row = blockCols()[i];
     typename SparseBlockMatrixCCS<MatrixType>::SparseColumn& dest =
         blockCCS.blockCols()[i];
     dest.clear();
-    dest.reserve(row.size());
-    for (auto it = row.begin(); it != row.end(); ++it) {
-      dest.push_back(typename SparseBlockMatrixCCS<MatrixType>::RowBlock(
-          it->first, it->second));
+    dest.reserve(blockCols()[i].size());
+    forEachBlockInColumn(i, [&](int r, SparseMatrixBlock* b) {
+      dest.push_back(typename SparseBlockMatrixCCS<MatrixType>::RowBlock(r, b));
       ++numblocks;
-    }
+    });
   }
   return numblocks;
 }
@@ -637,14 +768,12 @@ int SparseBlockMatrix<MatrixType>::fillSparseBlockMatrixCCSTransposed(
   blockCCS.blockCols().resize(rowBlockIndices_.size());
   int numblocks = 0;
   for (size_t i = 0; i < blockCols().size(); ++i) {
-    const IntBlockMap& row = blockCols()[i];
-    for (auto it = row.begin(); it != row.end(); ++it) {
+    forEachBlockInColumn(i, [&](int r, SparseMatrixBlock* b) {
       typename SparseBlockMatrixCCS<MatrixType>::SparseColumn& dest =
-          blockCCS.blockCols()[it->first];
-      dest.push_back(
-          typename SparseBlockMatrixCCS<MatrixType>::RowBlock(i, it->second));
+          blockCCS.blockCols()[r];
+      dest.push_back(typename SparseBlockMatrixCCS<MatrixType>::RowBlock(i, b));
       ++numblocks;
-    }
+    });
   }
   return numblocks;
 }
@@ -657,6 +786,12 @@ void SparseBlockMatrix<MatrixType>::takePatternFromHash(
   using SparseColumnPair = std::pair<int, MatrixType*>;
   using HashSparseColumn =
       typename SparseBlockMatrixHashMap<MatrixType>::SparseColumn;
+  unfreezeStructure();
+  if (arena_) {
+    size_t numBlocks = 0;
+    for (const auto& column : hashMatrix.blockCols()) numBlocks += column.size();
+    arena_->reserve(numBlocks);
+  }
   for (size_t i = 0; i < hashMatrix.blockCols().size(); ++i) {
     // prepare a temporary vector for sorting
     HashSparseColumn& column = hashMatrix.blockCols()[i];
@@ -671,6 +806,14 @@ void SparseBlockMatrix<MatrixType>::takePatternFromHash(
     // try to free some memory early
     HashSparseColumn aux;
     std::swap(aux, column);
+    // with an arena, move the blocks into the arena laid out column by column
+    if (arena_) {
+      for (auto& sparseRow : sparseRowSorted) {
+        MatrixType* b = arena_->allocate(*sparseRow.second);
+        delete sparseRow.second;
+        sparseRow.second = b;
+      }
+    }
     // now insert sorted vector to the std::map structure
     IntBlockMap& destColumnMap = blockCols()[i];
     destColumnMap.insert(sparseRowSorted[0]);
@@ -26,13 +26,19 @@
 
 #include "sparse_optimizer.h"
 
+#include <Eigen/Eigenvalues>
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "batch_stats.h"
+#include "edge_marginal_prior.h"
 #include "estimate_propagator.h"
 #include "g2o/config.h"
 #include "g2o/core/eigen_types.h"
@@ -46,6 +52,32 @@
 
 namespace g2o {
 
+namespace {
+//! number of vertices processed at once by initializeOptimization()
+constexpr int kInitializationGrain = 256;
+
+/**
+ * eigen decomposition of a symmetric positive semi-definite matrix, keeping
+ * only the eigenpairs with a numerically non-zero eigenvalue
+ */
+void positiveEigenDecomposition(const MatrixX& A, VectorX& values,
+                                MatrixX& vectors) {
+  if (A.rows() == 0) {
+    values.resize(0);
+    vectors.resize(0, 0);
+    return;
+  }
+  Eigen::SelfAdjointEigenSolver<MatrixX> eigen(A);
+  const VectorX& lambda = eigen.eigenvalues();  // in increasing order
+  const number_t threshold = std::numeric_limits<number_t>::epsilon() *
+                             A.rows() * lambda.cwiseAbs().maxCoeff();
+  Eigen::Index first = 0;
+  while (first < lambda.size() && lambda(first) <= threshold) ++first;
+  values = lambda.tail(lambda.size() - first);
+  vectors = eigen.eigenvectors().rightCols(lambda.size() - first);
+}
+}  // namespace
+
 SparseOptimizer::SparseOptimizer() : algorithm_(nullptr) {
   graphActions_.resize(kAtNumElements);
 }
@@ -61,13 +93,12 @@ void SparseOptimizer::computeActiveErrors() {
     for (const auto& action : actions) (*action)(*this);
   }
 
-#ifdef G2O_OPENMP
-#pragma omp parallel for default(shared) if (activeEdges_.size() > 50)
-#endif
-  for (auto& _activeEdge : activeEdges_) {
-    OptimizableGraph::Edge* e = _activeEdge.get();
-    e->computeError();
-  }
+  parallelFor(executor(), computeErrorGrain_,
+              static_cast<int>(activeEdges_.size()),
+              [this](int begin, int end, int) {
+                for (int k = begin; k < end; ++k)
+                  activeEdges_[k]->computeError();
+              });
 
 #ifndef NDEBUG
   for (auto & activeEdge : activeEdges_) {
@@ -81,6 +112,14 @@ void SparseOptimizer::computeActiveErrors() {
 #endif
 }
 
+void SparseOptimizer::setNumThreads(int numThreads) {
+  if (numThreads <= 0) {
+    executor_.reset();
+    return;
+  }
+  executor_ = std::make_shared<WorkStealingExecutor>(numThreads);
+}
+
 number_t SparseOptimizer::activeChi2() const {
   number_t chi = 0.0;
   for (const auto& _activeEdge : activeEdges_) {
@@ -133,8 +172,8 @@ bool SparseOptimizer::gaugeFreedom() {
         return false;
       }
       // test for full dimension prior
-      for (const auto& eit : v->edges()) {
-        auto e = std::static_pointer_cast<OptimizableGraph::Edge>(eit.lock());
+      for (HyperGraph::Edge* eit : v->adjacentEdges()) {
+        auto* e = static_cast<OptimizableGraph::Edge*>(eit);
         if (e->vertices().size() == 1 && e->dimension() == maxDim) return false;
       }
     }
@@ -173,21 +212,32 @@ void SparseOptimizer::clearIndexMapping() {
     i->setHessianIndex(-1);
     i = nullptr;
   }
+  estimateStackOutdated_ = true;
 }
 
 bool SparseOptimizer::initializeOptimization(int level) {
-  HyperGraph::VertexSet vset;
-  for (auto& it : vertices()) vset.insert(it.second);
-  return initializeOptimization(vset, level);
+  VertexCandidates candidates;
+  candidates.reserve(vertices().size());
+  for (const auto& it : vertices()) candidates.push_back(&it.second);
+  return initializeActive(candidates, level);
 }
 
 bool SparseOptimizer::initializeOptimization(HyperGraph::VertexSet& vset,
                                              int level) {
+  VertexCandidates candidates;
+  candidates.reserve(vset.size());
+  for (const auto& v : vset) candidates.push_back(&v);
+  return initializeActive(candidates, level);
+}
+
+bool SparseOptimizer::initializeActive(const VertexCandidates& candidates,
+                                       int level) {
   if (edges().empty()) {
     std::cerr << __PRETTY_FUNCTION__ << ": Attempt to initialize an empty graph"
               << std::endl;
     return false;
   }
+  const number_t ts = get_monotonic_time();
   preIteration(-1);
   bool workspaceAllocated = jacobianWorkspace_.allocate();
   (void)workspaceAllocated;
@@ -195,61 +245,82 @@ bool SparseOptimizer::initializeOptimization(HyperGraph::VertexSet& vset,
          "Error while allocating memory for the Jacobians");
   clearIndexMapping();
   activeVertices_.clear();
-  activeVertices_.reserve(vset.size());
   activeEdges_.clear();
-  EdgeSet auxEdgeSet;  // temporary structure to avoid duplicates
-  for (auto it = vset.begin(); it != vset.end(); ++it) {
-    auto* v = static_cast<OptimizableGraph::Vertex*>(it->get());
-    const OptimizableGraph::EdgeSetWeak& vEdges = v->edges();
-    // count if there are edges in that level. If not remove from the pool
-    int levelEdges = 0;
-    for (const auto& vEdge : vEdges) {
-      auto e = std::static_pointer_cast<OptimizableGraph::Edge>(vEdge.lock());
-      if (level < 0 || e->level() == level) {
-        bool allVerticesOK = true;
-        for (const auto& vit : e->vertices()) {
-          if (vset.find(vit) == vset.end()) {
-            allVerticesOK = false;
-            break;
+
+  // mark the candidates to test the vertices of an edge without a look-up
+  auto vertexOf = [](const std::shared_ptr<HyperGraph::Vertex>* v) {
+    return static_cast<OptimizableGraph::Vertex*>(v->get());
+  };
+  for (const auto* v : candidates) vertexOf(v)->initializationMark_ = true;
+  auto isActive = [level](const OptimizableGraph::Edge* e) {
+    if (level >= 0 && e->level() != level) return false;
+    for (const auto& v : e->vertices()) {
+      if (!v || !static_cast<OptimizableGraph::Vertex*>(v.get())
+                     ->initializationMark_)
+        return false;
+    }
+    return !e->allVerticesFixed();
+  };
+
+  // A candidate is active if one of its edges is active. Each active edge
+  // is collected by its first vertex, which is a candidate as well.
+  ParallelExecutor& exec = executor();
+  const int numCandidates = static_cast<int>(candidates.size());
+  std::vector<uint8_t> vertexActive(numCandidates, 0);
+  std::vector<std::vector<HyperGraph::Edge*>> threadEdges(
+      std::max(exec.numThreads(), 1));
+  exec.parallelFor(
+      numCandidates, kInitializationGrain,
+      [&](int begin, int end, int thread) {
+        std::vector<HyperGraph::Edge*>& edges = threadEdges[thread];
+        for (int i = begin; i < end; ++i) {
+          const OptimizableGraph::Vertex* v = vertexOf(candidates[i]);
+          for (HyperGraph::Edge* e : v->adjacentEdges()) {
+            if (!isActive(static_cast<OptimizableGraph::Edge*>(e))) continue;
+            vertexActive[i] = 1;
+            if (e->vertices()[0].get() == v) edges.push_back(e);
           }
         }
-        if (allVerticesOK && !e->allVerticesFixed()) {
-          auxEdgeSet.insert(e);
-          levelEdges++;
-        }
-      }
-    }
-    if (levelEdges) {
-      activeVertices_.push_back(std::static_pointer_cast<Vertex>(*it));
+      });
+  for (const auto* v : candidates) vertexOf(v)->initializationMark_ = false;
 
-      // test for NANs in the current estimate if we are debugging
+  for (int i = 0; i < numCandidates; ++i) {
+    if (!vertexActive[i]) continue;
+    activeVertices_.push_back(std::static_pointer_cast<Vertex>(*candidates[i]));
+    // test for NANs in the current estimate if we are debugging
 #ifndef NDEBUG
-      int estimateDim = v->estimateDimension();
-      if (estimateDim > 0) {
-        VectorX estimateData(estimateDim);
-        if (v->getEstimateData(estimateData.data())) {
-          int k;
-          bool hasNan = arrayHasNaN(estimateData.data(), estimateDim, &k);
-          if (hasNan)
-            std::cerr << __PRETTY_FUNCTION__ << ": Vertex " << v->id()
-                      << " contains a nan entry at index " << k << std::endl;
-        }
+    OptimizableGraph::Vertex* v = activeVertices_.back().get();
+    int estimateDim = v->estimateDimension();
+    if (estimateDim > 0) {
+      VectorX estimateData(estimateDim);
+      if (v->getEstimateData(estimateData.data())) {
+        int k;
+        bool hasNan = arrayHasNaN(estimateData.data(), estimateDim, &k);
+        if (hasNan)
+          std::cerr << __PRETTY_FUNCTION__ << ": Vertex " << v->id()
+                    << " contains a nan entry at index " << k << std::endl;
       }
-#endif
     }
+#endif
+  }
+  size_t numEdges = 0;
+  for (const auto& edges : threadEdges) numEdges += edges.size();
+  activeEdges_.reserve(numEdges);
+  for (const auto& edges : threadEdges) {
+    for (HyperGraph::Edge* e : edges)
+      activeEdges_.push_back(std::static_pointer_cast<Edge>(e->sharedThis()));
   }
 
-  activeEdges_.reserve(auxEdgeSet.size());
-  for (const auto& it : auxEdgeSet)
-    activeEdges_.push_back(std::static_pointer_cast<Edge>(it));
-
+  // the order of the threads does not matter after sorting by the ids
   sortVectorContainers();
   bool indexMappingStatus = buildIndexMapping(activeVertices_);
   postIteration(-1);
+  timeInitialization_ += get_monotonic_time() - ts;
   return indexMappingStatus;
 }
 
 bool SparseOptimizer::initializeOptimization(HyperGraph::EdgeSet& eset) {
+  const number_t ts = get_monotonic_time();
   preIteration(-1);
   bool workspaceAllocated = jacobianWorkspace_.allocate();
   (void)workspaceAllocated;
@@ -259,23 +330,24 @@ bool SparseOptimizer::initializeOptimization(HyperGraph::EdgeSet& eset) {
   activeVertices_.clear();
   activeEdges_.clear();
   activeEdges_.reserve(eset.size());
-  VertexSet auxVertexSet;  // temporary structure to avoid duplicates
   for (const auto& it : eset) {
     auto* e = static_cast<OptimizableGraph::Edge*>(it.get());
     if (e->numUndefinedVertices()) continue;
-    for (auto& vit : e->vertices()) {
-      auxVertexSet.insert(vit);
+    for (const auto& vit : e->vertices()) {
+      // the mark avoids adding a vertex twice
+      auto* v = static_cast<OptimizableGraph::Vertex*>(vit.get());
+      if (v->initializationMark_) continue;
+      v->initializationMark_ = true;
+      activeVertices_.push_back(std::static_pointer_cast<Vertex>(vit));
     }
     activeEdges_.push_back(std::static_pointer_cast<Edge>(it));
   }
-
-  activeVertices_.reserve(auxVertexSet.size());
-  for (const auto& it : auxVertexSet)
-    activeVertices_.push_back(std::static_pointer_cast<Vertex>(it));
+  for (const auto& v : activeVertices_) v->initializationMark_ = false;
 
   sortVectorContainers();
   bool indexMappingStatus = buildIndexMapping(activeVertices_);
   postIteration(-1);
+  timeInitialization_ += get_monotonic_time() - ts;
   return indexMappingStatus;
 }
 
@@ -304,10 +376,8 @@ void SparseOptimizer::computeInitialGuess(EstimatePropagatorCost& propagator) {
         fixedVertices.insert(v);
       else {  // check for having a prior which is able to fully initialize a
               // vertex
-        for (auto vedgeIt = v->edges().begin(); vedgeIt != v->edges().end();
-             ++vedgeIt) {
-          auto vedge =
-              std::static_pointer_cast<OptimizableGraph::Edge>(vedgeIt->lock());
+        for (HyperGraph::Edge* vedgeIt : v->adjacentEdges()) {
+          auto* vedge = static_cast<OptimizableGraph::Edge*>(vedgeIt);
           if (vedge->vertices().size() == 1 &&
               vedge->initialEstimatePossible(emptySet, v.get()) > 0.) {
             // cerr << "Initialize with prior for " << v->id() << endl;
@@ -375,6 +445,8 @@ int SparseOptimizer::optimize(int iterations, bool online) {
       cstat.iteration = i;
       cstat.numEdges = activeEdges_.size();
       cstat.numVertices = activeVertices_.size();
+      cstat.timeInitialization = timeInitialization_;
+      timeInitialization_ = 0;
     }
 
     number_t ts = get_monotonic_time();
@@ -437,6 +509,7 @@ bool SparseOptimizer::updateInitialization(HyperGraph::VertexSet& vset,
                                            HyperGraph::EdgeSet& eset) {
   HyperGraph::VertexContainer newVertices;
   newVertices.reserve(vset.size());
+  estimateStackOutdated_ = true;
   activeVertices_.reserve(activeVertices_.size() + vset.size());
   activeEdges_.reserve(activeEdges_.size() + eset.size());
   for (const auto& it : eset) {
@@ -475,6 +548,8 @@ void SparseOptimizer::sortVectorContainers() {
 }
 
 void SparseOptimizer::clear() {
+  estimateStack_.clear();
+  estimateStackOutdated_ = true;
   ivMap_.clear();
   activeVertices_.clear();
   activeEdges_.clear();
@@ -537,6 +612,162 @@ bool SparseOptimizer::computeMarginals(
   return algorithm_->computeMarginals(spinv, blockIndices);
 }
 
+bool SparseOptimizer::marginalizeVertices(const VertexContainer& vertices) {
+  // the non-fixed vertices to eliminate followed by their Markov blanket
+  std::unordered_set<const HyperGraph::Vertex*> removed;
+  std::vector<OptimizableGraph::Vertex*> local;
+  std::unordered_map<const HyperGraph::Vertex*, int> localIndex;
+  for (const auto& v : vertices) {
+    if (!v || vertex(v->id()) != v) {
+      std::cerr << __PRETTY_FUNCTION__ << ": vertex is not part of the graph"
+                << std::endl;
+      return false;
+    }
+    if (!removed.insert(v.get()).second || v->fixed()) continue;
+    localIndex[v.get()] = static_cast<int>(local.size());
+    local.push_back(v.get());
+  }
+  const int numMarginalized = static_cast<int>(local.size());
+
+  // the edges adjacent to the vertices, ordered by their id for a
+  // deterministic sum
+  std::vector<OptimizableGraph::Edge*> edges;
+  for (const auto& v : vertices) {
+    for (HyperGraph::Edge* e : v->adjacentEdges()) {
+      auto* edge = static_cast<OptimizableGraph::Edge*>(e);
+      if (edge->numUndefinedVertices() == 0) edges.push_back(edge);
+    }
+  }
+  std::sort(edges.begin(), edges.end(),
+            [](const OptimizableGraph::Edge* e1,
+               const OptimizableGraph::Edge* e2) {
+              return e1->internalId() < e2->internalId();
+            });
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+  std::vector<std::shared_ptr<HyperGraph::Vertex>> blanket;
+  for (auto* e : edges) {
+    for (const auto& v : e->vertices()) {
+      if (removed.count(v.get()) ||
+          static_cast<OptimizableGraph::Vertex*>(v.get())->fixed())
+        continue;
+      blanket.push_back(v);
+    }
+  }
+  std::sort(blanket.begin(), blanket.end(),
+            [](const std::shared_ptr<HyperGraph::Vertex>& v1,
+               const std::shared_ptr<HyperGraph::Vertex>& v2) {
+              return v1->id() < v2->id();
+            });
+  blanket.erase(std::unique(blanket.begin(), blanket.end()), blanket.end());
+  for (const auto& v : blanket) {
+    localIndex[v.get()] = static_cast<int>(local.size());
+    local.push_back(static_cast<OptimizableGraph::Vertex*>(v.get()));
+  }
+
+  auto prior = std::make_shared<EdgeMarginalPrior>();
+  prior->resize(blanket.size());
+  for (size_t i = 0; i < blanket.size(); ++i) prior->setVertex(i, blanket[i]);
+  if (!prior->setLinearizationPoint()) {
+    std::cerr << __PRETTY_FUNCTION__
+              << ": the blanket vertices do not provide their estimate as data"
+              << std::endl;
+    return false;
+  }
+
+  if (!blanket.empty()) {
+    // map the Hessian of the vertices and edges to a local matrix, the
+    // mapping of the blanket and its gradient are restored afterwards
+    std::vector<int> blockIndices(local.size());
+    int dimension = 0;
+    for (size_t i = 0; i < local.size(); ++i) {
+      dimension += local[i]->dimension();
+      blockIndices[i] = dimension;
+    }
+    const int dimMarginalized =
+        numMarginalized > 0 ? blockIndices[numMarginalized - 1] : 0;
+    SparseBlockMatrix<MatrixX> hessian(blockIndices.data(),
+                                       blockIndices.data(),
+                                       static_cast<int>(local.size()),
+                                       static_cast<int>(local.size()));
+    std::vector<number_t*> hessianData(local.size());
+    std::vector<VectorX> gradient(local.size());
+    for (size_t i = 0; i < local.size(); ++i) {
+      hessianData[i] = local[i]->hessianData();
+      gradient[i] = local[i]->bMap();
+      local[i]->mapHessianMemory(hessian.block(i, i, true)->data());
+      local[i]->clearQuadraticForm();
+    }
+    for (auto* e : edges) {
+      for (size_t viIdx = 0; viIdx < e->vertices().size(); ++viIdx) {
+        auto it1 = localIndex.find(e->vertices()[viIdx].get());
+        if (it1 == localIndex.end()) continue;
+        for (size_t vjIdx = viIdx + 1; vjIdx < e->vertices().size(); ++vjIdx) {
+          auto it2 = localIndex.find(e->vertices()[vjIdx].get());
+          if (it2 == localIndex.end()) continue;
+          int ind1 = it1->second;
+          int ind2 = it2->second;
+          bool transposedBlock = ind1 > ind2;
+          if (transposedBlock) std::swap(ind1, ind2);
+          e->mapHessianMemory(hessian.block(ind1, ind2, true)->data(), viIdx,
+                              vjIdx, transposedBlock);
+        }
+      }
+    }
+
+    for (auto* e : edges) jacobianWorkspace_.updateSize(e);
+    jacobianWorkspace_.allocate();
+    for (auto* e : edges) {
+      e->computeError();
+      e->linearizeOplus(jacobianWorkspace_);
+      e->constructQuadraticForm();
+    }
+
+    VectorX b(dimension);
+    for (size_t i = 0; i < local.size(); ++i) {
+      local[i]->copyB(b.data() + hessian.rowBaseOfBlock(i));
+      local[i]->mapHessianMemory(hessianData[i]);
+      local[i]->bMap() = gradient[i];
+    }
+    MatrixX H = MatrixX::Zero(dimension, dimension);
+    for (size_t c = 0; c < hessian.blockCols().size(); ++c) {
+      for (const auto& it : hessian.blockCols()[c]) {
+        const MatrixX& block = *it.second;
+        H.block(hessian.rowBaseOfBlock(it.first), hessian.colBaseOfBlock(c),
+                block.rows(), block.cols()) = block;
+      }
+    }
+    H = H.selfadjointView<Eigen::Upper>();
+
+    // Schur complement S = Hbb - Hbm * Hmm^+ * Hmb and its gradient
+    const int dimBlanket = dimension - dimMarginalized;
+    VectorX lambda;
+    MatrixX U;
+    positiveEigenDecomposition(
+        H.topLeftCorner(dimMarginalized, dimMarginalized), lambda, U);
+    const VectorX invSqrtLambda = lambda.cwiseSqrt().cwiseInverse();
+    const MatrixX W =
+        H.bottomLeftCorner(dimBlanket, dimMarginalized) * U *
+        invSqrtLambda.asDiagonal();
+    const MatrixX S =
+        H.bottomRightCorner(dimBlanket, dimBlanket) - W * W.transpose();
+    const VectorX bS =
+        b.tail(dimBlanket) - W * (invSqrtLambda.asDiagonal() *
+                                  (U.transpose() * b.head(dimMarginalized)));
+
+    // factor S = J^T * J and J^T * e0 = -bS for the prior
+    positiveEigenDecomposition(S, lambda, U);
+    const MatrixX jacobian = lambda.cwiseSqrt().asDiagonal() * U.transpose();
+    const VectorX error0 = -(lambda.cwiseSqrt().cwiseInverse().asDiagonal() *
+                             (U.transpose() * bS));
+    prior->setLinearization(error0, jacobian);
+  }
+
+  for (const auto& v : vertices) removeVertex(v);
+  if (prior->dimension() > 0) addEdge(prior);
+  return true;
+}
+
 void SparseOptimizer::setForceStopFlag(bool* flag) { forceStopFlag_ = flag; }
 
 bool SparseOptimizer::removeVertex(const std::shared_ptr<HyperGraph::Vertex>& v,
@@ -561,10 +792,17 @@ bool SparseOptimizer::removeComputeErrorAction(
   return graphActions_[kAtComputeactiverror].erase(action) > 0;
 }
 
-void SparseOptimizer::push() { push(activeVertices_); }
+void SparseOptimizer::push() {
+  // the vertices are only exchanged if no snapshot refers to the old ones
+  if (estimateStackOutdated_ && estimateStack_.size() == 0) {
+    estimateStack_.setVertices(activeVertices_);
+    estimateStackOutdated_ = false;
+  }
+  estimateStack_.push();
+}
 
-void SparseOptimizer::pop() { pop(activeVertices_); }
+void SparseOptimizer::pop() { estimateStack_.pop(); }
 
-void SparseOptimizer::discardTop() { discardTop(activeVertices_); }
+void SparseOptimizer::discardTop() { estimateStack_.discardTop(); }
 
 }  // namespace g2o
@@ -30,9 +30,11 @@
 #include <memory>
 
 #include "batch_stats.h"
+#include "estimate_stack.h"
 #include "g2o/stuff/macros.h"
 #include "g2o_core_api.h"
 #include "optimizable_graph.h"
+#include "parallel_executor.h"
 #include "sparse_block_matrix.h"
 
 namespace g2o {
@@ -166,6 +168,21 @@ class G2O_CORE_API SparseOptimizer : public OptimizableGraph {
     return computeMarginals(spinv, indices);
   }
 
+  /**
+   * Marginalizes the given vertices out of the graph, e.g., to keep the
+   * window of a fixed-lag smoother at a constant size. The edges adjacent to
+   * the vertices are linearized at the current estimate and the vertices are
+   * eliminated by the Schur complement onto their Markov blanket, i.e., the
+   * non-fixed vertices sharing an edge with them. The vertices and their
+   * edges are removed and replaced by an EdgeMarginalPrior on the blanket,
+   * whose Jacobian stays at the current estimate. Afterwards,
+   * initializeOptimization() has to be called before optimizing again.
+   * @param vertices: the vertices to marginalize
+   * @returns false if a vertex is not part of the graph or the prior cannot
+   * be represented, the graph is not modified in this case
+   */
+  bool marginalizeVertices(const VertexContainer& vertices);
+
   //! finds a gauge in the graph to remove the undefined dof.
   // The gauge should be fixed() and then the optimization can work (if no
   // additional dof are in the system. The default implementation returns a node
@@ -237,7 +254,11 @@ class G2O_CORE_API SparseOptimizer : public OptimizableGraph {
   virtual void push(SparseOptimizer::VertexContainer& vlist);
   //! push the estimate of a subset of the variables onto a stack
   void push(HyperGraph::VertexSet& vlist) override;
-  //! push all the active vertices onto a stack
+  /**
+   * push all the active vertices onto a stack. The estimates are saved by
+   * one snapshot of the EstimateStack, the stacks of the vertices are only
+   * used by vertices not supporting OptimizableGraph::Vertex::saveState().
+   */
   void push() override;
   //! pop (restore) the estimate a subset of the variables from the stack
   virtual void pop(SparseOptimizer::VertexContainer& vlist);
@@ -252,6 +273,8 @@ class G2O_CORE_API SparseOptimizer : public OptimizableGraph {
   //! same as above, but for the active vertices
   void discardTop() override;
   using OptimizableGraph::discardTop;
+  //! number of snapshots of the active vertices saved by push()
+  int estimateStackSize() const { return estimateStack_.size(); }
 
   /**
    * clears the graph, and polishes some intermediate structures
@@ -265,6 +288,26 @@ class G2O_CORE_API SparseOptimizer : public OptimizableGraph {
    */
   void computeActiveErrors();
 
+  /**
+   * the executor running the parallel loops of the optimization, i.e.,
+   * computing the errors and building and solving the linear system. If none
+   * is set, ParallelExecutor::defaultExecutor() is used.
+   */
+  ParallelExecutor& executor() const {
+    return executor_ ? *executor_ : ParallelExecutor::defaultExecutor();
+  }
+  void setExecutor(const std::shared_ptr<ParallelExecutor>& executor) {
+    executor_ = executor;
+  }
+  /**
+   * run the parallel loops on a WorkStealingExecutor owned by this optimizer
+   * with the given number of threads. Zero switches back to the default
+   * executor.
+   */
+  void setNumThreads(int numThreads);
+  //! number of threads used for the parallel loops
+  int numThreads() const { return executor().numThreads(); }
+
   /**
    * Linearizes the system by computing the Jacobians for the nodes
    * and edges in the graph
@@ -313,8 +356,27 @@ class G2O_CORE_API SparseOptimizer : public OptimizableGraph {
 
   void sortVectorContainers();
 
+  //! the vertices of initializeOptimization(), pointing into the graph or set
+  using VertexCandidates =
+      std::vector<const std::shared_ptr<HyperGraph::Vertex>*>;
+  /**
+   * determines the active vertices and edges among the candidates in one
+   * parallel pass over their edges.
+   */
+  bool initializeActive(const VertexCandidates& candidates, int level);
+  //! time spent in initializeOptimization() since the last iteration
+  number_t timeInitialization_ = 0;
+
+  //! snapshots of the active vertices taken by push()
+  EstimateStack estimateStack_;
+  //! the active vertices changed since estimateStack_ was set up
+  bool estimateStackOutdated_ = true;
+
   std::shared_ptr<OptimizationAlgorithm> algorithm_;
 
+  std::shared_ptr<ParallelExecutor> executor_;
+  AdaptiveGrain computeErrorGrain_;
+
   /**
    * builds the mapping of the active vertices to the (block) row / column in
    * the Hessian
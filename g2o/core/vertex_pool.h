@@ -0,0 +1,171 @@
+// g2o - General Graph Optimization
+// Copyright (C) 2011 R. Kuemmerle, G. Grisetti, W. Burgard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef G2O_VERTEX_POOL_H
+#define G2O_VERTEX_POOL_H
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace g2o {
+
+/**
+ * \brief Contiguous storage for many vertices of the same type
+ *
+ * Allocating each vertex separately scatters the vertices of a large graph
+ * over the heap. The pool instead constructs the vertices in chunks of
+ * contiguous memory and hands them out as regular shared pointers, which are
+ * added to the graph as usual, i.e., the Vertex API is not changed.
+ * Vertices created in the order of their ids are hence also contiguous in the
+ * order of the active vertices of the SparseOptimizer, which turns the loops
+ * of update(), push() and pop() into a linear walk through memory.
+ *
+ * Besides, the pool can save the estimates of all its vertices in one array
+ * by push() and restore them by pop(). This stack is independent of the
+ * stacks of the vertices used by OptimizableGraph::Vertex::push().
+ *
+ * The shared pointers of the vertices share the ownership of their chunk,
+ * hence a vertex is destroyed together with all vertices of its chunk once
+ * none of them is referenced any more. The pool itself may be destroyed
+ * before its vertices.
+ *
+ * VertexType has to be a BaseVertex, the pool is not thread-safe.
+ */
+template <typename VertexType>
+class VertexPool {
+ public:
+  using EstimateType = typename VertexType::EstimateType;
+  using EstimateVector =
+      std::vector<EstimateType, Eigen::aligned_allocator<EstimateType>>;
+
+  //! chunkSize is the number of vertices allocated at once
+  explicit VertexPool(int chunkSize = 1024) : chunkSize_(chunkSize) {
+    assert(chunkSize > 0 && "chunk size has to be positive");
+  }
+
+  /**
+   * construct a new vertex by VertexType(args...) behind the previously
+   * created ones.
+   */
+  template <typename... ArgTs>
+  std::shared_ptr<VertexType> create(ArgTs&&... args) {
+    if (chunks_.empty() || chunks_.back()->size == chunkSize_)
+      chunks_.emplace_back(std::make_shared<Chunk>(chunkSize_));
+    const std::shared_ptr<Chunk>& chunk = chunks_.back();
+    VertexType* v = new (chunk->data + chunk->size)
+        VertexType(std::forward<ArgTs>(args)...);
+    ++chunk->size;
+    ++size_;
+    return std::shared_ptr<VertexType>(chunk, v);
+  }
+
+  //! number of vertices created by the pool
+  int size() const { return size_; }
+
+  //! the i-th vertex created by the pool
+  VertexType& operator[](int i) {
+    return chunks_[i / chunkSize_]->data[i % chunkSize_];
+  }
+  const VertexType& operator[](int i) const {
+    return chunks_[i / chunkSize_]->data[i % chunkSize_];
+  }
+
+  //! call f(VertexType&) for all vertices in the order of their creation
+  template <typename Function>
+  void forEach(Function f) {
+    for (const auto& chunk : chunks_) {
+      std::for_each(chunk->data, chunk->data + chunk->size, f);
+    }
+  }
+
+  //! save the estimates of all vertices
+  void push() {
+    const size_t offset = backup_.size();
+    backup_.resize(offset + size_);
+    auto it = backup_.begin() + offset;
+    forEach([&it](VertexType& v) { *it++ = v.estimate(); });
+    backupSizes_.push_back(size_);
+  }
+
+  /**
+   * restore the estimates saved by the last push(). Vertices created after
+   * the push() keep their estimate.
+   */
+  void pop() {
+    assert(!backupSizes_.empty() && "pop() without push()");
+    int n = backupSizes_.back();
+    auto it = backup_.end() - n;
+    for (const auto& chunk : chunks_) {
+      const int m = std::min(chunk->size, n);
+      for (int i = 0; i < m; ++i) chunk->data[i].setEstimate(*it++);
+      n -= m;
+    }
+    discardTop();
+  }
+
+  //! drop the estimates saved by the last push()
+  void discardTop() {
+    assert(!backupSizes_.empty() && "discardTop() without push()");
+    backup_.resize(backup_.size() - backupSizes_.back());
+    backupSizes_.pop_back();
+  }
+
+  //! number of push() calls not yet reverted by pop() or discardTop()
+  int stackSize() const { return static_cast<int>(backupSizes_.size()); }
+
+ protected:
+  //! memory for chunkSize vertices of which the first size are constructed
+  struct Chunk {
+    explicit Chunk(int chunkSize)
+        : data(allocator.allocate(chunkSize)), capacity(chunkSize) {}
+    ~Chunk() {
+      for (int i = 0; i < size; ++i) data[i].~VertexType();
+      allocator.deallocate(data, capacity);
+    }
+    Chunk(const Chunk&) = delete;
+    Chunk& operator=(const Chunk&) = delete;
+
+    Eigen::aligned_allocator<VertexType> allocator;
+    VertexType* data;
+    int capacity;
+    int size = 0;
+  };
+
+  int chunkSize_;
+  int size_ = 0;
+  std::vector<std::shared_ptr<Chunk>> chunks_;
+  EstimateVector backup_;         ///< the saved estimates, stacked
+  std::vector<int> backupSizes_;  ///< number of estimates saved per push()
+};
+
+}  // namespace g2o
+
+#endif
@@ -208,6 +208,7 @@ int main(int argc, char** argv) {
   int maxIterations;
   bool verbose;
   bool usePCG;
+  bool implicitSchur;
   std::string outputFilename;
   std::string inputFilename;
   std::string statsFilename;
@@ -215,6 +216,8 @@ int main(int argc, char** argv) {
   arg.param("i", maxIterations, 5, "perform n iterations");
   arg.param("o", outputFilename, "", "write points into a vrml file");
   arg.param("pcg", usePCG, false, "use PCG instead of the Cholesky");
+  arg.param("implicitSchur", implicitSchur, false,
+            "with -pcg, do not form the reduced camera matrix");
   arg.param("v", verbose, false, "verbose output of the optimization process");
   arg.param("stats", statsFilename, "", "specify a file for the statistics");
   arg.paramLeftOver("graph-input", inputFilename, "",
@@ -247,8 +250,10 @@ int main(int argc, char** argv) {
     cholesky->setBlockOrdering(true);
     linearSolver = std::move(cholesky);
   }
+  auto blockSolver = g2o::make_unique<BalBlockSolver>(std::move(linearSolver));
+  blockSolver->setImplicitSchur(implicitSchur);
   auto solver = g2o::make_unique<g2o::OptimizationAlgorithmLevenberg>(
-      g2o::make_unique<BalBlockSolver>(std::move(linearSolver)));
+      std::move(blockSolver));
 
   // solver->setUserLambdaInit(1);
   optimizer.setAlgorithm(
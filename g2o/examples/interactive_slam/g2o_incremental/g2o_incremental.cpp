@@ -17,10 +17,12 @@
 #include <cassert>
 #include <csignal>
 #include <iostream>
+#include <memory>
 
 #include "g2o/examples/interactive_slam/g2o_interactive/g2o_slam_interface.h"
 #include "g2o/stuff/command_args.h"
 #include "g2o/stuff/macros.h"
+#include "g2o/stuff/misc.h"
 #include "g2o/stuff/string_tools.h"
 #include "g2o/stuff/tictoc.h"
 #include "graph_optimizer_sparse_incremental.h"
@@ -88,6 +90,8 @@ int main(int argc, char** argv) {
   std::string outputFilename;
   int updateEachN;
   int batchEachN;
+  bool fluid;
+  double relinearizeThreshold;
   bool verbose;
   bool vis;
   // command line parsing
@@ -96,6 +100,11 @@ int main(int argc, char** argv) {
             "solve by a batch Cholesky after inserting N nodes");
   arg.param("update", updateEachN, 10,
             "update the graph after inserting N nodes");
+  arg.param("fluid", fluid, false,
+            "solve by the supernodal solver relinearizing only the vertices "
+            "whose update exceeds a threshold instead of Cholesky updates");
+  arg.param("relinearize", relinearizeThreshold, 0.1,
+            "threshold on the update for relinearizing a vertex");
   arg.param("v", verbose, false, "verbose output of the optimization process");
   arg.param("g", vis, false, "gnuplot visualization");
   arg.param("o", outputFilename, "", "output the final graph");
@@ -104,7 +113,15 @@ int main(int argc, char** argv) {
 
   arg.parseArgs(argc, argv);
 
-  g2o::SparseOptimizerIncremental optimizer;
+  std::unique_ptr<g2o::SparseOptimizerOnline> optimizerPtr;
+  if (fluid) {
+    optimizerPtr = g2o::make_unique<g2o::SparseOptimizerOnline>();
+    optimizerPtr->fluidRelinearization = true;
+    optimizerPtr->relinearizeThreshold = relinearizeThreshold;
+  } else {
+    optimizerPtr = g2o::make_unique<g2o::SparseOptimizerIncremental>();
+  }
+  g2o::SparseOptimizerOnline& optimizer = *optimizerPtr;
   optimizer.setVerbose(verbose);
   optimizer.setForceStopFlag(&hasToStop);
   optimizer.vizWithGnuplot = vis;
@@ -51,6 +51,8 @@ void sigquit_handler(int sig) {
 
 int main(int argc, char** argv) {
   bool pcg;
+  bool fluid;
+  double relinearizeThreshold;
   int updateEachN;
   bool vis;
   bool verbose;
@@ -59,6 +61,10 @@ int main(int argc, char** argv) {
   arg.param("update", updateEachN, 10,
             "update the graph after inserting N nodes");
   arg.param("pcg", pcg, false, "use PCG instead of Cholesky");
+  arg.param("fluid", fluid, false,
+            "relinearize only the vertices whose update exceeds a threshold");
+  arg.param("relinearize", relinearizeThreshold, 0.1,
+            "threshold on the update for relinearizing a vertex");
   arg.param("v", verbose, false, "verbose output of the optimization process");
   arg.param("g", vis, false, "gnuplot visualization");
 
@@ -68,6 +74,8 @@ int main(int argc, char** argv) {
   optimizer.setVerbose(verbose);
   optimizer.setForceStopFlag(&hasToStop);
   optimizer.vizWithGnuplot = vis;
+  optimizer.fluidRelinearization = fluid;
+  optimizer.relinearizeThreshold = relinearizeThreshold;
 
   g2o::G2oSlamInterface slamInterface(&optimizer);
   slamInterface.setUpdateGraphEachN(updateEachN);
@@ -29,6 +29,7 @@
 #include <iostream>
 
 #include "fast_output.h"
+#include "g2o/stuff/tictoc.h"
 #include "g2o/types/slam3d/se3quat.h"
 #include "graph_optimizer_sparse_online.h"
 #include "types_slam2d_online.h"
@@ -450,7 +451,10 @@ G2oSlamInterface::SolveResult G2oSlamInterface::solve() {
       }
     }
 
+    // timing of each step, reported if G2O_ENABLE_TICTOC is set
+    tictoc("solve_step");
     int currentIt = optimizer_->optimize(incIterations_, !firstOptimization_);
+    tictoc("solve_step");
     (void)currentIt;
     firstOptimization_ = false;
     nodesAdded_ = 0;
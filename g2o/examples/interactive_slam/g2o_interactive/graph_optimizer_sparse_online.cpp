@@ -29,10 +29,12 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 
 #include "g2o/core/block_solver.h"
 #include "g2o/core/optimization_algorithm_factory.h"
 #include "g2o/core/optimization_algorithm_gauss_newton.h"
+#include "g2o/core/optimization_algorithm_incremental.h"
 #include "g2o/solvers/cholmod/linear_solver_cholmod.h"
 #include "g2o/solvers/pcg/linear_solver_pcg.h"
 #include "g2o/stuff/macros.h"
@@ -54,8 +56,9 @@ std::unique_ptr<g2o::Solver> AllocatePCGSolver() {
 }
 }  // namespace
 
-// force linking to the cholmod solver
+// force linking to the cholmod and the supernodal solver
 G2O_USE_OPTIMIZATION_LIBRARY(cholmod);
+G2O_USE_OPTIMIZATION_LIBRARY(supernodal);
 
 SparseOptimizerOnline::SparseOptimizerOnline(bool pcg) : usePcg_(pcg) {}
 
@@ -74,6 +77,8 @@ int SparseOptimizerOnline::optimize(int iterations, bool online) {
 
   (void)iterations;  // we only do one iteration anyhow
 
+  if (incremental_) return optimizeFluid(online);
+
   bool ok = true;
 
   algorithm_->init(online);
@@ -142,6 +147,24 @@ int SparseOptimizerOnline::optimize(int iterations, bool online) {
   return 1;
 }
 
+int SparseOptimizerOnline::optimizeFluid(bool online) {
+  // the estimate of the vertices is their updated estimate, the algorithm
+  // restores the linearization points by itself
+  const bool ok = SparseOptimizer::optimize(1, online && !batchStep) > 0;
+
+  if (verbose()) {
+    std::cerr << "nodes = " << vertices().size()
+              << "\t edges= " << activeEdges_.size()
+              << "\t relinearized= " << incremental_->relinearizedVertices()
+              << std::endl;
+  }
+
+  if (vizWithGnuplot) gnuplotVisualization();
+
+  if (!ok) return 0;
+  return 1;
+}
+
 void SparseOptimizerOnline::update(double* update) {
   if (slamDimension == 3) {
     for (auto& i : ivMap_) {
@@ -180,6 +203,22 @@ bool SparseOptimizerOnline::initSolver(int dimension, int /*batchEveryN*/) {
 
     auto* gaussNewton = new OptimizationAlgorithmGaussNewton(std::move(s));
     setAlgorithm(std::unique_ptr<OptimizationAlgorithm>(gaussNewton));
+  } else if (fluidRelinearization) {
+    setAlgorithm(solverFactory->construct(
+        dimension == 3 ? "inc_fix3_2_supernodal" : "inc_fix6_3_supernodal",
+        solverProperty));
+    incremental_ =
+        dynamic_cast<OptimizationAlgorithmIncremental*>(solver().get());
+    if (!incremental_) {
+      std::cerr << "Error allocating the incremental supernodal solver"
+                << std::endl;
+      return false;
+    }
+    // the interface decides on the batch steps
+    incremental_->setBatchEveryN(std::numeric_limits<int>::max());
+    incremental_->setRelinearizeThreshold(relinearizeThreshold);
+    underlyingSolver_ = &incremental_->solver();
+    return true;
   } else {
     if (dimension == 3) {
       setAlgorithm(
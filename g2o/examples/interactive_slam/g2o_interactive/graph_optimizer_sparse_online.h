@@ -32,6 +32,7 @@
 
 namespace g2o {
 
+class OptimizationAlgorithmIncremental;
 class Solver;
 
 class G2O_INTERACTIVE_API SparseOptimizerOnline : public SparseOptimizer {
@@ -55,12 +56,25 @@ class G2O_INTERACTIVE_API SparseOptimizerOnline : public SparseOptimizer {
   bool batchStep = true;
   bool vizWithGnuplot = false;
 
+  /**
+   * solve by OptimizationAlgorithmIncremental on the supernodal solver,
+   * which relinearizes the vertices whose update exceeds
+   * relinearizeThreshold and re-factorizes the affected part of the factor.
+   * Has to be set before initSolver().
+   */
+  bool fluidRelinearization = false;
+  double relinearizeThreshold = 0.1;
+
   virtual void gnuplotVisualization();
 
  protected:
   FILE* gnuplot_ = nullptr;
   bool usePcg_;
   Solver* underlyingSolver_ = nullptr;
+  OptimizationAlgorithmIncremental* incremental_ = nullptr;
+
+  //! one step of the incremental algorithm, which keeps the estimate current
+  int optimizeFluid(bool online);
 };
 
 }  // namespace g2o
@@ -27,33 +27,63 @@
 #ifndef G2O_LINEAR_SOLVER_PCG_H
 #define G2O_LINEAR_SOLVER_PCG_H
 
+#include <Eigen/Cholesky>
 #include <Eigen/Core>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <numeric>
 #include <utility>
 #include <vector>
 
 #include "g2o/core/batch_stats.h"
 #include "g2o/core/linear_solver.h"
+#include "g2o/stuff/timeutil.h"
 
 namespace g2o {
 
+//! pre-conditioners available for LinearSolverPCG
+enum class PCGPreconditioner {
+  kBlockJacobi,              ///< inverse of the diagonal blocks
+  kBlockIncompleteCholesky,  ///< IC(0) on the block pattern of A
+  kBlockSSOR,                ///< symmetric block Gauss-Seidel
+  kClusterJacobi,  ///< inverse of clusters of strongly coupled blocks
+};
+
 /**
- * \brief linear solver using PCG, pre-conditioner is block Jacobi
+ * \brief linear solver using PCG, pre-conditioner is block Jacobi by default
  */
 template <typename MatrixType>
 class LinearSolverPCG : public LinearSolver<MatrixType> {
  public:
+  using Preconditioner = PCGPreconditioner;
+
   LinearSolverPCG() : LinearSolver<MatrixType>() {}
 
   bool init() override {
     residual_ = -1.0;
     indices_.clear();
     sparseMat_.clear();
+    blockIndices_.clear();
+    colStart_.clear();
+    clusters_.clear();
+    icValid_ = false;
     return true;
   }
 
   bool solve(const SparseBlockMatrix<MatrixType>& A, number_t* x,
              number_t* b) override;
 
+  /**
+   * PCG on an operator, the pre-conditioner is block Jacobi on the given
+   * diagonal blocks regardless of preconditioner()
+   */
+  bool solveImplicit(
+      const SparseBlockMatrix<MatrixType>& diagonal,
+      const typename LinearSolver<MatrixType>::MatrixVectorProduct& product,
+      number_t* x, number_t* b) override;
+  bool supportsImplicit() const override { return true; }
+
   //! return the tolerance for terminating PCG before convergence
   number_t tolerance() const { return tolerance_; }
   void setTolerance(number_t tolerance) { tolerance_ = tolerance; }
@@ -69,22 +99,80 @@ class LinearSolverPCG : public LinearSolver<MatrixType> {
   bool verbose() const { return verbose_; }
   void setVerbose(bool verbose) { verbose_ = verbose; }
 
+  Preconditioner preconditioner() const { return preconditioner_; }
+  void setPreconditioner(Preconditioner preconditioner) {
+    preconditioner_ = preconditioner;
+    clusters_.clear();
+  }
+
+  //! relaxation parameter of SSOR in (0, 2)
+  number_t ssorOmega() const { return ssorOmega_; }
+  void setSsorOmega(number_t omega) { ssorOmega_ = omega; }
+
+  /**
+   * maximal number of blocks in a cluster of the cluster-Jacobi
+   * pre-conditioner. The blocks are greedily merged into clusters along the
+   * strongest off-diagonal couplings. On a reduced camera system, these are the
+   * cameras sharing the most observations.
+   */
+  int clusterSize() const { return clusterSize_; }
+  void setClusterSize(int clusterSize) {
+    clusterSize_ = clusterSize;
+    clusters_.clear();
+  }
+
  protected:
   using MatrixVector =
       std::vector<MatrixType, Eigen::aligned_allocator<MatrixType> >;
   using MatrixPtrVector = std::vector<const MatrixType*>;
+  //! dest = A * src
+  using Product = std::function<void(const VectorX& src, VectorX& dest)>;
 
   number_t tolerance_ = cst(1e-6);
   number_t residual_ = -1.;
   bool absoluteTolerance_ = true;
   bool verbose_ = false;
   int maxIter_ = -1;
+  Preconditioner preconditioner_ = Preconditioner::kBlockJacobi;
+  //! the pre-conditioner of the current solve
+  Preconditioner activePreconditioner_ = Preconditioner::kBlockJacobi;
+  number_t ssorOmega_ = cst(1.);
+  int clusterSize_ = 8;
 
   MatrixPtrVector diag_;
   MatrixVector J_;
 
   std::vector<std::pair<int, int> > indices_;
   MatrixPtrVector sparseMat_;
+  //! block row and block column of the entries of sparseMat_
+  std::vector<std::pair<int, int> > blockIndices_;
+  //! first entry of each block column in sparseMat_
+  std::vector<int> colStart_;
+
+  // block IC(0): A ~ U^T U with U having the block pattern of A
+  bool icValid_ = false;
+  MatrixVector icDiagInverse_;  ///< inverse of the diagonal blocks of U
+  MatrixVector icOffDiagonal_;  ///< off-diagonal blocks of U, as sparseMat_
+
+  // cluster-Jacobi
+  std::vector<std::vector<int> > clusters_;  ///< block indices per cluster
+  std::vector<int> clusterOf_;      ///< cluster of each block
+  std::vector<int> clusterOffset_;  ///< offset of a block inside its cluster
+  std::vector<int> clusterDim_;
+  //! entries of sparseMat_ inside each cluster
+  std::vector<std::vector<int> > clusterEntries_;
+  std::vector<Eigen::LLT<MatrixX> > clusterLLT_;
+  VectorX clusterRhs_;
+
+  bool conjugateGradient(const std::vector<int>& colBlockIndices,
+                         const Product& product, number_t* x, number_t* b,
+                         double timePreconditioner);
+  void setupPreconditioner(const SparseBlockMatrix<MatrixType>& A);
+  void setupIncompleteCholesky();
+  void computeClusters(const SparseBlockMatrix<MatrixType>& A);
+  void setupClusters(const SparseBlockMatrix<MatrixType>& A);
+  void applyPreconditioner(const std::vector<int>& colBlockIndices,
+                           const VectorX& src, VectorX& dest);
 
   void multDiag(const std::vector<int>& colBlockIndices, MatrixVector& A,
                 const VectorX& src, VectorX& dest);
@@ -87,33 +87,86 @@ bool LinearSolverPCG<MatrixType>::solve(const SparseBlockMatrix<MatrixType>& A,
   diag_.clear();
   J_.clear();
 
-  // put the block matrix once in a linear structure, makes mult faster
-  int colIdx = 0;
-  for (size_t i = 0; i < A.blockCols().size(); ++i) {
-    const typename SparseBlockMatrix<MatrixType>::IntBlockMap& col =
-        A.blockCols()[i];
-    if (col.size() > 0) {
-      typename SparseBlockMatrix<MatrixType>::IntBlockMap::const_iterator it;
-      for (it = col.begin(); it != col.end(); ++it) {
+  if (!indexRequired) {
+    // the off-diagonal part is known, only fetch the diagonal blocks
+    for (size_t i = 0; i < A.blockCols().size(); ++i) {
+      const MatrixType* d = A.block(i, i);
+      if (!d) continue;
+      diag_.push_back(d);
+      J_.push_back(d->inverse());
+    }
+  } else {
+    // put the block matrix once in a linear structure, makes mult faster
+    int colIdx = 0;
+    for (size_t i = 0; i < A.blockCols().size(); ++i) {
+      colStart_.push_back(static_cast<int>(sparseMat_.size()));
+      const typename SparseBlockMatrix<MatrixType>::IntBlockMap& col =
+          A.blockCols()[i];
+      for (auto it = col.begin(); it != col.end(); ++it) {
         // only the upper triangular block is needed
         if (it->first == static_cast<int>(i)) {
           diag_.push_back(it->second);
           J_.push_back(it->second->inverse());
           break;
         }
-        if (indexRequired) {
-          indices_.push_back(std::make_pair(
-              it->first > 0 ? A.rowBlockIndices()[it->first - 1] : 0, colIdx));
-          sparseMat_.push_back(it->second);
-        }
+        indices_.push_back(std::make_pair(
+            it->first > 0 ? A.rowBlockIndices()[it->first - 1] : 0, colIdx));
+        blockIndices_.emplace_back(it->first, static_cast<int>(i));
+        sparseMat_.push_back(it->second);
       }
+      colIdx = A.colBlockIndices()[i];
     }
-    colIdx = A.colBlockIndices()[i];
+    colStart_.push_back(static_cast<int>(sparseMat_.size()));
+  }
+
+  activePreconditioner_ = preconditioner_;
+  const double setupStart = get_monotonic_time();
+  setupPreconditioner(A);
+  const double timePreconditioner = get_monotonic_time() - setupStart;
+
+  const std::vector<int>& colBlockIndices = A.colBlockIndices();
+  return conjugateGradient(
+      colBlockIndices,
+      [&](const VectorX& src, VectorX& dest) {
+        mult(colBlockIndices, src, dest);
+      },
+      x, b, timePreconditioner);
+}
+
+template <typename MatrixType>
+bool LinearSolverPCG<MatrixType>::solveImplicit(
+    const SparseBlockMatrix<MatrixType>& diagonal,
+    const typename LinearSolver<MatrixType>::MatrixVectorProduct& product,
+    number_t* x, number_t* b) {
+  // only the diagonal blocks of the operator are known, which limits the
+  // pre-conditioner to block Jacobi
+  const double setupStart = get_monotonic_time();
+  activePreconditioner_ = Preconditioner::kBlockJacobi;
+  diag_.clear();
+  J_.clear();
+  for (size_t i = 0; i < diagonal.blockCols().size(); ++i) {
+    const MatrixType* d = diagonal.block(i, i);
+    assert(d && "missing diagonal block");
+    diag_.push_back(d);
+    J_.push_back(d->inverse());
   }
+  const double timePreconditioner = get_monotonic_time() - setupStart;
+
+  return conjugateGradient(
+      diagonal.colBlockIndices(),
+      [&product](const VectorX& src, VectorX& dest) {
+        product(dest.data(), src.data());
+      },
+      x, b, timePreconditioner);
+}
 
-  int n = A.rows();
+template <typename MatrixType>
+bool LinearSolverPCG<MatrixType>::conjugateGradient(
+    const std::vector<int>& colBlockIndices, const Product& product,
+    number_t* x, number_t* b, double timePreconditioner) {
+  const int n = colBlockIndices.empty() ? 0 : colBlockIndices.back();
   assert(n > 0 && "Hessian has 0 rows/cols");
-  VectorX::MapType xvec(x, A.cols());
+  VectorX::MapType xvec(x, n);
   const VectorX::ConstMapType bvec(b, n);
   xvec.setZero();
 
@@ -126,7 +179,7 @@ bool LinearSolverPCG<MatrixType>::solve(const SparseBlockMatrix<MatrixType>& A,
   s.setZero(n);
 
   r = bvec;
-  multDiag(A.colBlockIndices(), J_, r, d);
+  applyPreconditioner(colBlockIndices, r, d);
   number_t dn = r.dot(d);
   number_t d0 = tolerance_ * dn;
 
@@ -134,19 +187,19 @@ bool LinearSolverPCG<MatrixType>::solve(const SparseBlockMatrix<MatrixType>& A,
     if (residual_ > 0.0 && residual_ > d0) d0 = residual_;
   }
 
-  int maxIter = maxIter_ < 0 ? A.rows() : maxIter_;
+  int maxIter = maxIter_ < 0 ? n : maxIter_;
 
   int iteration;
   for (iteration = 0; iteration < maxIter; ++iteration) {
     if (verbose_)
       std::cerr << "residual[" << iteration << "]: " << dn << std::endl;
     if (dn <= d0) break;  // done
-    mult(A.colBlockIndices(), d, q);
+    product(d, q);
     number_t a = dn / d.dot(q);
     xvec += a * d;
     // TODO(goki): reset residual here every 50 iterations
     r -= a * q;
-    multDiag(A.colBlockIndices(), J_, r, s);
+    applyPreconditioner(colBlockIndices, r, s);
     number_t dold = dn;
     dn = r.dot(s);
     number_t ba = dn / dold;
@@ -157,6 +210,7 @@ bool LinearSolverPCG<MatrixType>::solve(const SparseBlockMatrix<MatrixType>& A,
   G2OBatchStatistics* globalStats = G2OBatchStatistics::globalStats();
   if (globalStats) {
     globalStats->iterationsLinearSolver = iteration;
+    globalStats->timePreconditioner = timePreconditioner;
   }
 
   return true;
@@ -205,3 +259,232 @@ void LinearSolverPCG<MatrixType>::mult(const std::vector<int>& colBlockIndices,
     internal::pcg_atxpy(*a, src, srcOffsetT, dest, destOffsetT);
   }
 }
+
+template <typename MatrixType>
+void LinearSolverPCG<MatrixType>::setupPreconditioner(
+    const SparseBlockMatrix<MatrixType>& A) {
+  switch (activePreconditioner_) {
+    case Preconditioner::kBlockIncompleteCholesky:
+      setupIncompleteCholesky();
+      break;
+    case Preconditioner::kClusterJacobi:
+      if (clusters_.empty()) computeClusters(A);
+      setupClusters(A);
+      break;
+    default:
+      break;
+  }
+}
+
+template <typename MatrixType>
+void LinearSolverPCG<MatrixType>::setupIncompleteCholesky() {
+  const int numBlocks = static_cast<int>(diag_.size());
+  icDiagInverse_.resize(numBlocks);
+  icOffDiagonal_.resize(sparseMat_.size());
+
+  // A breakdown of IC(0) is handled by restarting with an increasing shift of
+  // the diagonal. If all attempts fail, block Jacobi is used instead.
+  number_t shift = 0.;
+  for (int attempt = 0; attempt < 8; ++attempt) {
+    icValid_ = true;
+    for (int j = 0; j < numBlocks && icValid_; ++j) {
+      for (int e = colStart_[j]; e < colStart_[j + 1]; ++e) {
+        // U_kj = U_kk^-T (A_kj - sum_i U_ik^T U_ij) for the rows i < k
+        // present in both columns
+        const int k = blockIndices_[e].first;
+        MatrixType u = *sparseMat_[e];
+        int p = colStart_[k];
+        int q = colStart_[j];
+        while (p < colStart_[k + 1] && q < e) {
+          if (blockIndices_[p].first < blockIndices_[q].first) {
+            ++p;
+          } else if (blockIndices_[q].first < blockIndices_[p].first) {
+            ++q;
+          } else {
+            u.noalias() -= icOffDiagonal_[p].transpose() * icOffDiagonal_[q];
+            ++p;
+            ++q;
+          }
+        }
+        icOffDiagonal_[e].noalias() = icDiagInverse_[k].transpose() * u;
+      }
+      MatrixType d = *diag_[j];
+      d.diagonal() += shift * diag_[j]->diagonal();
+      for (int e = colStart_[j]; e < colStart_[j + 1]; ++e)
+        d.noalias() -= icOffDiagonal_[e].transpose() * icOffDiagonal_[e];
+      Eigen::LLT<MatrixType> llt(d);
+      if (llt.info() != Eigen::Success) {
+        icValid_ = false;
+        break;
+      }
+      icDiagInverse_[j] =
+          llt.matrixU().solve(MatrixType::Identity(d.rows(), d.cols()));
+    }
+    if (icValid_) return;
+    shift = shift > 0. ? 10. * shift : cst(1e-3);
+    if (verbose_)
+      std::cerr << "IC(0) breakdown, diagonal shift " << shift << std::endl;
+  }
+}
+
+template <typename MatrixType>
+void LinearSolverPCG<MatrixType>::computeClusters(
+    const SparseBlockMatrix<MatrixType>& A) {
+  const int numBlocks = static_cast<int>(diag_.size());
+
+  // strength of the couplings, normalized by the diagonal blocks
+  std::vector<std::pair<number_t, int> > couplings;
+  couplings.reserve(sparseMat_.size());
+  for (size_t e = 0; e < sparseMat_.size(); ++e) {
+    const number_t scale = diag_[blockIndices_[e].first]->norm() *
+                           diag_[blockIndices_[e].second]->norm();
+    couplings.emplace_back(sparseMat_[e]->squaredNorm() / scale,
+                           static_cast<int>(e));
+  }
+  std::sort(couplings.begin(), couplings.end(),
+            std::greater<std::pair<number_t, int> >());
+
+  // greedily merge along the strongest couplings up to clusterSize_ blocks
+  std::vector<int> root(numBlocks);
+  std::vector<int> size(numBlocks, 1);
+  std::iota(root.begin(), root.end(), 0);
+  auto find = [&root](int b) {
+    while (root[b] != b) b = root[b] = root[root[b]];
+    return b;
+  };
+  for (const auto& coupling : couplings) {
+    const int a = find(blockIndices_[coupling.second].first);
+    const int b = find(blockIndices_[coupling.second].second);
+    if (a == b || size[a] + size[b] > clusterSize_) continue;
+    root[b] = a;
+    size[a] += size[b];
+  }
+
+  clusters_.clear();
+  clusterDim_.clear();
+  clusterOf_.assign(numBlocks, -1);
+  clusterOffset_.resize(numBlocks);
+  std::vector<int> clusterOfRoot(numBlocks, -1);
+  for (int b = 0; b < numBlocks; ++b) {
+    int& c = clusterOfRoot[find(b)];
+    if (c < 0) {
+      c = static_cast<int>(clusters_.size());
+      clusters_.emplace_back();
+      clusterDim_.push_back(0);
+    }
+    clusterOf_[b] = c;
+    clusterOffset_[b] = clusterDim_[c];
+    clusters_[c].push_back(b);
+    clusterDim_[c] += A.colsOfBlock(b);
+  }
+  clusterEntries_.assign(clusters_.size(), std::vector<int>());
+  for (size_t e = 0; e < sparseMat_.size(); ++e) {
+    const int c = clusterOf_[blockIndices_[e].first];
+    if (c == clusterOf_[blockIndices_[e].second])
+      clusterEntries_[c].push_back(static_cast<int>(e));
+  }
+}
+
+template <typename MatrixType>
+void LinearSolverPCG<MatrixType>::setupClusters(
+    const SparseBlockMatrix<MatrixType>& A) {
+  clusterLLT_.resize(clusters_.size());
+  MatrixX m;
+  for (size_t c = 0; c < clusters_.size(); ++c) {
+    m.setZero(clusterDim_[c], clusterDim_[c]);
+    for (int b : clusters_[c]) {
+      const int offset = clusterOffset_[b];
+      m.block(offset, offset, A.colsOfBlock(b), A.colsOfBlock(b)) = *diag_[b];
+    }
+    for (int e : clusterEntries_[c]) {
+      const MatrixType& block = *sparseMat_[e];
+      const int r = clusterOffset_[blockIndices_[e].first];
+      const int cc = clusterOffset_[blockIndices_[e].second];
+      m.block(r, cc, block.rows(), block.cols()) = block;
+      m.block(cc, r, block.cols(), block.rows()) = block.transpose();
+    }
+    clusterLLT_[c].compute(m);
+  }
+}
+
+template <typename MatrixType>
+void LinearSolverPCG<MatrixType>::applyPreconditioner(
+    const std::vector<int>& colBlockIndices, const VectorX& src,
+    VectorX& dest) {
+  auto offset = [&colBlockIndices](int b) {
+    return b > 0 ? colBlockIndices[b - 1] : 0;
+  };
+  auto dim = [&](int b) { return colBlockIndices[b] - offset(b); };
+  const int numBlocks = static_cast<int>(diag_.size());
+
+  switch (activePreconditioner_) {
+    case Preconditioner::kBlockIncompleteCholesky: {
+      if (!icValid_) break;
+      // solve U^T y = src, then U dest = y
+      dest = src;
+      for (int j = 0; j < numBlocks; ++j) {
+        auto yj = dest.segment(offset(j), dim(j));
+        for (int e = colStart_[j]; e < colStart_[j + 1]; ++e) {
+          const int k = blockIndices_[e].first;
+          yj.noalias() -=
+              icOffDiagonal_[e].transpose() * dest.segment(offset(k), dim(k));
+        }
+        yj = icDiagInverse_[j].transpose() * yj;
+      }
+      for (int j = numBlocks - 1; j >= 0; --j) {
+        auto zj = dest.segment(offset(j), dim(j));
+        zj = icDiagInverse_[j] * zj;
+        for (int e = colStart_[j]; e < colStart_[j + 1]; ++e) {
+          const int k = blockIndices_[e].first;
+          dest.segment(offset(k), dim(k)).noalias() -= icOffDiagonal_[e] * zj;
+        }
+      }
+      return;
+    }
+    case Preconditioner::kBlockSSOR: {
+      // M = 1 / (w (2 - w)) (D + w L) D^-1 (D + w L^T)
+      const number_t omega = ssorOmega_;
+      for (int j = 0; j < numBlocks; ++j) {
+        auto yj = dest.segment(offset(j), dim(j));
+        yj = src.segment(offset(j), dim(j));
+        for (int e = colStart_[j]; e < colStart_[j + 1]; ++e) {
+          const int k = blockIndices_[e].first;
+          yj.noalias() -= omega * sparseMat_[e]->transpose() *
+                          dest.segment(offset(k), dim(k));
+        }
+        yj = J_[j] * yj;
+      }
+      for (int j = 0; j < numBlocks; ++j) {
+        auto yj = dest.segment(offset(j), dim(j));
+        yj = *diag_[j] * yj;
+      }
+      for (int j = numBlocks - 1; j >= 0; --j) {
+        auto zj = dest.segment(offset(j), dim(j));
+        zj = J_[j] * zj;
+        for (int e = colStart_[j]; e < colStart_[j + 1]; ++e) {
+          const int k = blockIndices_[e].first;
+          dest.segment(offset(k), dim(k)).noalias() -=
+              omega * *sparseMat_[e] * zj;
+        }
+      }
+      dest *= omega * (2. - omega);
+      return;
+    }
+    case Preconditioner::kClusterJacobi: {
+      for (size_t c = 0; c < clusters_.size(); ++c) {
+        clusterRhs_.resize(clusterDim_[c]);
+        for (int b : clusters_[c])
+          clusterRhs_.segment(clusterOffset_[b], dim(b)) =
+              src.segment(offset(b), dim(b));
+        clusterLLT_[c].solveInPlace(clusterRhs_);
+        for (int b : clusters_[c])
+          dest.segment(offset(b), dim(b)) =
+              clusterRhs_.segment(clusterOffset_[b], dim(b));
+      }
+      return;
+    }
+    default:
+      break;
+  }
+  multDiag(colBlockIndices, J_, src, dest);
+}
@@ -36,13 +36,17 @@
 
 namespace g2o {
 namespace {
-template <int P, int L>
+template <int P, int L,
+          PCGPreconditioner Preconditioner = PCGPreconditioner::kBlockJacobi>
 std::unique_ptr<g2o::Solver> AllocateSolver() {
-  std::cerr << "# Using PCG poseDim " << P << " landMarkDim " << L << std::endl;
+  std::cerr << "# Using PCG poseDim " << P << " landMarkDim " << L
+            << " preconditioner " << static_cast<int>(Preconditioner)
+            << std::endl;
 
-  return g2o::make_unique<BlockSolverPL<P, L>>(
-      g2o::make_unique<
-          LinearSolverPCG<typename BlockSolverPL<P, L>::PoseMatrixType>>());
+  auto linearSolver = g2o::make_unique<
+      LinearSolverPCG<typename BlockSolverPL<P, L>::PoseMatrixType>>();
+  linearSolver->setPreconditioner(Preconditioner);
+  return g2o::make_unique<BlockSolverPL<P, L>>(std::move(linearSolver));
 }
 }  // namespace
 
@@ -54,6 +58,12 @@ static OptimizationAlgorithm* createSolver(const std::string& fullSolverName) {
           {"pcg3_2", &AllocateSolver<3, 2>},
           {"pcg6_3", &AllocateSolver<6, 3>},
           {"pcg7_3", &AllocateSolver<7, 3>},
+          {"pcg_ic0",
+           &AllocateSolver<-1, -1,
+                           PCGPreconditioner::kBlockIncompleteCholesky>},
+          {"pcg_ssor", &AllocateSolver<-1, -1, PCGPreconditioner::kBlockSSOR>},
+          {"pcg_cluster",
+           &AllocateSolver<-1, -1, PCGPreconditioner::kClusterJacobi>},
       };
 
   const std::string solverName = fullSolverName.substr(3);
@@ -132,4 +142,40 @@ G2O_REGISTER_OPTIMIZATION_ALGORITHM(
                    "Levenberg: PCG solver using block-Jacobi pre-conditioner "
                    "(fixed blocksize)",
                    "PCG", true, 7, 3)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    gn_pcg_ic0, new PCGSolverCreator(OptimizationAlgorithmProperty(
+                    "gn_pcg_ic0",
+                    "Gauss-Newton: PCG solver using block incomplete Cholesky "
+                    "pre-conditioner (variable blocksize)",
+                    "PCG", false, Eigen::Dynamic, Eigen::Dynamic)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    gn_pcg_ssor, new PCGSolverCreator(OptimizationAlgorithmProperty(
+                     "gn_pcg_ssor",
+                     "Gauss-Newton: PCG solver using block SSOR "
+                     "pre-conditioner (variable blocksize)",
+                     "PCG", false, Eigen::Dynamic, Eigen::Dynamic)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    gn_pcg_cluster, new PCGSolverCreator(OptimizationAlgorithmProperty(
+                        "gn_pcg_cluster",
+                        "Gauss-Newton: PCG solver using cluster-Jacobi "
+                        "pre-conditioner (variable blocksize)",
+                        "PCG", false, Eigen::Dynamic, Eigen::Dynamic)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    lm_pcg_ic0, new PCGSolverCreator(OptimizationAlgorithmProperty(
+                    "lm_pcg_ic0",
+                    "Levenberg: PCG solver using block incomplete Cholesky "
+                    "pre-conditioner (variable blocksize)",
+                    "PCG", false, Eigen::Dynamic, Eigen::Dynamic)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    lm_pcg_ssor, new PCGSolverCreator(OptimizationAlgorithmProperty(
+                     "lm_pcg_ssor",
+                     "Levenberg: PCG solver using block SSOR pre-conditioner "
+                     "(variable blocksize)",
+                     "PCG", false, Eigen::Dynamic, Eigen::Dynamic)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    lm_pcg_cluster, new PCGSolverCreator(OptimizationAlgorithmProperty(
+                        "lm_pcg_cluster",
+                        "Levenberg: PCG solver using cluster-Jacobi "
+                        "pre-conditioner (variable blocksize)",
+                        "PCG", false, Eigen::Dynamic, Eigen::Dynamic)));
 }  // namespace g2o
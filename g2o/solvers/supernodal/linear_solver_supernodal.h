@@ -0,0 +1,779 @@
+// g2o - General Graph Optimization
+// Copyright (C) 2011 R. Kuemmerle, G. Grisetti, W. Burgard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef G2O_LINEAR_SOLVER_SUPERNODAL_H
+#define G2O_LINEAR_SOLVER_SUPERNODAL_H
+
+#include <Eigen/Cholesky>
+#include <Eigen/OrderingMethods>
+#include <Eigen/Sparse>
+#include <algorithm>
+#include <cassert>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include "g2o/core/batch_stats.h"
+#include "g2o/core/linear_solver.h"
+#include "g2o/core/marginal_covariance_cholesky.h"
+#include "g2o/core/parallel_executor.h"
+#include "g2o/stuff/timeutil.h"
+
+namespace g2o {
+
+/**
+ * \brief supernodal Cholesky solver working on the blocks of the system
+ *
+ * The symbolic analysis is carried out on the block pattern of A: the blocks
+ * are ordered by AMD, the elimination tree and the structure of the factor are
+ * computed per block column and consecutive block columns which share their
+ * structure are merged into supernodes. Each supernode keeps its part of the
+ * factor as a dense column-major panel. Hence, the numeric factorization and
+ * the triangular solves reduce to dense Eigen kernels (LLT, triangular solves
+ * and matrix products) on these panels.
+ *
+ * The factorization is left-looking: a supernode gathers its entries of A and
+ * the updates of its descendants before it gets factorized. Supernodes only
+ * depend on their descendants in the elimination tree. Given an executor, the
+ * supernodes are processed level by level, where the supernodes of one level
+ * belong to independent subtrees and are processed concurrently. The same
+ * holds for the triangular solves. The result does not depend on the number
+ * of threads.
+ *
+ * In incremental mode, see setIncremental(), the factor is updated rather
+ * than recomputed when the system grows by appending blocks, as it happens
+ * with SparseOptimizer::updateInitialization().
+ */
+template <typename MatrixType>
+class LinearSolverSupernodal : public LinearSolverCCS<MatrixType> {
+ public:
+  LinearSolverSupernodal() : LinearSolverCCS<MatrixType>() {}
+
+  bool init() override {
+    init_ = true;
+    return true;
+  }
+
+  bool solve(const SparseBlockMatrix<MatrixType>& A, number_t* x,
+             number_t* b) override {
+    if (!factorize(A)) return false;
+    const int n = static_cast<int>(scalarPermutation_.size());
+    y_.resize(n);
+    for (int i = 0; i < n; ++i) y_(i) = b[scalarPermutation_(i)];
+    forEachSupernode(false, levelSolveFlops_, [&](int s, Workspace& ws) {
+      forwardSubstitution(s, y_, ws);
+      return true;
+    });
+    forEachSupernode(true, levelSolveFlops_, [&](int s, Workspace& ws) {
+      backSubstitution(s, y_, ws);
+      return true;
+    });
+    for (int i = 0; i < n; ++i) x[scalarPermutation_(i)] = y_(i);
+    return true;
+  }
+
+  /**
+   * executor for processing independent supernodes in parallel. nullptr
+   * (the default) runs the factorization and the solves sequentially.
+   */
+  const std::shared_ptr<ParallelExecutor>& executor() const {
+    return executor_;
+  }
+  void setExecutor(std::shared_ptr<ParallelExecutor> executor) {
+    executor_ = std::move(executor);
+  }
+
+  /**
+   * levels of the elimination tree with less estimated floating point
+   * operations are processed on the calling thread
+   */
+  double minParallelFlops() const { return minParallelFlops_; }
+  void setMinParallelFlops(double flops) { minParallelFlops_ = flops; }
+
+  //! number of supernodes of the current symbolic factorization
+  int numSupernodes() const { return static_cast<int>(supernodes_.size()); }
+
+  //! number of non-zeros in the Cholesky factor
+  size_t factorNonZeros() const { return factorNonZeros_; }
+
+  //! number of levels of the elimination tree of the supernodes
+  int numLevels() const { return static_cast<int>(levelFactorFlops_.size()); }
+
+  /**
+   * In incremental mode, a new analysis of the pattern keeps the ordering of
+   * the blocks analyzed before and orders the new blocks last. The panel of a
+   * supernode is kept if neither its structure, nor its values of A, nor one
+   * of its descendants changed. Hence, appending blocks to the system only
+   * re-factorizes the supernodes on the paths from the new blocks to the
+   * root of the elimination tree.
+   */
+  bool incremental() const { return incremental_; }
+  void setIncremental(bool incremental) {
+    incremental_ = incremental;
+    init_ = true;
+  }
+
+  /**
+   * number of analyses keeping the ordering in incremental mode before the
+   * blocks are ordered from scratch again
+   */
+  int reorderInterval() const { return reorderInterval_; }
+  void setReorderInterval(int interval) { reorderInterval_ = interval; }
+
+  //! number of supernodes factorized by the last solve
+  int refactorizedSupernodes() const { return refactorizedSupernodes_; }
+
+ protected:
+  /**
+   * a set of consecutive block columns of the factor with the same structure
+   * below the diagonal. The rows of the supernode are stored in rowBlocks_,
+   * starting with the block columns of the supernode itself.
+   */
+  struct Supernode {
+    int firstBlock;  ///< first block column in the permuted order
+    int endBlock;    ///< one past the last block column
+    int rowsBegin;   ///< first row of the supernode in rowBlocks_
+    int rowsEnd;     ///< one past the last row of the supernode in rowBlocks_
+    int width;       ///< number of scalar columns
+  };
+
+  //! contribution of a descendant to the panel of a supernode
+  struct Update {
+    int source;     ///< the descendant supernode
+    int rowsBegin;  ///< first row of the source falling into the target
+    int rowsEnd;    ///< one past the last row falling into the target
+  };
+
+  //! a block of A which is copied into the panel of a supernode
+  struct Assembly {
+    const MatrixType* block;
+    int row;          ///< row offset inside the panel
+    int col;          ///< column offset inside the panel
+    bool transposed;  ///< block belongs to the upper triangle after ordering
+  };
+
+  //! scratch memory of a thread
+  struct Workspace {
+    std::vector<int> relativeRow;  ///< row offset of a block in the panel
+    MatrixX work;                  ///< update of a descendant
+    VectorX tmp;
+    VectorX values;  ///< values of A assembled into a panel
+  };
+
+  bool init_ = true;
+  bool incremental_ = false;
+  int reorderInterval_ = 100;
+  int analysesSinceReorder_ = 0;
+  int refactorizedSupernodes_ = 0;
+  std::shared_ptr<ParallelExecutor> executor_;
+  double minParallelFlops_ = 1e5;
+  Eigen::VectorXi blockPermutation_;   ///< new block index -> old block index
+  Eigen::VectorXi scalarPermutation_;  ///< new scalar index -> old index
+  Eigen::VectorXi scalarInversePermutation_;  ///< old index -> new index
+  std::vector<int> blockBase_;  ///< scalar offset of each permuted block
+  std::vector<Supernode> supernodes_;
+  std::vector<int> supernodeOf_;  ///< supernode of each permuted block column
+  std::vector<int> rowBlocks_;    ///< block rows of all supernodes
+  std::vector<int> rowOffsets_;   ///< scalar offset of the rows in the panel
+  std::vector<std::vector<Update>> updates_;
+  std::vector<std::vector<Assembly>> assemblies_;
+  std::vector<MatrixX> panels_;
+  std::vector<char> panelValid_;    ///< panel holds the factor of its input
+  std::vector<char> refactorized_;  ///< panel changed by the last factorize
+  std::vector<VectorX> assembledValues_;  ///< input of A of each panel
+  size_t factorNonZeros_ = 0;
+
+  //! supernodes ordered by their level in the elimination tree
+  std::vector<int> levelSupernodes_;
+  std::vector<int> levelBegin_;  ///< first entry of a level in levelSupernodes_
+  std::vector<double> levelFactorFlops_;  ///< estimated cost per level
+  std::vector<double> levelSolveFlops_;   ///< estimated cost per level
+
+  std::vector<Workspace> workspaces_;
+  VectorX y_;
+
+  // CCS representation of the factor for computing the marginals
+  std::vector<int> Lp_;
+  std::vector<int> Li_;
+  std::vector<number_t> Lx_;
+
+  int blockDim(int block) const {
+    return blockBase_[block + 1] - blockBase_[block];
+  }
+
+  //! scalar offset of the end of the rows of an update in the source panel
+  int rowsEndOffset(const Update& u) const {
+    return u.rowsEnd < supernodes_[u.source].rowsEnd
+               ? rowOffsets_[u.rowsEnd]
+               : static_cast<int>(panels_[u.source].rows());
+  }
+
+  /**
+   * call body(s, workspace) for all supernodes such that the descendants of s
+   * are processed before s, or after s if reverse is true. Levels are run in
+   * parallel on the executor if their cost exceeds minParallelFlops_.
+   * Returns false if body returned false for a supernode.
+   */
+  template <typename Body>
+  bool forEachSupernode(bool reverse, const std::vector<double>& levelFlops,
+                        Body&& body) {
+    const int numThreads = executor_ ? executor_->numThreads() : 1;
+    if (static_cast<int>(workspaces_.size()) < numThreads)
+      workspaces_.resize(numThreads);
+    for (Workspace& ws : workspaces_)
+      ws.relativeRow.resize(supernodeOf_.size());
+
+    const int numSupernodes = static_cast<int>(supernodes_.size());
+    if (numThreads <= 1) {
+      for (int i = 0; i < numSupernodes; ++i) {
+        const int s = reverse ? numSupernodes - 1 - i : i;
+        if (!body(s, workspaces_[0])) return false;
+      }
+      return true;
+    }
+
+    const int numLevels = static_cast<int>(levelFlops.size());
+    for (int l = 0; l < numLevels; ++l) {
+      const int level = reverse ? numLevels - 1 - l : l;
+      const int* supernodes = levelSupernodes_.data() + levelBegin_[level];
+      const int count = levelBegin_[level + 1] - levelBegin_[level];
+      if (count == 1 || levelFlops[level] < minParallelFlops_) {
+        for (int i = 0; i < count; ++i)
+          if (!body(supernodes[i], workspaces_[0])) return false;
+        continue;
+      }
+      std::atomic<bool> ok(true);
+      executor_->parallelFor(count, 1, [&](int begin, int end, int thread) {
+        for (int i = begin; i < end; ++i)
+          if (!body(supernodes[i], workspaces_[thread])) ok = false;
+      });
+      if (!ok) return false;
+    }
+    return true;
+  }
+
+  //! compute the numeric factorization, analyze the pattern if needed
+  bool factorize(const SparseBlockMatrix<MatrixType>& A) {
+    if (init_) computeSymbolicDecomposition(A);
+    init_ = false;
+
+    const double t = get_monotonic_time();
+    const bool ok = forEachSupernode(
+        false, levelFactorFlops_,
+        [this](int s, Workspace& ws) { return factorizeSupernode(s, ws); });
+    refactorizedSupernodes_ = static_cast<int>(
+        std::count(refactorized_.begin(), refactorized_.end(), 1));
+    if (!ok) {
+      if (this->writeDebug()) {
+        std::cerr << "Cholesky failure, writing debug.txt (Hessian loadable by "
+                     "Octave)"
+                  << std::endl;
+        A.writeOctave("debug.txt");
+      }
+      return false;
+    }
+    G2OBatchStatistics* globalStats = G2OBatchStatistics::globalStats();
+    if (globalStats) {
+      globalStats->timeNumericDecomposition = get_monotonic_time() - t;
+      globalStats->choleskyNNZ = factorNonZeros_;
+    }
+    return true;
+  }
+
+  /**
+   * Ordering, elimination tree, supernodes and the layout of the panels. As
+   * the pattern of A does not change between the iterations, all this is
+   * computed once and re-used until init() is called.
+   */
+  void computeSymbolicDecomposition(const SparseBlockMatrix<MatrixType>& A) {
+    const double t = get_monotonic_time();
+    assert(A.rows() == A.cols() && "Matrix A is not square");
+    this->initMatrixStructure(A);
+    const auto& blockCols = this->ccsMatrix_->blockCols();
+    const int n = static_cast<int>(blockCols.size());
+
+    // in incremental mode, the blocks of the last analysis keep their position
+    // and the previous panels are candidates for being re-used
+    const int previousBlocks = static_cast<int>(blockPermutation_.size());
+    const bool keepOrdering = incremental_ && previousBlocks > 0 &&
+                              previousBlocks <= n &&
+                              analysesSinceReorder_ < reorderInterval_;
+    std::vector<Supernode> previousSupernodes;
+    std::vector<int> previousRowBlocks;
+    std::vector<int> previousBlockBase;
+    std::vector<std::vector<Update>> previousUpdates;
+    std::vector<MatrixX> previousPanels;
+    std::vector<char> previousValid;
+    std::vector<VectorX> previousValues;
+    if (keepOrdering) {
+      previousSupernodes.swap(supernodes_);
+      previousRowBlocks.swap(rowBlocks_);
+      previousBlockBase.swap(blockBase_);
+      previousUpdates.swap(updates_);
+      previousPanels.swap(panels_);
+      previousValid.swap(panelValid_);
+      previousValues.swap(assembledValues_);
+    }
+
+    // fill-reducing ordering of the blocks
+    if (keepOrdering) {
+      blockPermutation_.conservativeResize(n);
+      for (int k = previousBlocks; k < n; ++k) blockPermutation_(k) = k;
+      ++analysesSinceReorder_;
+    } else if (this->blockOrdering() && n > 0) {
+      blockPermutation_.resize(n);
+      using SparseMatrix = Eigen::SparseMatrix<number_t, Eigen::ColMajor>;
+      SparseMatrix auxBlockMatrix(n, n);
+      auxBlockMatrix.resizeNonZeros(A.nonZeroBlocks());
+      A.fillBlockStructure(auxBlockMatrix.outerIndexPtr(),
+                           auxBlockMatrix.innerIndexPtr());
+      Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic> blockP;
+      Eigen::AMDOrdering<SparseMatrix::StorageIndex> ordering;
+      ordering(auxBlockMatrix, blockP);
+      blockPermutation_ = blockP.indices();
+      analysesSinceReorder_ = 0;
+    } else {
+      blockPermutation_.resize(n);
+      std::iota(blockPermutation_.data(), blockPermutation_.data() + n, 0);
+      analysesSinceReorder_ = 0;
+    }
+    std::vector<int> inversePermutation(n);
+    blockBase_.resize(n + 1);
+    blockBase_[0] = 0;
+    for (int k = 0; k < n; ++k) {
+      inversePermutation[blockPermutation_(k)] = k;
+      blockBase_[k + 1] = blockBase_[k] + A.colsOfBlock(blockPermutation_(k));
+    }
+    scalarPermutation_.resize(A.cols());
+    this->blockToScalarPermutation(A, blockPermutation_, scalarPermutation_);
+    scalarInversePermutation_.resize(A.cols());
+    for (int i = 0; i < A.cols(); ++i)
+      scalarInversePermutation_(scalarPermutation_(i)) = i;
+
+    // strictly lower block pattern of the permuted matrix, per column
+    std::vector<std::vector<int>> lowerPattern(n);
+    for (int c = 0; c < n; ++c) {
+      for (const auto& rb : blockCols[c]) {
+        if (rb.row >= c) continue;
+        const int pr = inversePermutation[rb.row];
+        const int pc = inversePermutation[c];
+        lowerPattern[std::min(pr, pc)].push_back(std::max(pr, pc));
+      }
+    }
+
+    // structure of the factor and elimination tree. The structure of a column
+    // is the union of its pattern in A and the structures of its children.
+    std::vector<std::vector<int>> structure(n);
+    std::vector<int> parent(n, -1);
+    std::vector<int> firstChild(n, -1);
+    std::vector<int> nextSibling(n, -1);
+    std::vector<int> marker(n, -1);
+    for (int j = 0; j < n; ++j) {
+      marker[j] = j;
+      std::vector<int>& s = structure[j];
+      auto addRow = [&](int r) {
+        if (marker[r] == j) return;
+        marker[r] = j;
+        s.push_back(r);
+      };
+      for (int r : lowerPattern[j]) addRow(r);
+      for (int c = firstChild[j]; c >= 0; c = nextSibling[c])
+        for (int r : structure[c]) addRow(r);
+      std::sort(s.begin(), s.end());
+      if (s.empty()) continue;
+      parent[j] = s.front();
+      nextSibling[j] = firstChild[parent[j]];
+      firstChild[parent[j]] = j;
+    }
+
+    // fundamental supernodes: a column is merged with its only child if the
+    // child is the previous column and the structures agree
+    supernodes_.clear();
+    supernodeOf_.resize(n);
+    for (int j = 0; j < n; ++j) {
+      const bool extend = j > 0 && parent[j - 1] == j &&
+                          firstChild[j] == j - 1 && nextSibling[j - 1] < 0 &&
+                          structure[j - 1].size() == structure[j].size() + 1;
+      if (extend)
+        supernodes_.back().endBlock = j + 1;
+      else
+        supernodes_.push_back(Supernode{j, j + 1, 0, 0, 0});
+      supernodeOf_[j] = static_cast<int>(supernodes_.size()) - 1;
+    }
+
+    // rows and panels of the supernodes
+    const int numSupernodes = static_cast<int>(supernodes_.size());
+    rowBlocks_.clear();
+    rowOffsets_.clear();
+    std::vector<int> panelRows(numSupernodes);
+    factorNonZeros_ = 0;
+    for (int s = 0; s < numSupernodes; ++s) {
+      Supernode& sn = supernodes_[s];
+      sn.rowsBegin = static_cast<int>(rowBlocks_.size());
+      int offset = 0;
+      auto addRow = [&](int r) {
+        rowBlocks_.push_back(r);
+        rowOffsets_.push_back(offset);
+        offset += blockDim(r);
+      };
+      for (int b = sn.firstBlock; b < sn.endBlock; ++b) addRow(b);
+      sn.width = offset;
+      for (int r : structure[sn.firstBlock])
+        if (r >= sn.endBlock) addRow(r);
+      sn.rowsEnd = static_cast<int>(rowBlocks_.size());
+      panelRows[s] = offset;
+      factorNonZeros_ += static_cast<size_t>(sn.width) * (sn.width + 1) / 2 +
+                         static_cast<size_t>(offset - sn.width) * sn.width;
+    }
+
+    // the rows below the diagonal of a supernode update its ancestors. The
+    // rows falling into one ancestor are consecutive.
+    updates_.assign(numSupernodes, std::vector<Update>());
+    for (int s = 0; s < numSupernodes; ++s) {
+      const Supernode& sn = supernodes_[s];
+      int i = sn.rowsBegin + sn.endBlock - sn.firstBlock;
+      while (i < sn.rowsEnd) {
+        const int target = supernodeOf_[rowBlocks_[i]];
+        int j = i + 1;
+        while (j < sn.rowsEnd && supernodeOf_[rowBlocks_[j]] == target) ++j;
+        updates_[target].push_back(Update{s, i, j});
+        i = j;
+      }
+    }
+
+    // a previous panel is still valid if the supernode has the same rows and
+    // descendants, the values of A are compared when factorizing
+    panels_.resize(numSupernodes);
+    panelValid_.assign(numSupernodes, 0);
+    refactorized_.assign(numSupernodes, 1);
+    assembledValues_.resize(numSupernodes);
+    std::vector<int> previousAt(keepOrdering ? previousBlocks : 0, -1);
+    for (size_t p = 0; p < previousSupernodes.size(); ++p)
+      if (previousValid[p])
+        previousAt[previousSupernodes[p].firstBlock] = static_cast<int>(p);
+    for (int s = 0; s < numSupernodes; ++s) {
+      const Supernode& sn = supernodes_[s];
+      const int p = sn.firstBlock < static_cast<int>(previousAt.size())
+                        ? previousAt[sn.firstBlock]
+                        : -1;
+      if (p >= 0 && sameSupernode(s, previousSupernodes, p, previousRowBlocks,
+                                  previousBlockBase, previousUpdates[p])) {
+        panels_[s].swap(previousPanels[p]);
+        assembledValues_[s].swap(previousValues[p]);
+        panelValid_[s] = 1;
+      } else {
+        panels_[s].resize(panelRows[s], sn.width);
+      }
+    }
+
+    // location of the blocks of A inside the panels
+    assemblies_.assign(numSupernodes, std::vector<Assembly>());
+    for (int c = 0; c < n; ++c) {
+      for (const auto& rb : blockCols[c]) {
+        if (rb.row > c) continue;
+        const int pr = inversePermutation[rb.row];
+        const int pc = inversePermutation[c];
+        const int lo = std::min(pr, pc);
+        const int hi = std::max(pr, pc);
+        const int s = supernodeOf_[lo];
+        const Supernode& sn = supernodes_[s];
+        const auto rowIt =
+            std::lower_bound(rowBlocks_.begin() + sn.rowsBegin,
+                             rowBlocks_.begin() + sn.rowsEnd, hi);
+        assert(rowIt != rowBlocks_.begin() + sn.rowsEnd && *rowIt == hi);
+        assemblies_[s].push_back(
+            Assembly{rb.block, rowOffsets_[rowIt - rowBlocks_.begin()],
+                     blockBase_[lo] - blockBase_[sn.firstBlock], pr < pc});
+      }
+    }
+
+    // levels of the elimination tree of the supernodes, leaves are at level
+    // zero and a parent is above all of its children
+    std::vector<int> level(numSupernodes, 0);
+    int numLevels = 0;
+    for (int s = 0; s < numSupernodes; ++s) {
+      numLevels = std::max(numLevels, level[s] + 1);
+      const int p = parent[supernodes_[s].endBlock - 1];
+      if (p >= 0) {
+        int& parentLevel = level[supernodeOf_[p]];
+        parentLevel = std::max(parentLevel, level[s] + 1);
+      }
+    }
+    levelBegin_.assign(numLevels + 1, 0);
+    for (int s = 0; s < numSupernodes; ++s) ++levelBegin_[level[s] + 1];
+    std::partial_sum(levelBegin_.begin(), levelBegin_.end(),
+                     levelBegin_.begin());
+    levelSupernodes_.resize(numSupernodes);
+    std::vector<int> levelFill(levelBegin_.begin(), levelBegin_.end() - 1);
+    for (int s = 0; s < numSupernodes; ++s)
+      levelSupernodes_[levelFill[level[s]]++] = s;
+
+    // estimated floating point operations of each level
+    levelFactorFlops_.assign(numLevels, 0.);
+    levelSolveFlops_.assign(numLevels, 0.);
+    for (int s = 0; s < numSupernodes; ++s) {
+      const double w = supernodes_[s].width;
+      const double h = static_cast<double>(panels_[s].rows());
+      double factorFlops = w * w * w / 3. + (h - w) * w * w;
+      double solveFlops = 4. * h * w;
+      for (const Update& u : updates_[s]) {
+        const double source = supernodes_[u.source].width;
+        const int r0 = rowOffsets_[u.rowsBegin];
+        const double rows = rowsEndOffset(u) - r0;
+        factorFlops += 2. * (panels_[u.source].rows() - r0) * rows * source;
+        solveFlops += 2. * rows * source;
+      }
+      levelFactorFlops_[level[s]] += factorFlops;
+      levelSolveFlops_[level[s]] += solveFlops;
+    }
+
+    G2OBatchStatistics* globalStats = G2OBatchStatistics::globalStats();
+    if (globalStats)
+      globalStats->timeSymbolicDecomposition = get_monotonic_time() - t;
+  }
+
+  /**
+   * true if supernode s has the same rows and the same descendants as the
+   * previous supernode p
+   */
+  bool sameSupernode(int s, const std::vector<Supernode>& previousSupernodes,
+                     int p, const std::vector<int>& previousRowBlocks,
+                     const std::vector<int>& previousBlockBase,
+                     const std::vector<Update>& previousUpdates) const {
+    const Supernode& sn = supernodes_[s];
+    const Supernode& prev = previousSupernodes[p];
+    if (prev.endBlock != sn.endBlock ||
+        prev.rowsEnd - prev.rowsBegin != sn.rowsEnd - sn.rowsBegin ||
+        updates_[s].size() != previousUpdates.size())
+      return false;
+    for (int i = 0; i < sn.rowsEnd - sn.rowsBegin; ++i) {
+      const int r = rowBlocks_[sn.rowsBegin + i];
+      if (r != previousRowBlocks[prev.rowsBegin + i] ||
+          blockDim(r) != previousBlockBase[r + 1] - previousBlockBase[r])
+        return false;
+    }
+    for (size_t k = 0; k < previousUpdates.size(); ++k) {
+      if (supernodes_[updates_[s][k].source].firstBlock !=
+          previousSupernodes[previousUpdates[k].source].firstBlock)
+        return false;
+    }
+    return true;
+  }
+
+  /**
+   * In incremental mode, gather the values of A of supernode s and return
+   * true if s needs to be factorized because they differ from the last
+   * factorization, the panel is not valid, or a descendant was factorized.
+   */
+  bool inputChanged(int s, Workspace& ws) {
+    bool changed = !panelValid_[s];
+    for (const Update& u : updates_[s])
+      changed = changed || refactorized_[u.source];
+    int size = 0;
+    for (const Assembly& a : assemblies_[s])
+      size += static_cast<int>(a.block->size());
+    VectorX& values = ws.values;
+    values.resize(size);
+    int offset = 0;
+    for (const Assembly& a : assemblies_[s]) {
+      const int blockSize = static_cast<int>(a.block->size());
+      values.segment(offset, blockSize) =
+          Eigen::Map<const VectorX>(a.block->data(), blockSize);
+      offset += blockSize;
+    }
+    VectorX& previous = assembledValues_[s];
+    changed = changed || previous.size() != size || previous != values;
+    if (changed) previous.swap(values);
+    return changed;
+  }
+
+  /**
+   * Assemble and factorize the panel of supernode s. Requires that all
+   * descendants of s are already factorized.
+   */
+  bool factorizeSupernode(int s, Workspace& ws) {
+    if (incremental_ && !inputChanged(s, ws)) {
+      refactorized_[s] = 0;
+      return true;
+    }
+    refactorized_[s] = 1;
+    panelValid_[s] = 0;
+    const Supernode& sn = supernodes_[s];
+    std::vector<int>& relativeRow = ws.relativeRow;
+    MatrixX& work = ws.work;
+    MatrixX& panel = panels_[s];
+    panel.setZero();
+    for (const Assembly& a : assemblies_[s]) {
+      const MatrixType& m = *a.block;
+      if (a.transposed)
+        panel.block(a.row, a.col, m.cols(), m.rows()) = m.transpose();
+      else
+        panel.block(a.row, a.col, m.rows(), m.cols()) = m;
+    }
+
+    if (!updates_[s].empty()) {
+      for (int i = sn.rowsBegin; i < sn.rowsEnd; ++i)
+        relativeRow[rowBlocks_[i]] = rowOffsets_[i];
+      for (const Update& u : updates_[s]) {
+        const Supernode& source = supernodes_[u.source];
+        const MatrixX& L = panels_[u.source];
+        const int r0 = rowOffsets_[u.rowsBegin];
+        const int r1 = rowsEndOffset(u);
+        // L(r0:end, :) * L(r0:r1, :)^T, the columns fall into this panel
+        work.noalias() = L.bottomRows(L.rows() - r0) *
+                         L.middleRows(r0, r1 - r0).transpose();
+        for (int j = u.rowsBegin; j < u.rowsEnd; ++j) {
+          const int colBlock = rowBlocks_[j];
+          const int col = relativeRow[colBlock];
+          const int workCol = rowOffsets_[j] - r0;
+          const int numCols = blockDim(colBlock);
+          for (int i = j; i < source.rowsEnd; ++i) {
+            const int rowBlock = rowBlocks_[i];
+            const int numRows = blockDim(rowBlock);
+            panel.block(relativeRow[rowBlock], col, numRows, numCols) -=
+                work.block(rowOffsets_[i] - r0, workCol, numRows, numCols);
+          }
+        }
+      }
+    }
+
+    auto diagonal = panel.topRows(sn.width);
+    Eigen::LLT<Eigen::Ref<MatrixX>> llt(diagonal);
+    if (llt.info() != Eigen::Success) return false;
+    if (panel.rows() > sn.width) {
+      auto below = panel.bottomRows(panel.rows() - sn.width);
+      diagonal.template triangularView<Eigen::Lower>()
+          .transpose()
+          .template solveInPlace<Eigen::OnTheRight>(below);
+    }
+    panelValid_[s] = 1;
+    return true;
+  }
+
+  /**
+   * forward substitution L y = b for the rows of supernode s, y is in the
+   * permuted order. Requires that the descendants of s are processed.
+   */
+  void forwardSubstitution(int s, VectorX& y, Workspace& ws) {
+    const Supernode& sn = supernodes_[s];
+    auto ys = y.segment(blockBase_[sn.firstBlock], sn.width);
+    for (const Update& u : updates_[s]) {
+      const Supernode& source = supernodes_[u.source];
+      const int r0 = rowOffsets_[u.rowsBegin];
+      ws.tmp.noalias() =
+          panels_[u.source].middleRows(r0, rowsEndOffset(u) - r0) *
+          y.segment(blockBase_[source.firstBlock], source.width);
+      for (int i = u.rowsBegin; i < u.rowsEnd; ++i) {
+        const int r = rowBlocks_[i];
+        y.segment(blockBase_[r], blockDim(r)) -=
+            ws.tmp.segment(rowOffsets_[i] - r0, blockDim(r));
+      }
+    }
+    panels_[s]
+        .topRows(sn.width)
+        .template triangularView<Eigen::Lower>()
+        .solveInPlace(ys);
+  }
+
+  /**
+   * back substitution L^T x = y for the rows of supernode s, y is in the
+   * permuted order. Requires that the ancestors of s are processed.
+   */
+  void backSubstitution(int s, VectorX& y, Workspace& ws) {
+    const Supernode& sn = supernodes_[s];
+    const MatrixX& L = panels_[s];
+    auto ys = y.segment(blockBase_[sn.firstBlock], sn.width);
+    const int below = static_cast<int>(L.rows()) - sn.width;
+    if (below > 0) {
+      ws.tmp.resize(below);
+      for (int i = sn.rowsBegin + sn.endBlock - sn.firstBlock; i < sn.rowsEnd;
+           ++i) {
+        const int r = rowBlocks_[i];
+        ws.tmp.segment(rowOffsets_[i] - sn.width, blockDim(r)) =
+            y.segment(blockBase_[r], blockDim(r));
+      }
+      ys.noalias() -= L.bottomRows(below).transpose() * ws.tmp;
+    }
+    L.topRows(sn.width)
+        .template triangularView<Eigen::Lower>()
+        .transpose()
+        .solveInPlace(ys);
+  }
+
+  //! convert the panels into the scalar CCS layout of the factor
+  void fillFactorCCS() {
+    const int n = static_cast<int>(scalarPermutation_.size());
+    Lp_.resize(n + 1);
+    Li_.resize(factorNonZeros_);
+    Lx_.resize(factorNonZeros_);
+    int nz = 0;
+    for (int s = 0; s < static_cast<int>(supernodes_.size()); ++s) {
+      const Supernode& sn = supernodes_[s];
+      const MatrixX& L = panels_[s];
+      const int base = blockBase_[sn.firstBlock];
+      for (int j = 0; j < sn.width; ++j) {
+        Lp_[base + j] = nz;
+        for (int i = j; i < sn.width; ++i) {
+          Li_[nz] = base + i;
+          Lx_[nz++] = L(i, j);
+        }
+        for (int i = sn.rowsBegin + sn.endBlock - sn.firstBlock;
+             i < sn.rowsEnd; ++i) {
+          const int r = rowBlocks_[i];
+          for (int k = 0; k < blockDim(r); ++k) {
+            Li_[nz] = blockBase_[r] + k;
+            Lx_[nz++] = L(rowOffsets_[i] + k, j);
+          }
+        }
+      }
+    }
+    Lp_[n] = nz;
+  }
+
+  /**
+   * Implementation of the general parts for computing the inverse blocks of the
+   * linear system matrix. Here we call a function to do the underlying
+   * computation.
+   */
+  bool solveBlocks_impl(const SparseBlockMatrix<MatrixType>& A,
+                        const std::function<void(MarginalCovarianceCholesky&)>&
+                            compute) override {
+    if (!factorize(A)) return false;
+    fillFactorCCS();
+    MarginalCovarianceCholesky mcc;
+    mcc.setCholeskyFactor(static_cast<int>(scalarPermutation_.size()),
+                          Lp_.data(), Li_.data(), Lx_.data(),
+                          scalarInversePermutation_.data());
+    compute(mcc);
+    return true;
+  }
+};
+
+}  // namespace g2o
+
+#endif
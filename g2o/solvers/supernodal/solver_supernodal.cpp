@@ -0,0 +1,254 @@
+// g2o - General Graph Optimization
+// Copyright (C) 2011 R. Kuemmerle, G. Grisetti, W. Burgard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <iostream>
+#include <memory>
+
+#include "g2o/core/block_solver.h"
+#include "g2o/core/optimization_algorithm_dogleg.h"
+#include "g2o/core/optimization_algorithm_factory.h"
+#include "g2o/core/optimization_algorithm_gauss_newton.h"
+#include "g2o/core/optimization_algorithm_incremental.h"
+#include "g2o/core/optimization_algorithm_levenberg.h"
+#include "g2o/core/parallel_executor.h"
+#include "g2o/core/solver.h"
+#include "g2o/core/sparse_optimizer.h"
+#include "g2o/stuff/macros.h"
+#include "linear_solver_supernodal.h"
+
+namespace g2o {
+
+namespace {
+template <int P, int L, bool Parallel>
+std::unique_ptr<BlockSolverBase> AllocateSolver(bool incremental) {
+  auto linearSolver = g2o::make_unique<
+      LinearSolverSupernodal<typename BlockSolverPL<P, L>::PoseMatrixType>>();
+  linearSolver->setIncremental(incremental);
+  if (Parallel)
+    linearSolver->setExecutor(std::make_shared<WorkStealingExecutor>());
+  std::cerr << "# Using supernodal Cholesky poseDim " << P << " landMarkDim "
+            << L << " threads "
+            << (Parallel ? linearSolver->executor()->numThreads() : 1)
+            << std::endl;
+  return g2o::make_unique<BlockSolverPL<P, L>>(std::move(linearSolver));
+}
+}  // namespace
+
+/**
+ * helper function for allocating
+ */
+static OptimizationAlgorithm* createSolver(const std::string& fullSolverName) {
+  static const std::map<std::string,
+                        std::function<std::unique_ptr<BlockSolverBase>(bool)>>
+      kSolverFactories{
+          {"var_supernodal", &AllocateSolver<-1, -1, false>},
+          {"fix3_2_supernodal", &AllocateSolver<3, 2, false>},
+          {"fix6_3_supernodal", &AllocateSolver<6, 3, false>},
+          {"fix7_3_supernodal", &AllocateSolver<7, 3, false>},
+          {"var_parallel_cholesky", &AllocateSolver<-1, -1, true>},
+          {"fix3_2_parallel_cholesky", &AllocateSolver<3, 2, true>},
+          {"fix6_3_parallel_cholesky", &AllocateSolver<6, 3, true>},
+          {"fix7_3_parallel_cholesky", &AllocateSolver<7, 3, true>},
+      };
+
+  const size_t methodEnd = fullSolverName.find('_');
+  if (methodEnd == std::string::npos) return nullptr;
+  const std::string solverName = fullSolverName.substr(methodEnd + 1);
+  auto solverf = kSolverFactories.find(solverName);
+  if (solverf == kSolverFactories.end()) return nullptr;
+
+  const std::string methodName = fullSolverName.substr(0, methodEnd);
+
+  if (methodName == "gn") {
+    return new OptimizationAlgorithmGaussNewton(solverf->second(false));
+  }
+  if (methodName == "lm") {
+    return new OptimizationAlgorithmLevenberg(solverf->second(false));
+  }
+  if (methodName == "dl") {
+    return new OptimizationAlgorithmDogleg(solverf->second(false));
+  }
+  if (methodName == "inc") {
+    return new OptimizationAlgorithmIncremental(solverf->second(true));
+  }
+
+  return nullptr;
+}
+
+class SupernodalSolverCreator : public AbstractOptimizationAlgorithmCreator {
+ public:
+  explicit SupernodalSolverCreator(const OptimizationAlgorithmProperty& p)
+      : AbstractOptimizationAlgorithmCreator(p) {}
+  std::unique_ptr<OptimizationAlgorithm> construct() override {
+    return std::unique_ptr<OptimizationAlgorithm>(
+        createSolver(property().name));
+  }
+};
+
+G2O_REGISTER_OPTIMIZATION_LIBRARY(supernodal);
+
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    gn_var_supernodal,
+    new SupernodalSolverCreator(OptimizationAlgorithmProperty(
+        "gn_var_supernodal",
+        "Gauss-Newton: supernodal block Cholesky solver (variable blocksize)",
+        "Supernodal", false, Eigen::Dynamic, Eigen::Dynamic)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    gn_fix3_2_supernodal,
+    new SupernodalSolverCreator(OptimizationAlgorithmProperty(
+        "gn_fix3_2_supernodal",
+        "Gauss-Newton: supernodal block Cholesky solver (fixed blocksize)",
+        "Supernodal", true, 3, 2)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    gn_fix6_3_supernodal,
+    new SupernodalSolverCreator(OptimizationAlgorithmProperty(
+        "gn_fix6_3_supernodal",
+        "Gauss-Newton: supernodal block Cholesky solver (fixed blocksize)",
+        "Supernodal", true, 6, 3)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    gn_fix7_3_supernodal,
+    new SupernodalSolverCreator(OptimizationAlgorithmProperty(
+        "gn_fix7_3_supernodal",
+        "Gauss-Newton: supernodal block Cholesky solver (fixed blocksize)",
+        "Supernodal", true, 7, 3)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    lm_var_supernodal,
+    new SupernodalSolverCreator(OptimizationAlgorithmProperty(
+        "lm_var_supernodal",
+        "Levenberg: supernodal block Cholesky solver (variable blocksize)",
+        "Supernodal", false, Eigen::Dynamic, Eigen::Dynamic)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    lm_fix3_2_supernodal,
+    new SupernodalSolverCreator(OptimizationAlgorithmProperty(
+        "lm_fix3_2_supernodal",
+        "Levenberg: supernodal block Cholesky solver (fixed blocksize)",
+        "Supernodal", true, 3, 2)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    lm_fix6_3_supernodal,
+    new SupernodalSolverCreator(OptimizationAlgorithmProperty(
+        "lm_fix6_3_supernodal",
+        "Levenberg: supernodal block Cholesky solver (fixed blocksize)",
+        "Supernodal", true, 6, 3)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    lm_fix7_3_supernodal,
+    new SupernodalSolverCreator(OptimizationAlgorithmProperty(
+        "lm_fix7_3_supernodal",
+        "Levenberg: supernodal block Cholesky solver (fixed blocksize)",
+        "Supernodal", true, 7, 3)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    dl_var_supernodal,
+    new SupernodalSolverCreator(OptimizationAlgorithmProperty(
+        "dl_var_supernodal",
+        "Dogleg: supernodal block Cholesky solver (variable blocksize)",
+        "Supernodal", false, Eigen::Dynamic, Eigen::Dynamic)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    inc_var_supernodal,
+    new SupernodalSolverCreator(OptimizationAlgorithmProperty(
+        "inc_var_supernodal",
+        "Incremental Gauss-Newton: supernodal block Cholesky solver updating "
+        "the factor (variable blocksize)",
+        "Supernodal", false, Eigen::Dynamic, Eigen::Dynamic)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    inc_fix3_2_supernodal,
+    new SupernodalSolverCreator(OptimizationAlgorithmProperty(
+        "inc_fix3_2_supernodal",
+        "Incremental Gauss-Newton: supernodal block Cholesky solver updating "
+        "the factor (fixed blocksize)",
+        "Supernodal", true, 3, 2)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    inc_fix6_3_supernodal,
+    new SupernodalSolverCreator(OptimizationAlgorithmProperty(
+        "inc_fix6_3_supernodal",
+        "Incremental Gauss-Newton: supernodal block Cholesky solver updating "
+        "the factor (fixed blocksize)",
+        "Supernodal", true, 6, 3)));
+
+
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    gn_var_parallel_cholesky,
+    new SupernodalSolverCreator(OptimizationAlgorithmProperty(
+        "gn_var_parallel_cholesky",
+        "Gauss-Newton: multi-threaded supernodal block Cholesky solver "
+        "(variable blocksize)",
+        "Supernodal", false, Eigen::Dynamic, Eigen::Dynamic)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    gn_fix3_2_parallel_cholesky,
+    new SupernodalSolverCreator(OptimizationAlgorithmProperty(
+        "gn_fix3_2_parallel_cholesky",
+        "Gauss-Newton: multi-threaded supernodal block Cholesky solver "
+        "(fixed blocksize)",
+        "Supernodal", true, 3, 2)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    gn_fix6_3_parallel_cholesky,
+    new SupernodalSolverCreator(OptimizationAlgorithmProperty(
+        "gn_fix6_3_parallel_cholesky",
+        "Gauss-Newton: multi-threaded supernodal block Cholesky solver "
+        "(fixed blocksize)",
+        "Supernodal", true, 6, 3)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    gn_fix7_3_parallel_cholesky,
+    new SupernodalSolverCreator(OptimizationAlgorithmProperty(
+        "gn_fix7_3_parallel_cholesky",
+        "Gauss-Newton: multi-threaded supernodal block Cholesky solver "
+        "(fixed blocksize)",
+        "Supernodal", true, 7, 3)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    lm_var_parallel_cholesky,
+    new SupernodalSolverCreator(OptimizationAlgorithmProperty(
+        "lm_var_parallel_cholesky",
+        "Levenberg: multi-threaded supernodal block Cholesky solver "
+        "(variable blocksize)",
+        "Supernodal", false, Eigen::Dynamic, Eigen::Dynamic)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    lm_fix3_2_parallel_cholesky,
+    new SupernodalSolverCreator(OptimizationAlgorithmProperty(
+        "lm_fix3_2_parallel_cholesky",
+        "Levenberg: multi-threaded supernodal block Cholesky solver "
+        "(fixed blocksize)",
+        "Supernodal", true, 3, 2)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    lm_fix6_3_parallel_cholesky,
+    new SupernodalSolverCreator(OptimizationAlgorithmProperty(
+        "lm_fix6_3_parallel_cholesky",
+        "Levenberg: multi-threaded supernodal block Cholesky solver "
+        "(fixed blocksize)",
+        "Supernodal", true, 6, 3)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    lm_fix7_3_parallel_cholesky,
+    new SupernodalSolverCreator(OptimizationAlgorithmProperty(
+        "lm_fix7_3_parallel_cholesky",
+        "Levenberg: multi-threaded supernodal block Cholesky solver "
+        "(fixed blocksize)",
+        "Supernodal", true, 7, 3)));
+G2O_REGISTER_OPTIMIZATION_ALGORITHM(
+    dl_var_parallel_cholesky,
+    new SupernodalSolverCreator(OptimizationAlgorithmProperty(
+        "dl_var_parallel_cholesky",
+        "Dogleg: multi-threaded supernodal block Cholesky solver "
+        "(variable blocksize)",
+        "Supernodal", false, Eigen::Dynamic, Eigen::Dynamic)));
+
+}  // namespace g2o
@@ -44,12 +44,19 @@
 
 #include <cstdio>
 #include <ctime>
+#include <fstream>
 #include <iostream>
 
 #if (defined(UNIX) || defined(CYGWIN)) && !defined(ANDROID)
 #include <wordexp.h>
 #endif
 
+#ifdef UNIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #ifdef __APPLE__
 //#include <chrono>
 //#include <thread>
@@ -144,4 +151,56 @@ std::vector<std::string> getFilesByPattern(const char* pattern) {
   return result;
 }
 
+bool MappedFile::open(const char* filename) {
+  close();
+#ifdef UNIX
+  const int fd = ::open(filename, O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    return false;
+  }
+  size_ = static_cast<size_t>(st.st_size);
+  if (size_ > 0) {
+    void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      posix_madvise(addr, size_, POSIX_MADV_SEQUENTIAL);
+      data_ = static_cast<const char*>(addr);
+      mapped_ = true;
+    }
+  }
+  ::close(fd);
+  if (size_ == 0 || mapped_) {
+    isOpen_ = true;
+    return true;
+  }
+#endif
+  // fall back to reading the whole file
+  std::ifstream ifs(filename, std::ios::binary);
+  if (!ifs) return false;
+  ifs.seekg(0, std::ios::end);
+  buffer_.resize(static_cast<size_t>(ifs.tellg()));
+  ifs.seekg(0, std::ios::beg);
+  if (!ifs.read(buffer_.data(), buffer_.size())) {
+    buffer_.clear();
+    return false;
+  }
+  data_ = buffer_.data();
+  size_ = buffer_.size();
+  isOpen_ = true;
+  return true;
+}
+
+void MappedFile::close() {
+#ifdef UNIX
+  if (mapped_) munmap(const_cast<char*>(data_), size_);
+#endif
+  buffer_.clear();
+  data_ = nullptr;
+  size_ = 0;
+  isOpen_ = false;
+  mapped_ = false;
+}
+
 }  // namespace g2o
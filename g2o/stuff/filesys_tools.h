@@ -91,6 +91,36 @@ G2O_STUFF_API bool fileExists(const char* filename);
  */
 G2O_STUFF_API std::vector<std::string> getFilesByPattern(const char* pattern);
 
+/**
+ * \brief read-only view on the content of a file
+ *
+ * The file is memory-mapped if the platform supports it. Otherwise, its
+ * content is read into memory.
+ */
+class G2O_STUFF_API MappedFile {
+ public:
+  MappedFile() = default;
+  explicit MappedFile(const char* filename) { open(filename); }
+  ~MappedFile() { close(); }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  //! map the file, returns false if it cannot be opened
+  bool open(const char* filename);
+  void close();
+
+  bool isOpen() const { return isOpen_; }
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ protected:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  bool isOpen_ = false;
+  bool mapped_ = false;
+  std::vector<char> buffer_;  ///< the content if the file is not mapped
+};
+
 }  // namespace g2o
 // @}
 #endif
@@ -104,6 +104,10 @@ class G2O_TYPES_SIM3_API VertexSim3Expmap : public BaseVertex<7, Sim3> {
  protected:
 };
 
+//! the camera parameters and _fix_scale are not part of the estimate
+template <>
+struct NumericDiffOnCopy<VertexSim3Expmap> : std::false_type {};
+
 /**
  * \brief 7D edge between two Vertex7
  */
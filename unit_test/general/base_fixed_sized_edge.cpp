@@ -31,6 +31,7 @@
 #include "g2o/core/base_unary_edge.h"
 #include "g2o/core/base_variable_sized_edge.h"
 #include "g2o/core/eigen_types.h"
+#include "g2o/core/parallel_executor.h"
 #include "g2o/core/robust_kernel_impl.h"
 #include "g2o/types/slam2d/vertex_point_xy.h"
 #include "g2o/types/slam2d/vertex_se2.h"
@@ -269,6 +270,48 @@ TEST(ConstantEdgeTest, ConstantEdgeLinearizeOplus) {
                        .norm());
 }
 
+TEST(ConstantEdgeTest, ConstantEdgeLinearizeOplusParallel) {
+  // the edges share their vertices, the numeric Jacobians perturb copies
+  constexpr int kNumEdges = 64;
+  EdgeTester<Edge3Constant> reference;
+  reference.edge.computeError();
+  reference.edge.linearizeOplus(reference.jacobianWorkspace);
+
+  std::vector<std::unique_ptr<Edge3Constant>> edges;
+  std::vector<g2o::JacobianWorkspace> workspaces(kNumEdges);
+  for (int k = 0; k < kNumEdges; ++k) {
+    edges.emplace_back(new Edge3Constant);
+    Edge3Constant& edge = *edges.back();
+    edge.setMeasurement(reference.edge.measurement());
+    edge.setInformation(reference.edge.information());
+    edge.setVertex(0, reference.v1);
+    edge.setVertex(1, reference.v2);
+    edge.setVertex(2, reference.v3);
+    workspaces[k].updateSize(&edge);
+    workspaces[k].allocate();
+    edge.computeError();
+  }
+  g2o::WorkStealingExecutor executor(4);
+  executor.parallelFor(kNumEdges, 1, [&](int begin, int end, int) {
+    for (int k = begin; k < end; ++k) edges[k]->linearizeOplus(workspaces[k]);
+  });
+
+  const int dimensions[] = {3, 3, 2};
+  for (int k = 0; k < kNumEdges; ++k) {
+    ASSERT_EQ(edges[k]->vertices()[0], reference.v1);
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_DOUBLE_EQ(
+          0.0, (Eigen::Map<g2o::MatrixX>(workspaces[k].workspaceForVertex(i),
+                                         2, dimensions[i]) -
+                Eigen::Map<g2o::MatrixX>(
+                    reference.jacobianWorkspace.workspaceForVertex(i), 2,
+                    dimensions[i]))
+                   .norm());
+    }
+    EXPECT_DOUBLE_EQ(0.0, (edges[k]->error() - reference.edge.error()).norm());
+  }
+}
+
 TEST(ConstantEdgeTest, ConstantEdgeConstructQuadraticForm) {
   EdgeTester<Edge3Dynamic> dynamic;
   EdgeTester<Edge3Constant> constant;
@@ -27,10 +27,16 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <cmath>
 #include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
 #include <numeric>
 
 #include "g2o/core/factory.h"
+#include "g2o/core/graph_text_parser.h"
+#include "g2o/core/graph_text_writer.h"
 #include "g2o/core/optimization_algorithm_property.h"
 #include "g2o/core/sparse_optimizer.h"
 #include "g2o/stuff/string_tools.h"
@@ -107,6 +113,102 @@ TEST(General, GraphAddEdge) {
   ASSERT_EQ(size_t(1), optimizer->edges().size());
 }
 
+TEST(General, GraphAdjacentEdges) {
+  auto optimizer = g2o::internal::createOptimizerForTests();
+
+  std::vector<std::shared_ptr<g2o::VertexSE2>> v;
+  for (int i = 0; i < 3; ++i) {
+    v.push_back(std::make_shared<g2o::VertexSE2>());
+    v.back()->setId(i);
+    ASSERT_TRUE(optimizer->addVertex(v.back()));
+  }
+  auto addEdge = [&](int from, int to) {
+    auto e = std::make_shared<g2o::EdgeSE2>();
+    e->setVertex(0, v[from]);
+    e->setVertex(1, v[to]);
+    EXPECT_TRUE(optimizer->addEdge(e));
+    return e;
+  };
+  auto e01 = addEdge(0, 1);
+  auto e12 = addEdge(1, 2);
+  EXPECT_FALSE(optimizer->addEdge(e01));
+  using testing::ElementsAre;
+  EXPECT_THAT(v[0]->adjacentEdges(), ElementsAre(e01.get()));
+  EXPECT_THAT(v[1]->adjacentEdges(), ElementsAre(e01.get(), e12.get()));
+
+  optimizer->setEdgeVertex(e12, 1, v[0]);
+  EXPECT_THAT(v[0]->adjacentEdges(), ElementsAre(e01.get(), e12.get()));
+  EXPECT_THAT(v[2]->adjacentEdges(), testing::IsEmpty());
+
+  optimizer->removeEdge(e01);
+  EXPECT_THAT(v[0]->adjacentEdges(), ElementsAre(e12.get()));
+  EXPECT_THAT(v[1]->adjacentEdges(), ElementsAre(e12.get()));
+  EXPECT_EQ(e12, e12->sharedThis());
+
+  // the vertices outlive the graph and are not connected any more
+  optimizer->clear();
+  EXPECT_THAT(v[0]->adjacentEdges(), testing::IsEmpty());
+  EXPECT_THAT(v[0]->edges(), testing::IsEmpty());
+}
+
+TEST(General, InitializeOptimizationParallel) {
+  auto optimizer = g2o::internal::createOptimizerForTests();
+  constexpr int kNumPoses = 2000;
+  for (int i = 0; i < kNumPoses; ++i) {
+    auto v = std::make_shared<g2o::VertexSE2>();
+    v->setId(i);
+    v->setFixed(i == 0);
+    optimizer->addVertex(v);
+  }
+  auto addEdge = [&](int from, int to, int level) {
+    auto e = std::make_shared<g2o::EdgeSE2>();
+    e->setVertex(0, optimizer->vertex(from));
+    e->setVertex(1, optimizer->vertex(to));
+    e->setLevel(level);
+    optimizer->addEdge(e);
+  };
+  for (int i = 1; i < kNumPoses; ++i) addEdge(i - 1, i, 0);
+  for (int i = 10; i < kNumPoses; i += 10) addEdge(i, i - 10, 1);
+  g2o::HyperGraph::VertexSet subset;
+  for (int i = 0; i < 500; ++i) subset.insert(optimizer->vertex(i));
+
+  using ActiveIds = std::pair<std::vector<int>, std::vector<int>>;
+  auto initialize = [&](int level, bool useSubset) {
+    if (useSubset) {
+      EXPECT_TRUE(optimizer->initializeOptimization(subset, level));
+    } else {
+      EXPECT_TRUE(optimizer->initializeOptimization(level));
+    }
+    ActiveIds result;
+    for (const auto& v : optimizer->activeVertices())
+      result.first.push_back(v->id());
+    for (const auto& e : optimizer->activeEdges())
+      result.second.push_back(e->vertices()[0]->id());
+    return result;
+  };
+
+  for (bool useSubset : {false, true}) {
+    for (int level : {0, 1, -1}) {
+      optimizer->setExecutor(std::make_shared<g2o::SequentialExecutor>());
+      const ActiveIds sequential = initialize(level, useSubset);
+      optimizer->setExecutor(std::make_shared<g2o::WorkStealingExecutor>(4));
+      EXPECT_EQ(sequential, initialize(level, useSubset));
+    }
+  }
+
+  optimizer->setExecutor(std::make_shared<g2o::WorkStealingExecutor>(4));
+  ActiveIds active = initialize(0, false);
+  EXPECT_THAT(active.first, testing::SizeIs(kNumPoses));
+  EXPECT_THAT(active.second, testing::SizeIs(kNumPoses - 1));
+  active = initialize(1, false);
+  EXPECT_THAT(active.first, testing::SizeIs(kNumPoses / 10));
+  EXPECT_THAT(active.second, testing::SizeIs(kNumPoses / 10 - 1));
+  active = initialize(-1, true);
+  EXPECT_THAT(active.first, testing::SizeIs(500));
+  EXPECT_THAT(active.second, testing::SizeIs(499 + 49));
+  EXPECT_TRUE(std::is_sorted(active.first.begin(), active.first.end()));
+}
+
 TEST(General, GraphAddVertexAndClear) {
   auto optimizer = g2o::internal::createOptimizerForTests();
 
@@ -318,6 +420,263 @@ TEST_F(GeneralGraphOperations, LoadingGraph) {
                   testing::AnyOfArray(expectedEdgeIds()))));
 }
 
+TEST_F(GeneralGraphOperations, BinaryRoundTrip) {
+  std::stringstream textData;
+  optimizer_->save(textData);
+  std::stringstream binaryData;
+  ASSERT_TRUE(optimizer_->saveBinary(binaryData));
+
+  optimizer_->clear();
+  ASSERT_TRUE(optimizer_->loadBinary(binaryData));
+  ASSERT_THAT(optimizer_->vertices(), testing::SizeIs(kNumVertices));
+  ASSERT_THAT(optimizer_->edges(), testing::SizeIs(kNumVertices));
+  EXPECT_THAT(fixedIds(), testing::ElementsAre(0));
+
+  // the loaded graph is saved to the same text as the original one
+  std::stringstream reloadedData;
+  optimizer_->save(reloadedData);
+  EXPECT_EQ(textData.str(), reloadedData.str());
+
+  // a file is detected as binary and memory-mapped
+  const std::string filename = "graph_operations_binary_round_trip.g2ob";
+  ASSERT_TRUE(optimizer_->saveBinary(filename.c_str()));
+  EXPECT_TRUE(g2o::OptimizableGraph::isBinaryFile(filename.c_str()));
+  optimizer_->clear();
+  ASSERT_TRUE(optimizer_->load(filename.c_str()));
+  std::remove(filename.c_str());
+  std::stringstream fileData;
+  optimizer_->save(fileData);
+  EXPECT_EQ(textData.str(), fileData.str());
+}
+
+TEST_F(GeneralGraphOperations, BinaryTruncated) {
+  std::stringstream binaryData;
+  ASSERT_TRUE(optimizer_->saveBinary(binaryData));
+  const std::string data = binaryData.str();
+  optimizer_->clear();
+  EXPECT_FALSE(optimizer_->loadBinary(data.data(), data.size() - 1));
+  EXPECT_FALSE(optimizer_->loadBinary(data.data(), 4));
+}
+
+TEST_F(GeneralGraphOperations, ParallelLoad) {
+  // a graph spanning several chunks, including numbers which are not parsed
+  // by the fast path, comments, commands and unknown types
+  std::stringstream text;
+  text << "# a comment\n\n";
+  constexpr int kNumPoses = 5000;
+  for (int i = 0; i < kNumPoses; ++i) {
+    text << "VERTEX_SE2 " << i << " " << 0.1 * i << " -" << i << "e-3 "
+         << std::setprecision(17) << std::sin(i) << std::setprecision(6)
+         << "\n";
+    if (i % 1000 == 0) text << "UNKNOWN_TYPE " << i << "\n";
+  }
+  text << "VERTEX_SE2 " << kNumPoses << " 1e-300 123456789012345678901 +.5\n";
+  text << "FIX 0 " << kNumPoses << "\n";
+  for (int i = 1; i <= kNumPoses; ++i) {
+    text << "\tEDGE_SE2 " << i - 1 << " " << i << " 1.5 -0.25 " << 1e-5 * i
+         << " 500 0 0 500 0 1e+04\r\n";
+  }
+  text << "EDGE_SE2 0 " << kNumPoses + 1 << " 0 0 0 1 0 0 1 0 1";
+  const std::string data = text.str();
+
+  std::stringstream expected;
+  optimizer_->clear();
+  ASSERT_TRUE(optimizer_->load(text));
+  optimizer_->save(expected);
+  ASSERT_THAT(optimizer_->vertices(), testing::SizeIs(kNumPoses + 1));
+  ASSERT_THAT(optimizer_->edges(), testing::SizeIs(kNumPoses));
+  const auto expectedEstimates = vertexEstimates();
+
+  for (int numThreads : {1, 4}) {
+    g2o::WorkStealingExecutor executor(numThreads);
+    optimizer_->clear();
+    ASSERT_TRUE(optimizer_->loadParallel(data.data(), data.size(), executor));
+    EXPECT_THAT(fixedIds(), testing::UnorderedElementsAre(0, kNumPoses));
+    // bitwise identical estimates and the same output
+    const auto estimates = vertexEstimates();
+    ASSERT_EQ(expectedEstimates.size(), estimates.size());
+    for (const auto& idEstimate : expectedEstimates) {
+      const g2o::Vector3& loaded = estimates.at(idEstimate.first);
+      for (int k = 0; k < 3; ++k)
+        EXPECT_EQ(idEstimate.second(k), loaded(k)) << idEstimate.first;
+    }
+    std::stringstream loaded;
+    optimizer_->save(loaded);
+    EXPECT_EQ(expected.str(), loaded.str());
+  }
+}
+
+TEST_F(GeneralGraphOperations, StreamReader) {
+  std::stringstream text;
+  text << "VERTEX_SE2 0 0 0 0\nFIX 0\n";
+  constexpr int kNumPoses = 200;
+  for (int i = 1; i <= kNumPoses; ++i) {
+    text << "VERTEX_SE2 " << i << " " << i + 0.1 << " 0.2 0\n";
+    text << "EDGE_SE2 " << i - 1 << " " << i << " 1 0 0 1 0 0 1 0 1\n";
+  }
+  text << "EDGE_SE2 0 " << kNumPoses << " " << kNumPoses << " 0 0 1 0 0 1 0 1";
+  const std::string data = text.str();
+
+  std::stringstream expected;
+  optimizer_->clear();
+  ASSERT_TRUE(optimizer_->load(text));
+  optimizer_->save(expected);
+
+  // batches smaller than a line split lines, which are carried over
+  optimizer_->clear();
+  std::istringstream is(data);
+  g2o::GraphStreamReader reader(*optimizer_, is);
+  reader.setBatchSize(50);
+  g2o::HyperGraph::VertexSet vertices;
+  g2o::HyperGraph::EdgeSet edges;
+  size_t numVertices = 0;
+  size_t numEdges = 0;
+  int numBatches = 0;
+  while (reader.next(vertices, edges)) {
+    numVertices += vertices.size();
+    numEdges += edges.size();
+    ++numBatches;
+    EXPECT_EQ(numVertices, optimizer_->vertices().size());
+    EXPECT_EQ(numEdges, optimizer_->edges().size());
+  }
+  EXPECT_TRUE(reader.atEnd());
+  EXPECT_GT(numBatches, kNumPoses);
+  EXPECT_EQ(kNumPoses + 1, static_cast<int>(numVertices));
+  EXPECT_EQ(kNumPoses + 1, static_cast<int>(numEdges));
+  EXPECT_EQ(2 * kNumPoses + 3, reader.lineNumber());
+  std::stringstream streamed;
+  optimizer_->save(streamed);
+  EXPECT_EQ(expected.str(), streamed.str());
+}
+
+TEST(General, FastNumPutFormat) {
+  auto format = [](double v) {
+    char buffer[g2o::FastNumPut::kMaxLength];
+    return std::string(buffer, g2o::FastNumPut::format(v, buffer));
+  };
+  EXPECT_EQ("0", format(0.));
+  EXPECT_EQ("-0", format(-0.));
+  EXPECT_EQ("1", format(1.));
+  EXPECT_EQ("0.1", format(0.1));
+  EXPECT_EQ("-2.5", format(-2.5));
+  EXPECT_EQ("500", format(500.));
+  EXPECT_EQ("0.30000000000000004", format(0.1 + 0.2));
+  EXPECT_EQ("1e-300", format(1e-300));
+  EXPECT_EQ("1e+20", format(1e20));
+  // all numbers read back to the same value
+  for (int i = 1; i < 10000; ++i) {
+    for (double v : {std::sin(i), std::exp(i * 0.01), 1. / i, i * 1e-7}) {
+      const std::string text = format(v);
+      EXPECT_EQ(v, std::strtod(text.c_str(), nullptr)) << text;
+    }
+  }
+}
+
+namespace {
+class VertexSE2ForFactoryTest : public g2o::VertexSE2 {};
+}  // namespace
+
+TEST(General, FactoryTypeIds) {
+  g2o::Factory* factory = g2o::Factory::instance();
+  const int vertexId = factory->typeId("VERTEX_SE2");
+  ASSERT_LE(0, vertexId);
+  ASSERT_GT(factory->numTypeIds(), vertexId);
+  EXPECT_EQ("VERTEX_SE2", factory->tag(vertexId));
+  EXPECT_EQ(g2o::HyperGraph::kHgetVertex, factory->elementType(vertexId));
+  const g2o::VertexSE2 v;
+  EXPECT_EQ(vertexId, factory->typeId(&v));
+  EXPECT_EQ(vertexId, factory->typeId(&v));  // served by the cache
+  auto constructed = factory->construct(vertexId);
+  EXPECT_NE(nullptr, dynamic_cast<g2o::VertexSE2*>(constructed.get()));
+  EXPECT_EQ(-1, factory->typeId("NOT_A_TYPE"));
+  EXPECT_EQ(nullptr, factory->construct(-1));
+  EXPECT_EQ("", factory->tag(factory->numTypeIds()));
+
+  // a new type gets the next id, which is invalid after unregistering it
+  const int numTypeIds = factory->numTypeIds();
+  factory->registerType(
+      "TEST_VERTEX",
+      std::make_unique<
+          g2o::HyperGraphElementCreator<VertexSE2ForFactoryTest>>());
+  const VertexSE2ForFactoryTest testVertex;
+  const int testId = factory->typeId("TEST_VERTEX");
+  EXPECT_EQ(numTypeIds, testId);
+  EXPECT_EQ(testId, factory->typeId(&testVertex));
+  EXPECT_EQ("TEST_VERTEX", factory->tag(&testVertex));
+  factory->unregisterType("TEST_VERTEX");
+  EXPECT_EQ(-1, factory->typeId("TEST_VERTEX"));
+  EXPECT_EQ(-1, factory->typeId(&testVertex));
+  EXPECT_EQ(nullptr, factory->construct(testId));
+  EXPECT_EQ(vertexId, factory->typeId(&v));
+}
+
+TEST_F(GeneralGraphOperations, SaveParallel) {
+  // estimates which need all digits to be represented exactly
+  for (const auto& idV : optimizer_->vertices()) {
+    auto* v = static_cast<g2o::VertexSE2*>(idV.second.get());
+    v->setEstimate(g2o::SE2(std::sin(idV.first + 1.), 1. / 3., 0.1));
+  }
+  const auto expectedEstimates = vertexEstimates();
+  std::stringstream expected;
+  optimizer_->save(expected);
+
+  g2o::WorkStealingExecutor executor(4);
+  std::stringstream text;
+  ASSERT_TRUE(optimizer_->saveParallel(text, executor));
+  optimizer_->clear();
+  ASSERT_TRUE(optimizer_->load(text));
+  EXPECT_THAT(fixedIds(), testing::ElementsAre(0));
+  EXPECT_EQ(expectedEstimates, vertexEstimates());
+  std::stringstream reloaded;
+  optimizer_->save(reloaded);
+  EXPECT_EQ(expected.str(), reloaded.str());
+}
+
+TEST_F(GeneralGraphOperations, SaveChanges) {
+  g2o::SequentialExecutor executor;
+  g2o::GraphTextWriter writer(*optimizer_);
+  std::stringstream checkpoint;
+  ASSERT_TRUE(writer.saveChanges(checkpoint, executor));
+
+  // nothing changed
+  std::stringstream unchanged;
+  ASSERT_TRUE(writer.saveChanges(unchanged, executor));
+  EXPECT_EQ("", unchanged.str());
+
+  // modify a vertex and add a vertex and an edge
+  auto v1 = std::static_pointer_cast<g2o::VertexSE2>(optimizer_->vertex(1));
+  v1->setEstimate(g2o::SE2(0.5, -0.25, 0.125));
+  auto v3 = std::make_shared<g2o::VertexSE2>();
+  v3->setId(kNumVertices);
+  v3->setEstimate(g2o::SE2(3., 0., 0.));
+  optimizer_->addVertex(v3);
+  auto e = std::make_shared<g2o::EdgeSE2>();
+  e->setVertex(0, optimizer_->vertex(2));
+  e->setVertex(1, v3);
+  e->setMeasurement(g2o::SE2(1., 0., 0.));
+  e->setInformation(g2o::EdgeSE2::InformationType::Identity());
+  optimizer_->addEdge(e);
+  const auto expectedEstimates = vertexEstimates();
+
+  std::stringstream changes;
+  ASSERT_TRUE(writer.saveChanges(changes, executor));
+  resetStream(changes);
+  EXPECT_THAT(parseVertexIds(changes), testing::ElementsAre(1, 3));
+  resetStream(changes);
+  EXPECT_THAT(parseEdgeIds(changes),
+              testing::ElementsAre(std::make_pair(2, 3)));
+
+  // apply the changes to the checkpoint
+  optimizer_->clear();
+  g2o::GraphTextParser parser(*optimizer_);
+  parser.setUpdateVertices(true);
+  const std::string data = checkpoint.str() + changes.str();
+  ASSERT_TRUE(parser.parse(data.data(), data.size(), executor));
+  EXPECT_THAT(optimizer_->vertices(), testing::SizeIs(kNumVertices + 1));
+  EXPECT_THAT(optimizer_->edges(), testing::SizeIs(kNumVertices + 1));
+  EXPECT_EQ(expectedEstimates, vertexEstimates());
+}
+
 TEST_F(GeneralGraphOperations, PushPopActiveVertices) {
   optimizer_->initializeOptimization();
   const std::map<int, g2o::Vector3> originalEstimates = vertexEstimates();
@@ -327,8 +686,9 @@ TEST_F(GeneralGraphOperations, PushPopActiveVertices) {
   for (const auto& idV : optimizer_->vertices()) {
     auto* v = dynamic_cast<g2o::VertexSE2*>(idV.second.get());
     v->setEstimate(v->estimate() * g2o::SE2(idV.first, 0, 0));
-    ASSERT_THAT(v->stackSize(), testing::Eq(1));
+    ASSERT_THAT(v->stackSize(), testing::Eq(0));
   }
+  ASSERT_THAT(optimizer_->estimateStackSize(), testing::Eq(1));
   // the estimates should differ now
   const std::map<int, g2o::Vector3> changedEstimates = vertexEstimates();
   ASSERT_THAT(originalEstimates, testing::Ne(changedEstimates));
@@ -351,8 +711,9 @@ TEST_F(GeneralGraphOperations, PushDiscardActiveVertices) {
   for (const auto& idV : optimizer_->vertices()) {
     auto* v = dynamic_cast<g2o::VertexSE2*>(idV.second.get());
     v->setEstimate(v->estimate() * g2o::SE2(idV.first, 0, 0));
-    ASSERT_THAT(v->stackSize(), testing::Eq(1));
+    ASSERT_THAT(v->stackSize(), testing::Eq(0));
   }
+  ASSERT_THAT(optimizer_->estimateStackSize(), testing::Eq(1));
   // the estimates should differ now
   const std::map<int, g2o::Vector3> changedEstimates = vertexEstimates();
   ASSERT_THAT(originalEstimates, testing::Ne(changedEstimates));
@@ -367,6 +728,32 @@ TEST_F(GeneralGraphOperations, PushDiscardActiveVertices) {
   }
 }
 
+TEST_F(GeneralGraphOperations, PushPopNestedActiveVertices) {
+  optimizer_->initializeOptimization();
+  const std::map<int, g2o::Vector3> originalEstimates = vertexEstimates();
+
+  auto transformAll = [this](number_t x) {
+    for (const auto& idV : optimizer_->vertices()) {
+      auto* v = dynamic_cast<g2o::VertexSE2*>(idV.second.get());
+      v->setEstimate(v->estimate() * g2o::SE2(x, 0, 0));
+    }
+  };
+  // the snapshots are reused after pop(), hence repeat a few times
+  for (int round = 0; round < 3; ++round) {
+    optimizer_->push();
+    transformAll(1);
+    const std::map<int, g2o::Vector3> changedEstimates = vertexEstimates();
+    optimizer_->push();
+    transformAll(2);
+    ASSERT_THAT(optimizer_->estimateStackSize(), testing::Eq(2));
+    optimizer_->pop();
+    ASSERT_THAT(vertexEstimates(), testing::Eq(changedEstimates));
+    optimizer_->pop();
+    ASSERT_THAT(vertexEstimates(), testing::Eq(originalEstimates));
+  }
+  ASSERT_THAT(optimizer_->estimateStackSize(), testing::Eq(0));
+}
+
 TEST_F(GeneralGraphOperations, PushPopOptimizableGraph) {
   const std::map<int, g2o::Vector3> originalEstimates = vertexEstimates();
 
@@ -0,0 +1,94 @@
+// g2o - General Graph Optimization
+// Copyright (C) 2011 R. Kuemmerle, G. Grisetti, W. Burgard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "g2o/core/marginal_covariance_cholesky.h"
+#include "g2o/core/parallel_executor.h"
+
+namespace {
+/**
+ * L has ones on the diagonal and -1 below, hence L^-1 is the lower triangle
+ * of ones and (L * L^T)^-1 has the entries n - max(r, c).
+ */
+struct BidiagonalFactor {
+  explicit BidiagonalFactor(int n) : n(n) {
+    for (int c = 0; c < n; ++c) {
+      Lp.push_back(static_cast<int>(Li.size()));
+      Li.push_back(c);
+      Lx.push_back(1.);
+      if (c + 1 < n) {
+        Li.push_back(c + 1);
+        Lx.push_back(-1.);
+      }
+    }
+    Lp.push_back(static_cast<int>(Li.size()));
+  }
+  int n;
+  std::vector<int> Lp;
+  std::vector<int> Li;
+  std::vector<number_t> Lx;
+};
+
+void testLargeFactor(g2o::ParallelExecutor* executor) {
+  // r * n + c of the requested entries exceeds the range of int
+  constexpr int kN = 50000;
+  BidiagonalFactor factor(kN);
+  g2o::MarginalCovarianceCholesky mcc;
+  mcc.setExecutor(executor);
+  mcc.setCholeskyFactor(kN, factor.Lp.data(), factor.Li.data(),
+                        factor.Lx.data(), nullptr);
+
+  // only the entries of the small trailing blocks have to be computed
+  const std::vector<int> rowBlockIndices = {kN - 6, kN - 3, kN};
+  const std::vector<std::pair<int, int>> blockIndices = {
+      {1, 1}, {1, 2}, {2, 2}};
+  g2o::SparseBlockMatrix<g2o::MatrixX> spinv;
+  mcc.computeCovariance(spinv, rowBlockIndices, blockIndices);
+
+  for (const auto& idx : blockIndices) {
+    const g2o::MatrixX* block = spinv.block(idx.first, idx.second);
+    ASSERT_NE(block, nullptr);
+    const int rowBase = spinv.rowBaseOfBlock(idx.first);
+    const int colBase = spinv.colBaseOfBlock(idx.second);
+    for (int r = 0; r < block->rows(); ++r)
+      for (int c = 0; c < block->cols(); ++c)
+        ASSERT_DOUBLE_EQ((*block)(r, c),
+                         kN - std::max(rowBase + r, colBase + c))
+            << "entry " << rowBase + r << " " << colBase + c;
+  }
+}
+}  // namespace
+
+TEST(MarginalCovarianceCholesky, LargeFactor) { testLargeFactor(nullptr); }
+
+TEST(MarginalCovarianceCholesky, LargeFactorParallel) {
+  g2o::WorkStealingExecutor executor(4);
+  testLargeFactor(&executor);
+}
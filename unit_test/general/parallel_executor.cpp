@@ -0,0 +1,100 @@
+// g2o - General Graph Optimization
+// Copyright (C) 2011 R. Kuemmerle, G. Grisetti, W. Burgard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "g2o/core/parallel_executor.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+TEST(General, WorkStealingExecutorCoversRange) {
+  g2o::WorkStealingExecutor executor(4);
+  ASSERT_EQ(4, executor.numThreads());
+
+  for (int n : {1, 7, 100, 10007}) {
+    std::vector<std::atomic<int>> visited(n);
+    for (auto& v : visited) v = 0;
+    std::vector<std::atomic<int>> busy(executor.numThreads());
+    for (auto& b : busy) b = 0;
+    std::atomic<bool> sharedThread{false};
+    executor.parallelFor(n, 3, [&](int begin, int end, int thread) {
+      ASSERT_LE(0, thread);
+      ASSERT_GT(executor.numThreads(), thread);
+      if (busy[thread]++ != 0) sharedThread = true;
+      for (int i = begin; i < end; ++i) ++visited[i];
+      --busy[thread];
+    });
+    EXPECT_FALSE(sharedThread);
+    for (int i = 0; i < n; ++i) EXPECT_EQ(1, visited[i]) << "index " << i;
+  }
+}
+
+TEST(General, WorkStealingExecutorNested) {
+  g2o::WorkStealingExecutor executor(3);
+  std::atomic<int> count{0};
+  executor.parallelFor(10, 1, [&](int begin, int end, int) {
+    for (int i = begin; i < end; ++i) {
+      executor.parallelFor(10, 1, [&](int innerBegin, int innerEnd, int) {
+        count += innerEnd - innerBegin;
+      });
+    }
+  });
+  EXPECT_EQ(100, count);
+}
+
+TEST(General, WorkStealingExecutorException) {
+  g2o::WorkStealingExecutor executor(2);
+  EXPECT_THROW(executor.parallelFor(1000, 1,
+                                    [](int begin, int, int) {
+                                      if (begin == 500)
+                                        throw std::runtime_error("failure");
+                                    }),
+               std::runtime_error);
+  // the pool can be used after an exception
+  std::atomic<int> count{0};
+  executor.parallelFor(1000, 1, [&](int begin, int end, int) {
+    count += end - begin;
+  });
+  EXPECT_EQ(1000, count);
+}
+
+TEST(General, AdaptiveGrain) {
+  g2o::AdaptiveGrain adaptiveGrain;
+  EXPECT_EQ(100, adaptiveGrain.grain(100, 1));
+  // unknown cost, split into several chunks per thread
+  EXPECT_EQ(100 / 16, adaptiveGrain.grain(100, 4));
+
+  // cheap items, the whole loop is below two tasks
+  adaptiveGrain.update(100, 1, 100 * 1e-9);
+  EXPECT_EQ(100, adaptiveGrain.grain(100, 4));
+
+  // expensive items, each task gets a few of them
+  g2o::AdaptiveGrain expensive;
+  expensive.update(1000, 1, 1000 * g2o::AdaptiveGrain::kTaskSeconds / 4);
+  EXPECT_NEAR(4, expensive.grain(1000, 4), 1);
+}
@@ -97,3 +97,91 @@ TEST(General, SparseBlockMatrix) {
   ASSERT_TRUE(symPermResult);
   // cerr << *PMp << endl;
 }
+
+TEST(General, SparseBlockMatrixArena) {
+  int rcol[] = {3, 6, 8, 12};
+  int ccol[] = {2, 4, 13};
+  SparseBlockMatrixX M(rcol, ccol, 4, 3);
+  ASSERT_TRUE(M.setArenaStorage(true));
+  ASSERT_TRUE(M.arenaStorage());
+
+  SparseBlockMatrixX::SparseMatrixBlock* b = M.block(3, 2, true);
+  b->setConstant(3.);
+  b = M.block(0, 0, true);
+  b->setConstant(1.);
+  b = M.block(1, 2, true);
+  b->setConstant(2.);
+  EXPECT_EQ(3u, M.arena()->size());
+  // cannot switch the storage with allocated blocks
+  EXPECT_FALSE(M.setArenaStorage(false));
+
+  // compacting keeps the content of the blocks
+  M.compactStorage();
+  EXPECT_EQ(1u, M.arena()->numSlabs());
+  EXPECT_EQ(3u, M.nonZeroBlocks());
+  EXPECT_DOUBLE_EQ(1., M.block(0, 0)->sum() / M.block(0, 0)->size());
+  EXPECT_DOUBLE_EQ(2., M.block(1, 2)->sum() / M.block(1, 2)->size());
+  EXPECT_DOUBLE_EQ(3., M.block(3, 2)->sum() / M.block(3, 2)->size());
+  // blocks are laid out column by column
+  EXPECT_LT(M.block(0, 0), M.block(1, 2));
+  EXPECT_LT(M.block(1, 2), M.block(3, 2));
+
+  auto clone = std::unique_ptr<SparseBlockMatrixX>(M.clone());
+  EXPECT_TRUE(clone->arenaStorage());
+  EXPECT_EQ(3u, clone->nonZeroBlocks());
+  EXPECT_DOUBLE_EQ(3., clone->block(3, 2)->sum() / clone->block(3, 2)->size());
+
+  // clearing recycles the memory of the arena
+  const size_t capacity = M.arena()->capacity();
+  M.clear(true);
+  EXPECT_EQ(0u, M.nonZeroBlocks());
+  EXPECT_EQ(0u, M.arena()->size());
+  EXPECT_EQ(capacity, M.arena()->capacity());
+  b = M.block(1, 0, true);
+  EXPECT_EQ(3, b->rows());
+  EXPECT_EQ(2, b->cols());
+  EXPECT_DOUBLE_EQ(0., b->squaredNorm());
+}
+
+TEST(General, SparseBlockMatrixFrozen) {
+  int rcol[] = {3, 6, 8, 12};
+  int ccol[] = {2, 4, 13};
+  SparseBlockMatrixX M(rcol, ccol, 4, 3);
+  M.block(3, 2, true)->setConstant(3.);
+  M.block(0, 0, true)->setConstant(1.);
+  M.block(1, 2, true)->setConstant(2.);
+  M.block(2, 1, true)->setConstant(4.);
+
+  g2o::VectorX src = g2o::VectorX::LinSpaced(M.cols(), 1., 2.);
+  g2o::VectorX expected = g2o::VectorX::Zero(M.rows());
+  number_t* dest = expected.data();
+  M.multiply(dest, src.data());
+  std::vector<number_t> ccsExpected(M.nonZeros());
+  M.fillCCS(ccsExpected.data());
+
+  M.freezeStructure();
+  ASSERT_TRUE(M.frozen());
+  EXPECT_EQ(4u, M.nonZeroBlocks());
+  EXPECT_EQ(nullptr, M.block(3, 0));
+  ASSERT_NE(nullptr, M.block(2, 1));
+  EXPECT_DOUBLE_EQ(4., M.block(2, 1)->sum() / M.block(2, 1)->size());
+
+  // the kernels work on the frozen pattern
+  g2o::VectorX frozenResult = g2o::VectorX::Zero(M.rows());
+  dest = frozenResult.data();
+  M.multiply(dest, src.data());
+  EXPECT_TRUE(expected.isApprox(frozenResult));
+  std::vector<number_t> ccsFrozen(M.nonZeros());
+  EXPECT_EQ(static_cast<int>(ccsFrozen.size()), M.fillCCS(ccsFrozen.data()));
+  EXPECT_EQ(ccsExpected, ccsFrozen);
+
+  // clearing without deallocation keeps the frozen pattern
+  M.clear();
+  EXPECT_TRUE(M.frozen());
+  EXPECT_DOUBLE_EQ(0., M.block(2, 1)->squaredNorm());
+
+  // changing the pattern drops the frozen arrays
+  M.block(3, 0, true);
+  EXPECT_FALSE(M.frozen());
+  EXPECT_EQ(5u, M.nonZeroBlocks());
+}
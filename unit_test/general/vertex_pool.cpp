@@ -0,0 +1,100 @@
+// g2o - General Graph Optimization
+// Copyright (C) 2011 R. Kuemmerle, G. Grisetti, W. Burgard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "g2o/core/vertex_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "g2o/core/sparse_optimizer.h"
+#include "g2o/types/slam3d/vertex_se3.h"
+
+TEST(General, VertexPoolContiguous) {
+  g2o::VertexPool<g2o::VertexSE3> pool(4);
+  std::vector<std::shared_ptr<g2o::VertexSE3>> vertices;
+  for (int i = 0; i < 10; ++i) {
+    vertices.push_back(pool.create());
+    vertices.back()->setId(i);
+  }
+  ASSERT_EQ(10, pool.size());
+  for (int i = 0; i < 10; ++i) EXPECT_EQ(vertices[i].get(), &pool[i]);
+  // within a chunk the vertices are adjacent in memory
+  EXPECT_EQ(vertices[0].get() + 1, vertices[1].get());
+  EXPECT_EQ(vertices[4].get() + 3, vertices[7].get());
+
+  int next = 0;
+  pool.forEach([&next](g2o::VertexSE3& v) { EXPECT_EQ(next++, v.id()); });
+  EXPECT_EQ(10, next);
+}
+
+TEST(General, VertexPoolOutlivedByVertices) {
+  std::shared_ptr<g2o::VertexSE3> v;
+  {
+    g2o::VertexPool<g2o::VertexSE3> pool(2);
+    pool.create();
+    v = pool.create();
+    pool.create();
+  }
+  v->setId(42);
+  EXPECT_EQ(42, v->id());
+
+  // pooled vertices are regular vertices of a graph
+  g2o::SparseOptimizer optimizer;
+  EXPECT_TRUE(optimizer.addVertex(v));
+  EXPECT_EQ(v.get(), optimizer.vertex(42).get());
+}
+
+TEST(General, VertexPoolPushPop) {
+  g2o::VertexPool<g2o::VertexSE3> pool(3);
+  for (int i = 0; i < 5; ++i) pool.create()->setId(i);
+  auto translation = [](int i) {
+    g2o::Isometry3 t = g2o::Isometry3::Identity();
+    t.translation() = g2o::Vector3(i, 2 * i, 3 * i);
+    return t;
+  };
+
+  pool.forEach([&](g2o::VertexSE3& v) { v.setEstimate(translation(v.id())); });
+  pool.push();
+  pool.forEach([&](g2o::VertexSE3& v) { v.setEstimate(translation(-1)); });
+  pool.push();
+  auto added = pool.create();
+  added->setEstimate(translation(7));
+  EXPECT_EQ(2, pool.stackSize());
+
+  pool.discardTop();
+  EXPECT_EQ(1, pool.stackSize());
+  pool.pop();
+  EXPECT_EQ(0, pool.stackSize());
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_TRUE(pool[i].estimate().isApprox(translation(i)));
+  }
+  // created after the push and hence not restored
+  EXPECT_TRUE(added->estimate().isApprox(translation(7)));
+  // the stacks of the vertices are not touched
+  EXPECT_EQ(0, pool[0].stackSize());
+}
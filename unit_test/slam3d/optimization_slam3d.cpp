@@ -24,12 +24,26 @@
 // NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <vector>
+
 #include "g2o/core/block_solver.h"
+#include "g2o/core/edge_marginal_prior.h"
 #include "g2o/core/optimization_algorithm_dogleg.h"
 #include "g2o/core/optimization_algorithm_gauss_newton.h"
+#include "g2o/core/optimization_algorithm_incremental.h"
 #include "g2o/core/optimization_algorithm_levenberg.h"
+#include "g2o/core/optimization_algorithm_with_hessian.h"
 #include "g2o/solvers/eigen/linear_solver_eigen.h"
+#include "g2o/solvers/pcg/linear_solver_pcg.h"
+#include "g2o/solvers/supernodal/linear_solver_supernodal.h"
 #include "g2o/types/slam3d/edge_se3.h"
+#include "g2o/types/slam3d/edge_se3_pointxyz.h"
+#include "g2o/types/slam3d/parameter_se3_offset.h"
+#include "g2o/types/slam3d/vertex_pointxyz.h"
 #include "gtest/gtest.h"
 
 using namespace g2o;  // NOLINT
@@ -145,3 +159,566 @@ using OptimizationAlgorithmTypes =
                      OptimizationAlgorithmDogleg>;
 INSTANTIATE_TYPED_TEST_SUITE_P(Slam3D, Slam3DOptimization,
                                OptimizationAlgorithmTypes);
+
+namespace {
+/**
+ * Creates a pose graph on a circle with odometry and loop closure edges. The
+ * estimates are perturbed to have a non-trivial optimization problem.
+ */
+void createCircleGraph(g2o::SparseOptimizer& optimizer, bool edgeColoring) {
+  auto linearSolver = g2o::make_unique<SlamLinearSolver>();
+  auto blockSolver =
+      g2o::make_unique<g2o::BlockSolverX>(std::move(linearSolver));
+  blockSolver->setEdgeColoring(edgeColoring);
+  optimizer.setAlgorithm(std::unique_ptr<g2o::OptimizationAlgorithm>(
+      new g2o::OptimizationAlgorithmLevenberg(std::move(blockSolver))));
+
+  constexpr int kNumPoses = 150;
+  const number_t stepAngle = 2 * M_PI / kNumPoses;
+  std::vector<g2o::Isometry3> poses;
+  for (int i = 0; i < kNumPoses; ++i) {
+    g2o::Isometry3 pose = g2o::Isometry3::Identity();
+    pose.rotate(g2o::AngleAxis(i * stepAngle, g2o::Vector3::UnitZ()));
+    pose.translation() << 10 * std::cos(i * stepAngle),
+        10 * std::sin(i * stepAngle), 0.;
+    poses.push_back(pose);
+
+    auto v = std::make_shared<g2o::VertexSE3>();
+    v->setId(i);
+    g2o::Isometry3 noisy = pose;
+    const g2o::Vector3 noise(std::sin(3. * i), std::cos(5. * i),
+                             std::sin(7. * i));
+    noisy.translation() += 0.1 * noise;
+    v->setEstimate(noisy);
+    v->setFixed(i == 0);
+    optimizer.addVertex(v);
+  }
+
+  auto addEdge = [&](int from, int to) {
+    auto e = std::make_shared<g2o::EdgeSE3>();
+    e->setInformation(g2o::EdgeSE3::InformationType::Identity());
+    e->setMeasurement(poses[from].inverse() * poses[to]);
+    e->vertices()[0] = optimizer.vertex(from);
+    e->vertices()[1] = optimizer.vertex(to);
+    optimizer.addEdge(e);
+  };
+  for (int i = 1; i < kNumPoses; ++i) addEdge(i - 1, i);
+  for (int i = 0; i + 10 < kNumPoses; i += 3) addEdge(i, i + 10);
+}
+}  // namespace
+
+TEST(Slam3D, EdgeColoringMatchesLockedAssembly) {
+  g2o::SparseOptimizer locked;
+  g2o::SparseOptimizer colored;
+  createCircleGraph(locked, false);
+  createCircleGraph(colored, true);
+
+  ASSERT_TRUE(locked.initializeOptimization());
+  ASSERT_TRUE(colored.initializeOptimization());
+  locked.computeActiveErrors();
+  colored.computeActiveErrors();
+  ASSERT_LT(0., colored.activeChi2());
+  EXPECT_DOUBLE_EQ(locked.activeChi2(), colored.activeChi2());
+
+  locked.optimize(10);
+  colored.optimize(10);
+  EXPECT_NEAR(locked.activeChi2(), colored.activeChi2(), 1e-9);
+  EXPECT_GT(1e-6, colored.activeChi2());
+
+  for (const auto& idv : locked.vertices()) {
+    auto lv = std::static_pointer_cast<g2o::VertexSE3>(idv.second);
+    auto cv =
+        std::static_pointer_cast<g2o::VertexSE3>(colored.vertex(idv.first));
+    EXPECT_TRUE(lv->estimate().isApprox(cv->estimate(), 1e-6));
+    // the locking needs to be restored after building the system
+    EXPECT_TRUE(cv->lockQuadraticFormEnabled());
+  }
+}
+
+TEST(Slam3D, WorkStealingExecutorMatchesSequential) {
+  for (bool edgeColoring : {false, true}) {
+    g2o::SparseOptimizer sequential;
+    g2o::SparseOptimizer threaded;
+    createCircleGraph(sequential, edgeColoring);
+    createCircleGraph(threaded, edgeColoring);
+    sequential.setExecutor(std::make_shared<g2o::SequentialExecutor>());
+    threaded.setNumThreads(4);
+    ASSERT_EQ(4, threaded.numThreads());
+
+    ASSERT_TRUE(sequential.initializeOptimization());
+    ASSERT_TRUE(threaded.initializeOptimization());
+    sequential.optimize(10);
+    threaded.optimize(10);
+    EXPECT_NEAR(sequential.activeChi2(), threaded.activeChi2(), 1e-9);
+    EXPECT_GT(1e-6, threaded.activeChi2());
+  }
+}
+
+namespace {
+/**
+ * Creates poses on a circle observing landmarks which are marginalized by
+ * the Schur complement. With implicitSchur, PCG solves the Schur complement
+ * without forming it.
+ */
+void createLandmarkGraph(g2o::SparseOptimizer& optimizer, int numThreads,
+                         bool implicitSchur = false,
+                         bool marginalizeLandmarks = true) {
+  std::unique_ptr<g2o::BlockSolverX::LinearSolverType> linearSolver;
+  if (implicitSchur) {
+    auto pcg = g2o::make_unique<
+        g2o::LinearSolverPCG<g2o::BlockSolverX::PoseMatrixType>>();
+    pcg->setTolerance(1e-16);
+    linearSolver = std::move(pcg);
+  } else {
+    linearSolver = g2o::make_unique<SlamLinearSolver>();
+  }
+  auto blockSolver =
+      g2o::make_unique<g2o::BlockSolverX>(std::move(linearSolver));
+  blockSolver->setEdgeColoring(true);
+  blockSolver->setImplicitSchur(implicitSchur);
+  optimizer.setAlgorithm(std::unique_ptr<g2o::OptimizationAlgorithm>(
+      new g2o::OptimizationAlgorithmLevenberg(std::move(blockSolver))));
+  optimizer.setNumThreads(numThreads);
+
+  auto offset = std::make_shared<g2o::ParameterSE3Offset>();
+  offset->setId(0);
+  optimizer.addParameter(offset);
+
+  constexpr int kNumPoses = 20;
+  constexpr int kNumLandmarks = 200;
+  std::vector<g2o::Isometry3> poses;
+  for (int i = 0; i < kNumPoses; ++i) {
+    const number_t angle = 2 * M_PI * i / kNumPoses;
+    g2o::Isometry3 pose = g2o::Isometry3::Identity();
+    pose.rotate(g2o::AngleAxis(angle, g2o::Vector3::UnitZ()));
+    pose.translation() << 10 * std::cos(angle), 10 * std::sin(angle), 0.;
+    poses.push_back(pose);
+
+    auto v = std::make_shared<g2o::VertexSE3>();
+    v->setId(i);
+    g2o::Isometry3 noisy = pose;
+    noisy.translation() += 0.1 * g2o::Vector3(std::sin(3. * i), 0., 0.);
+    v->setEstimate(noisy);
+    v->setFixed(i == 0);
+    optimizer.addVertex(v);
+    if (i == 0) continue;
+    auto e = std::make_shared<g2o::EdgeSE3>();
+    e->setInformation(g2o::EdgeSE3::InformationType::Identity());
+    e->setMeasurement(poses[i - 1].inverse() * poses[i]);
+    e->vertices()[0] = optimizer.vertex(i - 1);
+    e->vertices()[1] = optimizer.vertex(i);
+    optimizer.addEdge(e);
+  }
+
+  for (int j = 0; j < kNumLandmarks; ++j) {
+    const number_t angle = 2 * M_PI * j / kNumLandmarks;
+    const g2o::Vector3 point(12 * std::cos(angle), 12 * std::sin(angle),
+                             std::sin(5. * j));
+    auto l = std::make_shared<g2o::VertexPointXYZ>();
+    l->setId(kNumPoses + j);
+    l->setEstimate(point + 0.2 * g2o::Vector3(std::cos(7. * j), 0., 0.));
+    l->setMarginalized(marginalizeLandmarks);
+    optimizer.addVertex(l);
+    const int firstPose = j * kNumPoses / kNumLandmarks;
+    for (int k = 0; k < 5; ++k) {
+      const int poseIdx = (firstPose + k) % kNumPoses;
+      auto e = std::make_shared<g2o::EdgeSE3PointXYZ>();
+      e->setInformation(g2o::EdgeSE3PointXYZ::InformationType::Identity());
+      e->setMeasurement(poses[poseIdx].inverse() * point);
+      e->vertices()[0] = optimizer.vertex(poseIdx);
+      e->vertices()[1] = l;
+      e->setParameterId(0, offset->id());
+      optimizer.addEdge(e);
+    }
+  }
+}
+}  // namespace
+
+TEST(Slam3D, SchurComplementIsDeterministic) {
+  g2o::SparseOptimizer sequential;
+  g2o::SparseOptimizer threaded;
+  createLandmarkGraph(sequential, 1);
+  createLandmarkGraph(threaded, 4);
+
+  ASSERT_TRUE(sequential.initializeOptimization());
+  ASSERT_TRUE(threaded.initializeOptimization());
+  sequential.optimize(5);
+  threaded.optimize(5);
+  EXPECT_GT(1e-6, threaded.activeChi2());
+
+  // the result does not depend on the number of threads
+  EXPECT_EQ(sequential.activeChi2(), threaded.activeChi2());
+  for (const auto& idv : sequential.vertices()) {
+    auto* sv = static_cast<g2o::OptimizableGraph::Vertex*>(idv.second.get());
+    auto* tv = static_cast<g2o::OptimizableGraph::Vertex*>(
+        threaded.vertex(idv.first).get());
+    std::vector<number_t> sequentialEstimate;
+    std::vector<number_t> threadedEstimate;
+    ASSERT_TRUE(sv->getEstimateData(sequentialEstimate));
+    ASSERT_TRUE(tv->getEstimateData(threadedEstimate));
+    EXPECT_EQ(sequentialEstimate, threadedEstimate) << "vertex " << idv.first;
+  }
+}
+
+TEST(Slam3D, ImplicitSchurComplement) {
+  g2o::SparseOptimizer explicitSchur;
+  g2o::SparseOptimizer implicitSchur;
+  createLandmarkGraph(explicitSchur, 1);
+  createLandmarkGraph(implicitSchur, 4, true);
+
+  ASSERT_TRUE(explicitSchur.initializeOptimization());
+  ASSERT_TRUE(implicitSchur.initializeOptimization());
+  explicitSchur.optimize(5);
+  implicitSchur.optimize(5);
+  EXPECT_GT(1e-6, implicitSchur.activeChi2());
+
+  for (const auto& idv : explicitSchur.vertices()) {
+    auto* ev = static_cast<g2o::OptimizableGraph::Vertex*>(idv.second.get());
+    auto* iv = static_cast<g2o::OptimizableGraph::Vertex*>(
+        implicitSchur.vertex(idv.first).get());
+    std::vector<number_t> explicitEstimate;
+    std::vector<number_t> implicitEstimate;
+    ASSERT_TRUE(ev->getEstimateData(explicitEstimate));
+    ASSERT_TRUE(iv->getEstimateData(implicitEstimate));
+    ASSERT_EQ(explicitEstimate.size(), implicitEstimate.size());
+    for (size_t k = 0; k < explicitEstimate.size(); ++k)
+      EXPECT_NEAR(explicitEstimate[k], implicitEstimate[k], 1e-6)
+          << "vertex " << idv.first;
+  }
+}
+
+TEST(Slam3D, SchurComplementMarginals) {
+  g2o::SparseOptimizer schur;
+  g2o::SparseOptimizer full;
+  createLandmarkGraph(schur, 4);
+  createLandmarkGraph(full, 1, false, false);
+
+  ASSERT_TRUE(schur.initializeOptimization());
+  ASSERT_TRUE(full.initializeOptimization());
+  schur.optimize(5);
+  full.optimize(5);
+
+  // pose-pose, pose-landmark, and landmark-landmark blocks, the latter ones
+  // with and without a common pose
+  const std::vector<std::pair<int, int>> vertexPairs = {
+      {1, 1},   {3, 7},   {5, 5},   {2, 20},  {19, 219}, {4, 100},
+      {20, 20}, {20, 21}, {20, 30}, {50, 150}, {219, 219}};
+  auto hessianPairs = [&vertexPairs](const g2o::SparseOptimizer& optimizer) {
+    std::vector<std::pair<int, int>> result;
+    for (const auto& p : vertexPairs) {
+      result.emplace_back(optimizer.vertex(p.first)->hessianIndex(),
+                          optimizer.vertex(p.second)->hessianIndex());
+    }
+    return result;
+  };
+  const std::vector<std::pair<int, int>> schurIndices = hessianPairs(schur);
+  const std::vector<std::pair<int, int>> fullIndices = hessianPairs(full);
+
+  g2o::SparseBlockMatrix<g2o::MatrixX> schurMarginals;
+  g2o::SparseBlockMatrix<g2o::MatrixX> fullMarginals;
+  ASSERT_TRUE(schur.computeMarginals(schurMarginals, schurIndices));
+  ASSERT_TRUE(full.computeMarginals(fullMarginals, fullIndices));
+  for (size_t k = 0; k < vertexPairs.size(); ++k) {
+    const g2o::MatrixX* schurBlock =
+        schurMarginals.block(schurIndices[k].first, schurIndices[k].second);
+    const g2o::MatrixX* fullBlock =
+        fullMarginals.block(fullIndices[k].first, fullIndices[k].second);
+    ASSERT_NE(nullptr, schurBlock);
+    ASSERT_NE(nullptr, fullBlock);
+    ASSERT_EQ(fullBlock->rows(), schurBlock->rows());
+    ASSERT_EQ(fullBlock->cols(), schurBlock->cols());
+    EXPECT_GT(1e-5, (*fullBlock - *schurBlock).cwiseAbs().maxCoeff())
+        << "vertices " << vertexPairs[k].first << " "
+        << vertexPairs[k].second;
+  }
+}
+
+namespace {
+constexpr int kIncrementalPoses = 80;
+
+//! outcome of growing a pose graph by OptimizationAlgorithmIncremental
+struct IncrementalRun {
+  int partialSteps = 0;  ///< online steps re-factorizing a part of the factor
+  int relinearizedSteps = 0;  ///< online steps relinearizing a few vertices
+  number_t maxError = 0;      ///< largest error of a position at the end
+};
+
+/**
+ * adds the poses on a circle one by one, connected by odometry and every
+ * fifth pose by a loop closure. The new pose is initialized by the odometry
+ * with an error of the given magnitude in its position and heading.
+ */
+IncrementalRun runIncremental(int batchEveryN, number_t relinearizeThreshold,
+                              number_t initialError) {
+  using IncrementalLinearSolver =
+      g2o::LinearSolverSupernodal<g2o::BlockSolverX::PoseMatrixType>;
+  auto linearSolver = g2o::make_unique<IncrementalLinearSolver>();
+  linearSolver->setIncremental(true);
+  IncrementalLinearSolver* incrementalSolver = linearSolver.get();
+  auto algorithm = g2o::make_unique<g2o::OptimizationAlgorithmIncremental>(
+      g2o::make_unique<g2o::BlockSolverX>(std::move(linearSolver)));
+  algorithm->setBatchEveryN(batchEveryN);
+  algorithm->setRelinearizeThreshold(relinearizeThreshold);
+  g2o::OptimizationAlgorithmIncremental* incremental = algorithm.get();
+  g2o::SparseOptimizer optimizer;
+  optimizer.setAlgorithm(std::move(algorithm));
+
+  std::vector<g2o::Isometry3> poses;
+  for (int i = 0; i < kIncrementalPoses; ++i) {
+    const number_t angle = 2 * M_PI * i / kIncrementalPoses;
+    g2o::Isometry3 pose = g2o::Isometry3::Identity();
+    pose.rotate(g2o::AngleAxis(angle, g2o::Vector3::UnitZ()));
+    pose.translation() << 10 * std::cos(angle), 10 * std::sin(angle), 0.;
+    poses.push_back(pose);
+  }
+  auto createEdge = [&](int from, int to) {
+    auto e = std::make_shared<g2o::EdgeSE3>();
+    e->setInformation(g2o::EdgeSE3::InformationType::Identity());
+    e->setMeasurement(poses[from].inverse() * poses[to]);
+    e->vertices()[0] = optimizer.vertex(from);
+    e->vertices()[1] = optimizer.vertex(to);
+    return e;
+  };
+  auto createVertex = [&](int i) {
+    auto v = std::make_shared<g2o::VertexSE3>();
+    v->setId(i);
+    g2o::Isometry3 estimate = poses[i];
+    if (i > 0) {
+      auto previous =
+          std::static_pointer_cast<g2o::VertexSE3>(optimizer.vertex(i - 1));
+      estimate = previous->estimate() * poses[i - 1].inverse() * poses[i];
+      estimate.translation() +=
+          initialError * g2o::Vector3(std::sin(3. * i), 0., 0.);
+      estimate.rotate(g2o::AngleAxis(initialError * std::cos(5. * i),
+                                     g2o::Vector3::UnitZ()));
+    }
+    v->setEstimate(estimate);
+    v->setFixed(i == 0);
+    return v;
+  };
+
+  IncrementalRun run;
+  optimizer.addVertex(createVertex(0));
+  optimizer.addVertex(createVertex(1));
+  optimizer.addEdge(createEdge(0, 1));
+  EXPECT_TRUE(optimizer.initializeOptimization());
+  EXPECT_EQ(1, optimizer.optimize(1));
+
+  for (int i = 2; i < kIncrementalPoses; ++i) {
+    HyperGraph::VertexSet vertices;
+    HyperGraph::EdgeSet edges;
+    auto v = createVertex(i);
+    optimizer.addVertex(v);
+    vertices.insert(v);
+    auto addEdge = [&](int from) {
+      auto e = createEdge(from, i);
+      optimizer.addEdge(e);
+      edges.insert(e);
+    };
+    addEdge(i - 1);
+    if (i >= 10 && i % 5 == 0) addEdge(i - 10);
+    EXPECT_TRUE(optimizer.updateInitialization(vertices, edges));
+    EXPECT_EQ(1, optimizer.optimize(1, true));
+    if (incremental->lastStepWasBatch()) continue;
+    if (incrementalSolver->refactorizedSupernodes() <
+        incrementalSolver->numSupernodes())
+      ++run.partialSteps;
+    if (incremental->relinearizedVertices() > 0 &&
+        incremental->relinearizedVertices() < i)
+      ++run.relinearizedSteps;
+  }
+
+  for (int i = 0; i < kIncrementalPoses; ++i) {
+    auto v = std::static_pointer_cast<g2o::VertexSE3>(optimizer.vertex(i));
+    run.maxError = std::max(
+        run.maxError, (v->estimate().translation() - poses[i].translation())
+                          .lpNorm<Eigen::Infinity>());
+  }
+  return run;
+}
+}  // namespace
+
+TEST(Slam3D, IncrementalOptimization) {
+  const IncrementalRun run = runIncremental(25, 0.1, 0.01);
+  EXPECT_LT(kIncrementalPoses / 2, run.partialSteps);
+  EXPECT_GT(1e-3, run.maxError);
+}
+
+TEST(Slam3D, IncrementalRelinearization) {
+  // only the first step is a batch step
+  constexpr int kNoBatch = std::numeric_limits<int>::max();
+  const IncrementalRun fluid = runIncremental(kNoBatch, 0.01, 0.1);
+  EXPECT_LT(0, fluid.relinearizedSteps);
+  EXPECT_LT(kIncrementalPoses / 2, fluid.partialSteps);
+  EXPECT_GT(1e-3, fluid.maxError);
+
+  // keeping the first linearization point of each vertex
+  const IncrementalRun fixed = runIncremental(kNoBatch, 0., 0.1);
+  EXPECT_EQ(0, fixed.relinearizedSteps);
+  EXPECT_LT(1e-2, fixed.maxError);
+}
+
+namespace {
+constexpr int kWindowPoses = 10;
+
+/**
+ * a chain of poses connected by odometry and by edges skipping one pose,
+ * with noisy measurements and a perturbed initial estimate. The first pose
+ * is fixed.
+ */
+void createWindowGraph(g2o::SparseOptimizer& optimizer) {
+  auto linearSolver = g2o::make_unique<SlamLinearSolver>();
+  linearSolver->setBlockOrdering(false);
+  optimizer.setAlgorithm(
+      g2o::make_unique<g2o::OptimizationAlgorithmGaussNewton>(
+          g2o::make_unique<g2o::BlockSolverX>(std::move(linearSolver))));
+
+  std::vector<g2o::Isometry3> poses;
+  for (int i = 0; i < kWindowPoses; ++i) {
+    g2o::Isometry3 pose = g2o::Isometry3::Identity();
+    pose.rotate(g2o::AngleAxis(0.2 * i, g2o::Vector3::UnitZ()));
+    pose.translation() << i, 0.5 * std::sin(i), 0.;
+    poses.push_back(pose);
+
+    auto v = std::make_shared<g2o::VertexSE3>();
+    v->setId(i);
+    g2o::Isometry3 estimate = pose;
+    if (i > 0) {
+      estimate.translation() += 0.1 * g2o::Vector3(std::sin(3. * i),
+                                                   std::cos(2. * i), 0.);
+      estimate.rotate(
+          g2o::AngleAxis(0.05 * std::cos(5. * i), g2o::Vector3::UnitX()));
+    }
+    v->setEstimate(estimate);
+    v->setFixed(i == 0);
+    optimizer.addVertex(v);
+  }
+  for (int i = 1; i < kWindowPoses; ++i) {
+    for (int from = std::max(0, i - 2); from < i; ++from) {
+      g2o::Isometry3 measurement = poses[from].inverse() * poses[i];
+      measurement.translation() += 0.01 * g2o::Vector3(std::cos(7. * i),
+                                                       0., std::sin(from));
+      auto e = std::make_shared<g2o::EdgeSE3>();
+      e->setInformation(g2o::EdgeSE3::InformationType::Identity());
+      e->setMeasurement(measurement);
+      e->vertices()[0] = optimizer.vertex(from);
+      e->vertices()[1] = optimizer.vertex(i);
+      optimizer.addEdge(e);
+    }
+  }
+}
+}  // namespace
+
+TEST(Slam3D, MarginalizeVertices) {
+  g2o::SparseOptimizer full;
+  g2o::SparseOptimizer window;
+  createWindowGraph(full);
+  createWindowGraph(window);
+
+  // the fixed pose and two poses connected to the rest by poses 3 and 4
+  g2o::OptimizableGraph::VertexContainer marginalized;
+  for (int i = 0; i < 3; ++i)
+    marginalized.push_back(
+        std::static_pointer_cast<g2o::OptimizableGraph::Vertex>(
+            window.vertex(i)));
+  ASSERT_TRUE(window.marginalizeVertices(marginalized));
+  EXPECT_EQ(static_cast<size_t>(kWindowPoses - 3), window.vertices().size());
+  std::shared_ptr<g2o::EdgeMarginalPrior> prior;
+  for (const auto& e : window.vertex(3)->edges()) {
+    auto p = std::dynamic_pointer_cast<g2o::EdgeMarginalPrior>(e.lock());
+    if (p) prior = p;
+  }
+  ASSERT_NE(nullptr, prior);
+  ASSERT_EQ(2u, prior->vertices().size());
+  EXPECT_EQ(12, prior->dimension());
+
+  // the Schur complement yields the same Gauss-Newton step on the remaining
+  // poses as the full system
+  ASSERT_TRUE(full.initializeOptimization());
+  ASSERT_TRUE(window.initializeOptimization());
+  EXPECT_EQ(1, full.optimize(1));
+  EXPECT_EQ(1, window.optimize(1));
+  for (int i = 3; i < kWindowPoses; ++i) {
+    auto fv = std::static_pointer_cast<g2o::VertexSE3>(full.vertex(i));
+    auto wv = std::static_pointer_cast<g2o::VertexSE3>(window.vertex(i));
+    EXPECT_GT(1e-6, (fv->estimate().matrix() - wv->estimate().matrix())
+                        .cwiseAbs()
+                        .maxCoeff())
+        << "vertex " << i;
+  }
+
+  // the prior keeps its Jacobian and follows the estimate of its vertices
+  const g2o::MatrixX jacobian = prior->jacobian();
+  window.optimize(5);
+  EXPECT_EQ(jacobian, prior->jacobian());
+  EXPECT_LT(1e-6, prior->chi2());
+
+  // vertices which are not part of the graph are rejected
+  g2o::OptimizableGraph::VertexContainer foreign = {
+      std::make_shared<g2o::VertexSE3>()};
+  EXPECT_FALSE(window.marginalizeVertices(foreign));
+}
+
+TEST(Slam3D, BinaryRoundTrip) {
+  // parameters and edges referring to them
+  g2o::SparseOptimizer optimizer;
+  createLandmarkGraph(optimizer, 1);
+  std::stringstream textData;
+  optimizer.save(textData);
+  std::stringstream binaryData;
+  ASSERT_TRUE(optimizer.saveBinary(binaryData));
+
+  g2o::SparseOptimizer loaded;
+  ASSERT_TRUE(loaded.loadBinary(binaryData));
+  EXPECT_EQ(optimizer.vertices().size(), loaded.vertices().size());
+  EXPECT_EQ(optimizer.edges().size(), loaded.edges().size());
+  EXPECT_EQ(1u, loaded.parameters().size());
+  std::stringstream loadedData;
+  loaded.save(loadedData);
+  EXPECT_EQ(textData.str(), loadedData.str());
+}
+
+TEST(Slam3D, ReuseStructure) {
+  g2o::SparseOptimizer optimizer;
+  createCircleGraph(optimizer, false);
+  auto* algorithm = dynamic_cast<g2o::OptimizationAlgorithmWithHessian*>(
+      optimizer.algorithm().get());
+  ASSERT_NE(nullptr, algorithm);
+  auto& blockSolver = dynamic_cast<g2o::BlockSolverX&>(algorithm->solver());
+  EXPECT_EQ(g2o::BlockSolverBase::StructureReuse::kAuto,
+            blockSolver.structureReuse());
+
+  ASSERT_TRUE(optimizer.initializeOptimization());
+  optimizer.optimize(1);
+  EXPECT_FALSE(blockSolver.structureReused());
+
+  // same graph, same structure
+  ASSERT_TRUE(optimizer.initializeOptimization());
+  optimizer.optimize(10);
+  EXPECT_TRUE(blockSolver.structureReused());
+  EXPECT_GT(1e-6, optimizer.activeChi2());
+
+  blockSolver.forceStructureRebuild();
+  optimizer.optimize(1);
+  EXPECT_FALSE(blockSolver.structureReused());
+
+  // a new loop closure changes the structure
+  auto from = std::static_pointer_cast<g2o::VertexSE3>(optimizer.vertex(5));
+  auto to = std::static_pointer_cast<g2o::VertexSE3>(optimizer.vertex(100));
+  auto e = std::make_shared<g2o::EdgeSE3>();
+  e->setInformation(g2o::EdgeSE3::InformationType::Identity());
+  e->setMeasurement(from->estimate().inverse() * to->estimate());
+  e->vertices()[0] = from;
+  e->vertices()[1] = to;
+  optimizer.addEdge(e);
+  ASSERT_TRUE(optimizer.initializeOptimization());
+  optimizer.optimize(1);
+  EXPECT_FALSE(blockSolver.structureReused());
+  optimizer.optimize(1);
+  EXPECT_TRUE(blockSolver.structureReused());
+  EXPECT_GT(1e-6, optimizer.activeChi2());
+
+  blockSolver.setStructureReuse(g2o::BlockSolverBase::StructureReuse::kNever);
+  optimizer.optimize(1);
+  EXPECT_FALSE(blockSolver.structureReused());
+}
@@ -43,6 +43,7 @@ G2O_USE_OPTIMIZATION_LIBRARY(eigen);
 G2O_USE_OPTIMIZATION_LIBRARY(dense);
 G2O_USE_OPTIMIZATION_LIBRARY(pcg);
 G2O_USE_OPTIMIZATION_LIBRARY(structure_only);
+G2O_USE_OPTIMIZATION_LIBRARY(supernodal);
 G2O_USE_OPTIMIZATION_LIBRARY(slam2d_linear);
 
 TEST(AlgorithmFactory, ContainsBasicSolvers) {
@@ -0,0 +1,148 @@
+// g2o - General Graph Optimization
+// Copyright (C) 2011 R. Kuemmerle, G. Grisetti, W. Burgard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "g2o/core/batch_stats.h"
+#include "g2o/solvers/pcg/linear_solver_pcg.h"
+#include "gtest/gtest.h"
+
+using g2o::PCGPreconditioner;
+
+namespace {
+constexpr int kGridSize = 12;
+constexpr int kBlockDim = 3;
+
+/**
+ * Grid shaped system with a weak prior on each block, the kind of ill
+ * conditioned problem on which block Jacobi needs many iterations.
+ */
+std::unique_ptr<g2o::SparseBlockMatrixX> createGridSystem(g2o::MatrixX& H) {
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<number_t> dist(-1., 1.);
+  auto random = [&]() {
+    g2o::MatrixX m(kBlockDim, kBlockDim);
+    for (int i = 0; i < m.size(); ++i) m(i) = dist(gen);
+    return m;
+  };
+  const int numBlocks = kGridSize * kGridSize;
+  const int n = numBlocks * kBlockDim;
+  H = 1e-2 * g2o::MatrixX::Identity(n, n);
+  auto addEdge = [&](int i, int j) {
+    const g2o::MatrixX Ji = g2o::MatrixX::Identity(kBlockDim, kBlockDim) +
+                            0.2 * random();
+    const g2o::MatrixX Jj = -g2o::MatrixX::Identity(kBlockDim, kBlockDim) +
+                            0.2 * random();
+    const int bi = i * kBlockDim;
+    const int bj = j * kBlockDim;
+    H.block(bi, bi, kBlockDim, kBlockDim) += Ji.transpose() * Ji;
+    H.block(bj, bj, kBlockDim, kBlockDim) += Jj.transpose() * Jj;
+    H.block(bi, bj, kBlockDim, kBlockDim) += Ji.transpose() * Jj;
+    H.block(bj, bi, kBlockDim, kBlockDim) += Jj.transpose() * Ji;
+  };
+  for (int r = 0; r < kGridSize; ++r) {
+    for (int c = 0; c < kGridSize; ++c) {
+      const int id = r * kGridSize + c;
+      if (c + 1 < kGridSize) addEdge(id, id + 1);
+      if (r + 1 < kGridSize) addEdge(id, id + kGridSize);
+    }
+  }
+
+  std::vector<int> blockIndices(numBlocks);
+  for (int i = 0; i < numBlocks; ++i) blockIndices[i] = (i + 1) * kBlockDim;
+  auto A = g2o::make_unique<g2o::SparseBlockMatrixX>(
+      blockIndices.data(), blockIndices.data(), numBlocks, numBlocks);
+  for (int c = 0; c < numBlocks; ++c) {
+    for (int r = 0; r <= c; ++r) {
+      const auto b =
+          H.block(r * kBlockDim, c * kBlockDim, kBlockDim, kBlockDim);
+      if (b.isZero()) continue;
+      *A->block(r, c, true) = b;
+    }
+  }
+  return A;
+}
+
+//! solve with the given preconditioner and return the number of iterations
+int solveWith(PCGPreconditioner preconditioner,
+              const g2o::SparseBlockMatrixX& A, const g2o::MatrixX& H) {
+  g2o::LinearSolverPCG<g2o::MatrixX> solver;
+  solver.setPreconditioner(preconditioner);
+  solver.setTolerance(1e-20);
+  solver.setMaxIterations(static_cast<int>(H.rows()));
+
+  g2o::G2OBatchStatistics stats;
+  g2o::G2OBatchStatistics::setGlobalStats(&stats);
+  const g2o::VectorX b = g2o::VectorX::Ones(H.rows());
+  g2o::VectorX x = g2o::VectorX::Zero(H.rows());
+  const bool ok = solver.solve(A, x.data(), const_cast<number_t*>(b.data()));
+  g2o::G2OBatchStatistics::setGlobalStats(nullptr);
+
+  EXPECT_TRUE(ok);
+  const g2o::VectorX expected = H.llt().solve(b);
+  EXPECT_TRUE(x.isApprox(expected, 1e-6));
+  EXPECT_GE(stats.timePreconditioner, 0.);
+  return stats.iterationsLinearSolver;
+}
+}  // namespace
+
+TEST(LinearSolverPCG, PreconditionersSolve) {
+  g2o::MatrixX H;
+  auto A = createGridSystem(H);
+
+  const int jacobi = solveWith(PCGPreconditioner::kBlockJacobi, *A, H);
+  const int ic0 =
+      solveWith(PCGPreconditioner::kBlockIncompleteCholesky, *A, H);
+  const int ssor = solveWith(PCGPreconditioner::kBlockSSOR, *A, H);
+  const int cluster = solveWith(PCGPreconditioner::kClusterJacobi, *A, H);
+
+  EXPECT_GT(jacobi, 0);
+  EXPECT_LT(ic0, jacobi);
+  EXPECT_LT(ssor, jacobi);
+  EXPECT_LE(cluster, jacobi);
+}
+
+TEST(LinearSolverPCG, ClusterSizeOne) {
+  // clusters of a single block reduce to block Jacobi
+  g2o::MatrixX H;
+  auto A = createGridSystem(H);
+  const int jacobi = solveWith(PCGPreconditioner::kBlockJacobi, *A, H);
+
+  g2o::LinearSolverPCG<g2o::MatrixX> solver;
+  solver.setPreconditioner(PCGPreconditioner::kClusterJacobi);
+  solver.setClusterSize(1);
+  solver.setTolerance(1e-20);
+  solver.setMaxIterations(static_cast<int>(H.rows()));
+  g2o::G2OBatchStatistics stats;
+  g2o::G2OBatchStatistics::setGlobalStats(&stats);
+  const g2o::VectorX b = g2o::VectorX::Ones(H.rows());
+  g2o::VectorX x = g2o::VectorX::Zero(H.rows());
+  EXPECT_TRUE(solver.solve(*A, x.data(), const_cast<number_t*>(b.data())));
+  g2o::G2OBatchStatistics::setGlobalStats(nullptr);
+  EXPECT_EQ(jacobi, stats.iterationsLinearSolver);
+}
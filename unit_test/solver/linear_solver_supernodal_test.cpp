@@ -0,0 +1,202 @@
+// g2o - General Graph Optimization
+// Copyright (C) 2011 R. Kuemmerle, G. Grisetti, W. Burgard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "g2o/core/parallel_executor.h"
+#include "g2o/solvers/supernodal/linear_solver_supernodal.h"
+#include "gtest/gtest.h"
+
+namespace {
+constexpr int kNumBlocks = 60;
+constexpr int kBlockDim = 6;
+
+/**
+ * Pose-graph like system: a chain with some loop closures and a densely
+ * connected set of blocks at the end, which ends up in one supernode.
+ */
+g2o::MatrixX createDenseSystem() {
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> blockDist(0, kNumBlocks - 1);
+  const int n = kNumBlocks * kBlockDim;
+  g2o::MatrixX H = g2o::MatrixX::Identity(n, n);
+
+  std::vector<std::pair<int, int>> edges;
+  for (int i = 0; i + 1 < kNumBlocks; ++i) edges.emplace_back(i, i + 1);
+  for (int k = 0; k < 20; ++k)
+    edges.emplace_back(blockDist(gen), blockDist(gen));
+  for (int i = kNumBlocks - 6; i < kNumBlocks; ++i)
+    for (int j = i + 1; j < kNumBlocks; ++j) edges.emplace_back(i, j);
+
+  for (const auto& e : edges) {
+    if (e.first == e.second) continue;
+    const g2o::MatrixX Ji = g2o::MatrixX::Random(kBlockDim, kBlockDim);
+    const g2o::MatrixX Jj = g2o::MatrixX::Random(kBlockDim, kBlockDim);
+    const int bi = e.first * kBlockDim;
+    const int bj = e.second * kBlockDim;
+    H.block(bi, bi, kBlockDim, kBlockDim) += Ji.transpose() * Ji;
+    H.block(bj, bj, kBlockDim, kBlockDim) += Jj.transpose() * Jj;
+    H.block(bi, bj, kBlockDim, kBlockDim) += Ji.transpose() * Jj;
+    H.block(bj, bi, kBlockDim, kBlockDim) += Jj.transpose() * Ji;
+  }
+  return H;
+}
+
+//! copy the upper triangular non-zero blocks of the first numBlocks of H
+std::unique_ptr<g2o::SparseBlockMatrixX> createSparseMatrix(
+    const g2o::MatrixX& H, int numBlocks = kNumBlocks) {
+  std::vector<int> blockIndices(numBlocks);
+  for (int i = 0; i < numBlocks; ++i) blockIndices[i] = (i + 1) * kBlockDim;
+  auto A = g2o::make_unique<g2o::SparseBlockMatrixX>(
+      blockIndices.data(), blockIndices.data(), numBlocks, numBlocks);
+  for (int c = 0; c < numBlocks; ++c) {
+    for (int r = 0; r <= c; ++r) {
+      const auto b =
+          H.block(r * kBlockDim, c * kBlockDim, kBlockDim, kBlockDim);
+      if (b.isZero()) continue;
+      *A->block(r, c, true) = b;
+    }
+  }
+  return A;
+}
+}  // namespace
+
+TEST(LinearSolverSupernodal, SolveMatchesDense) {
+  const g2o::MatrixX H = createDenseSystem();
+  auto sparse = createSparseMatrix(H);
+  g2o::SparseBlockMatrixX& A = *sparse;
+
+  g2o::LinearSolverSupernodal<g2o::MatrixX> solver;
+  const g2o::VectorX b = g2o::VectorX::Random(H.rows());
+  g2o::VectorX x = g2o::VectorX::Zero(H.rows());
+  ASSERT_TRUE(solver.solve(A, x.data(), const_cast<number_t*>(b.data())));
+  EXPECT_LT(solver.numSupernodes(), kNumBlocks);
+  const g2o::VectorX expected = H.llt().solve(b);
+  EXPECT_TRUE(x.isApprox(expected, 1e-8));
+
+  // same pattern, new values: the symbolic factorization is re-used
+  g2o::MatrixX H2 = H;
+  H2.diagonal().array() += 10.;
+  for (int i = 0; i < kNumBlocks; ++i)
+    A.block(i, i)->diagonal().array() += 10.;
+  ASSERT_TRUE(solver.solve(A, x.data(), const_cast<number_t*>(b.data())));
+  EXPECT_TRUE(x.isApprox(H2.llt().solve(b), 1e-8));
+}
+
+TEST(LinearSolverSupernodal, MarginalsMatchDense) {
+  const g2o::MatrixX H = createDenseSystem();
+  auto sparse = createSparseMatrix(H);
+  g2o::SparseBlockMatrixX& A = *sparse;
+  const g2o::MatrixX inverse = H.inverse();
+
+  g2o::LinearSolverSupernodal<g2o::MatrixX> solver;
+  number_t** blocks = nullptr;
+  ASSERT_TRUE(solver.solveBlocks(blocks, A));
+  for (int i = 0; i < kNumBlocks; ++i) {
+    const g2o::MatrixX::MapType actual(blocks[i], kBlockDim, kBlockDim);
+    EXPECT_TRUE(actual.isApprox(
+        inverse.block(i * kBlockDim, i * kBlockDim, kBlockDim, kBlockDim),
+        1e-6))
+        << "block " << i << " differs";
+  }
+  g2o::LinearSolverSupernodal<g2o::MatrixX>::deallocateBlocks(A, blocks);
+}
+
+TEST(LinearSolverSupernodal, ParallelMatchesSequential) {
+  const g2o::MatrixX H = createDenseSystem();
+  auto sparse = createSparseMatrix(H);
+  g2o::SparseBlockMatrixX& A = *sparse;
+  const g2o::VectorX b = g2o::VectorX::Random(H.rows());
+
+  g2o::LinearSolverSupernodal<g2o::MatrixX> sequential;
+  g2o::VectorX expected = g2o::VectorX::Zero(H.rows());
+  ASSERT_TRUE(
+      sequential.solve(A, expected.data(), const_cast<number_t*>(b.data())));
+
+  g2o::LinearSolverSupernodal<g2o::MatrixX> parallel;
+  parallel.setExecutor(std::make_shared<g2o::WorkStealingExecutor>(4));
+  parallel.setMinParallelFlops(0.);
+  for (int i = 0; i < 3; ++i) {
+    g2o::VectorX x = g2o::VectorX::Zero(H.rows());
+    ASSERT_TRUE(parallel.solve(A, x.data(), const_cast<number_t*>(b.data())));
+    EXPECT_EQ(expected, x) << "differs in run " << i;
+  }
+  EXPECT_GT(parallel.numLevels(), 1);
+  EXPECT_LT(parallel.numLevels(), parallel.numSupernodes());
+}
+
+TEST(LinearSolverSupernodal, IncrementalMatchesDense) {
+  const g2o::MatrixX H = createDenseSystem();
+  const g2o::VectorX b = g2o::VectorX::Random(H.rows());
+  g2o::LinearSolverSupernodal<g2o::MatrixX> solver;
+  solver.setIncremental(true);
+
+  // the system grows by appending blocks, as done by updateInitialization()
+  for (int numBlocks = kNumBlocks - 10; numBlocks <= kNumBlocks; ++numBlocks) {
+    auto A = createSparseMatrix(H, numBlocks);
+    const int n = numBlocks * kBlockDim;
+    g2o::VectorX x = g2o::VectorX::Zero(n);
+    g2o::VectorX bn = b.head(n);
+    solver.init();
+    ASSERT_TRUE(solver.solve(*A, x.data(), bn.data()));
+    EXPECT_TRUE(x.isApprox(H.topLeftCorner(n, n).llt().solve(bn), 1e-8))
+        << "differs with " << numBlocks << " blocks";
+    if (numBlocks > kNumBlocks - 10) {
+      EXPECT_LT(solver.refactorizedSupernodes(), solver.numSupernodes());
+    }
+  }
+
+  // nothing changed, the factor is kept
+  auto A = createSparseMatrix(H);
+  g2o::VectorX x = g2o::VectorX::Zero(H.rows());
+  solver.init();
+  ASSERT_TRUE(solver.solve(*A, x.data(), const_cast<number_t*>(b.data())));
+  EXPECT_EQ(0, solver.refactorizedSupernodes());
+
+  // changing a value re-factorizes the path to the root
+  g2o::MatrixX H2 = H;
+  H2.diagonal().tail(kBlockDim).array() += 1.;
+  A->block(kNumBlocks - 1, kNumBlocks - 1)->diagonal().array() += 1.;
+  ASSERT_TRUE(solver.solve(*A, x.data(), const_cast<number_t*>(b.data())));
+  EXPECT_LT(0, solver.refactorizedSupernodes());
+  EXPECT_TRUE(x.isApprox(H2.llt().solve(b), 1e-8));
+}
+
+TEST(LinearSolverSupernodal, NotPositiveDefinite) {
+  g2o::MatrixX H = createDenseSystem();
+  H.block(0, 0, kBlockDim, kBlockDim) *= -1.;
+  auto sparse = createSparseMatrix(H);
+  g2o::SparseBlockMatrixX& A = *sparse;
+
+  g2o::LinearSolverSupernodal<g2o::MatrixX> solver;
+  solver.setWriteDebug(false);
+  g2o::VectorX b = g2o::VectorX::Ones(H.rows());
+  g2o::VectorX x = g2o::VectorX::Zero(H.rows());
+  EXPECT_FALSE(solver.solve(A, x.data(), b.data()));
+}
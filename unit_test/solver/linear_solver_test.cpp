@@ -29,6 +29,7 @@
 // clang-format on
 
 #include "g2o/solvers/eigen/linear_solver_eigen.h"
+#include "g2o/solvers/supernodal/linear_solver_supernodal.h"
 #ifdef G2O_HAVE_CSPARSE
 #include "g2o/solvers/csparse/linear_solver_csparse.h"
 #endif
@@ -119,6 +120,42 @@ TYPED_TEST_P(LS, SolvePattern) {
   }
 }
 
+TYPED_TEST_P(LS, SolvePatternParallel) {
+  this->linearsolver_->setBlockOrdering(TypeParam::second_type::kBlockOrdering);
+  g2o::WorkStealingExecutor executor(4);
+  this->linearsolver_->setMarginalsExecutor(&executor);
+
+  // all the blocks of the upper triangle
+  const int numBlocks =
+      static_cast<int>(this->sparse_matrix_.rowBlockIndices().size());
+  std::vector<std::pair<int, int> > blockIndices;
+  for (int j = 0; j < numBlocks; ++j)
+    for (int i = 0; i <= j; ++i) blockIndices.emplace_back(i, j);
+
+  g2o::SparseBlockMatrixX spinv;
+  bool state = this->linearsolver_->solvePattern(spinv, blockIndices,
+                                                this->sparse_matrix_);
+  if (!state) {
+    std::cerr << "Solver does not support solvePattern()" << std::endl;
+    SUCCEED();
+    return;
+  }
+
+  for (const auto& idx : blockIndices) {
+    int rr = spinv.rowBaseOfBlock(idx.first);
+    int cc = spinv.colBaseOfBlock(idx.second);
+    int numRows = spinv.rowsOfBlock(idx.first);
+    int numCols = spinv.colsOfBlock(idx.second);
+
+    g2o::MatrixX expected =
+        this->matrix_inverse_.block(rr, cc, numRows, numCols);
+    const g2o::MatrixX actual = *spinv.block(idx.first, idx.second);
+
+    EXPECT_TRUE(actual.isApprox(expected, 1e-6))
+        << "block " << idx.first << " " << idx.second << " differs";
+  }
+}
+
 TYPED_TEST_P(LS, SolveBlocks) {
   this->linearsolver_->setBlockOrdering(TypeParam::second_type::kBlockOrdering);
 
@@ -149,7 +186,8 @@ TYPED_TEST_P(LS, SolveBlocks) {
 }
 
 // registering the test suite and all the types to be tested
-REGISTER_TYPED_TEST_SUITE_P(LS, Solve, SolvePattern, SolveBlocks);
+REGISTER_TYPED_TEST_SUITE_P(LS, Solve, SolvePattern, SolvePatternParallel,
+                            SolveBlocks);
 
 using LinearSolverTypes = ::testing::Types<
 #ifdef G2O_HAVE_CSPARSE
@@ -161,5 +199,7 @@ using LinearSolverTypes = ::testing::Types<
     std::pair<g2o::LinearSolverCholmod<g2o::MatrixX>, BlockOrdering>,
 #endif
     std::pair<g2o::LinearSolverEigen<g2o::MatrixX>, NoBlockOrdering>,
-    std::pair<g2o::LinearSolverEigen<g2o::MatrixX>, BlockOrdering> >;
+    std::pair<g2o::LinearSolverEigen<g2o::MatrixX>, BlockOrdering>,
+    std::pair<g2o::LinearSolverSupernodal<g2o::MatrixX>, NoBlockOrdering>,
+    std::pair<g2o::LinearSolverSupernodal<g2o::MatrixX>, BlockOrdering> >;
 INSTANTIATE_TYPED_TEST_SUITE_P(LinearSolver, LS, LinearSolverTypes);